@@ -10,7 +10,9 @@ HEADERS += \
     $$PWD/qv4isel_util_p.h \
     $$PWD/qv4ssa_p.h \
     $$PWD/qqmlirbuilder_p.h \
-    $$PWD/qqmltypecompiler_p.h
+    $$PWD/qqmltypecompiler_p.h \
+    $$PWD/qv4isel_moth_p.h \
+    $$PWD/qv4instr_moth_p.h
 
 SOURCES += \
     $$PWD/qv4compileddata.cpp \
@@ -19,19 +21,17 @@ SOURCES += \
     $$PWD/qv4isel_p.cpp \
     $$PWD/qv4jsir.cpp \
     $$PWD/qv4ssa.cpp \
-    $$PWD/qqmlirbuilder.cpp
+    $$PWD/qqmlirbuilder.cpp \
+    $$PWD/qv4instr_moth.cpp \
+    $$PWD/qv4isel_moth.cpp
 
 !qmldevtools_build {
 
 HEADERS += \
-    $$PWD/qqmltypecompiler_p.h \
-    $$PWD/qv4isel_moth_p.h \
-    $$PWD/qv4instr_moth_p.h
+    $$PWD/qqmltypecompiler_p.h
 
 
 SOURCES += \
-    $$PWD/qqmltypecompiler.cpp \
-    $$PWD/qv4instr_moth.cpp \
-    $$PWD/qv4isel_moth.cpp
+    $$PWD/qqmltypecompiler.cpp
 
 }
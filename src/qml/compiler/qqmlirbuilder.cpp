@@ -242,6 +242,16 @@ void Document::collectTypeReferences()
     }
 }
 
+void Document::registerScriptBindingSources()
+{
+    foreach (Object *obj, objects) {
+        for (Binding *binding = obj->firstBinding(); binding; binding = binding->next) {
+            if (binding->type == QV4::CompiledData::Binding::Type_Script)
+                binding->stringIndex = registerString(obj->bindingAsString(this, binding->value.compiledScriptIndex));
+        }
+    }
+}
+
 void Document::removeScriptPragmas(QString &script)
 {
     const QString pragma(QLatin1String("pragma"));
@@ -1445,6 +1455,151 @@ char *QmlUnitGenerator::writeBindings(char *bindingPtr, Object *o, BindingFilter
     return bindingPtr;
 }
 
+IRLoader::IRLoader(const QV4::CompiledData::Unit *unit, Document *output)
+    : unit(unit)
+    , output(output)
+    , pool(output->jsParserEngine.pool())
+{
+}
+
+void IRLoader::load()
+{
+    // The string indices in the unit must stay valid.
+    output->jsGenerator.stringTable.clear();
+    for (uint i = 0; i < unit->stringTableSize; ++i)
+        output->jsGenerator.registerString(unit->stringAt(i));
+
+    // Copied, as the document may outlive the data of the unit.
+    for (quint32 i = 0; i < unit->nImports; ++i) {
+        QV4::CompiledData::Import *import = New<QV4::CompiledData::Import>();
+        *import = *unit->importAt(i);
+        output->imports << import;
+    }
+
+    if (unit->flags & QV4::CompiledData::Unit::IsSingleton) {
+        Pragma *pragma = New<Pragma>();
+        pragma->type = Pragma::PragmaSingleton;
+        output->pragmas << pragma;
+    }
+
+    output->indexOfRootObject = unit->indexOfRootObject;
+
+    for (quint32 i = 0; i < unit->nObjects; ++i)
+        output->objects.append(loadObject(unit->objectAt(i)));
+}
+
+Object *IRLoader::loadObject(const QV4::CompiledData::Object *serializedObject)
+{
+    Object *object = New<Object>();
+    object->init(pool, serializedObject->inheritedTypeNameIndex, serializedObject->idIndex);
+    object->indexOfDefaultProperty = serializedObject->indexOfDefaultProperty;
+    object->location = serializedObject->location;
+    object->locationOfIdProperty = serializedObject->locationOfIdProperty;
+
+    // In the unit, bindings and functions refer to run-time functions. In the document they
+    // refer to functionsAndExpressions, which runtimeFunctionIndices maps back.
+    QVector<int> functionIndices;
+    functionIndices.reserve(serializedObject->nFunctions + serializedObject->nBindings);
+
+    const QV4::CompiledData::Binding *serializedBinding = serializedObject->bindingTable();
+    for (quint32 i = 0; i < serializedObject->nBindings; ++i, ++serializedBinding) {
+        Binding *binding = New<Binding>();
+        *static_cast<QV4::CompiledData::Binding *>(binding) = *serializedBinding;
+
+        if (binding->type == QV4::CompiledData::Binding::Type_Script) {
+            functionIndices.append(binding->value.compiledScriptIndex);
+            binding->value.compiledScriptIndex = functionIndices.count() - 1;
+
+            CompiledFunctionOrExpression *foe = New<CompiledFunctionOrExpression>();
+            foe->node = scriptBindingStatement(binding->stringIndex);
+            foe->disableAcceleratedLookups = true;
+            object->functionsAndExpressions->append(foe);
+        }
+
+        object->bindings->append(binding);
+    }
+
+    const QV4::CompiledData::Property *serializedProperty = serializedObject->propertyTable();
+    for (quint32 i = 0; i < serializedObject->nProperties; ++i, ++serializedProperty) {
+        Property *property = New<Property>();
+        *static_cast<QV4::CompiledData::Property *>(property) = *serializedProperty;
+        object->properties->append(property);
+    }
+
+    for (quint32 i = 0; i < serializedObject->nSignals; ++i) {
+        const QV4::CompiledData::Signal *serializedSignal = serializedObject->signalAt(i);
+        Signal *signal = New<Signal>();
+        signal->nameIndex = serializedSignal->nameIndex;
+        signal->location = serializedSignal->location;
+        signal->parameters = New<PoolList<SignalParameter> >();
+
+        for (quint32 j = 0; j < serializedSignal->nParameters; ++j) {
+            SignalParameter *parameter = New<SignalParameter>();
+            *static_cast<QV4::CompiledData::Parameter *>(parameter) = *serializedSignal->parameterAt(j);
+            signal->parameters->append(parameter);
+        }
+
+        object->qmlSignals->append(signal);
+    }
+
+    const quint32 *functionIndex = serializedObject->functionOffsetTable();
+    for (quint32 i = 0; i < serializedObject->nFunctions; ++i, ++functionIndex) {
+        const QV4::CompiledData::Function *compiledFunction = unit->functionAt(*functionIndex);
+
+        // The property cache creator reads the name and the formals of methods from the AST.
+        QQmlJS::AST::FormalParameterList *paramList = 0;
+        const quint32 *formal = compiledFunction->formalsTable();
+        for (quint32 j = 0; j < compiledFunction->nFormals; ++j, ++formal) {
+            const QStringRef paramName = output->jsParserEngine.newStringRef(unit->stringAt(*formal));
+            if (paramList)
+                paramList = new (pool) QQmlJS::AST::FormalParameterList(paramList, paramName);
+            else
+                paramList = new (pool) QQmlJS::AST::FormalParameterList(paramName);
+        }
+        if (paramList)
+            paramList = paramList->finish();
+
+        const QStringRef name = output->jsParserEngine.newStringRef(unit->stringAt(compiledFunction->nameIndex));
+
+        Function *function = New<Function>();
+        function->functionDeclaration = new (pool) QQmlJS::AST::FunctionDeclaration(name, paramList, /*body*/0);
+        function->location = compiledFunction->location;
+        function->nameIndex = compiledFunction->nameIndex;
+
+        functionIndices.append(*functionIndex);
+        function->index = functionIndices.count() - 1;
+
+        CompiledFunctionOrExpression *foe = New<CompiledFunctionOrExpression>();
+        foe->node = function->functionDeclaration;
+        foe->nameIndex = function->nameIndex;
+        foe->disableAcceleratedLookups = true;
+        object->functionsAndExpressions->append(foe);
+
+        object->functions->append(function);
+    }
+
+    if (!functionIndices.isEmpty()) {
+        object->runtimeFunctionIndices = pool->New<FixedPoolArray<int> >();
+        object->runtimeFunctionIndices->init(pool, functionIndices);
+    }
+
+    return object;
+}
+
+// Script strings and custom parsers read the source of bindings through Object::bindingAsString(),
+// so the statement is a string literal that spans the source in the document's code.
+QQmlJS::AST::Statement *IRLoader::scriptBindingStatement(quint32 sourceIndex)
+{
+    const QString source = unit->stringAt(sourceIndex);
+    const int offset = output->code.length();
+    output->code.append(source);
+
+    QQmlJS::AST::StringLiteral *literal = new (pool) QQmlJS::AST::StringLiteral(QStringRef(&output->code, offset, source.length()));
+    literal->literalToken.offset = offset;
+    literal->literalToken.length = source.length();
+    return new (pool) QQmlJS::AST::ExpressionStatement(literal);
+}
+
 JSCodeGen::JSCodeGen(const QString &fileName, const QString &sourceCode, QV4::IR::Module *jsModule, QQmlJS::Engine *jsEngine,
                      QQmlJS::AST::UiProgram *qmlRoot, QQmlTypeNameCache *imports, const QV4::Compiler::StringTableGenerator *stringPool)
     : QQmlJS::Codegen(/*strict mode*/false)
@@ -1548,6 +1703,32 @@ QVector<int> JSCodeGen::generateJSCodeForFunctionsAndBindings(const QList<Compil
     return runtimeFunctionIndices;
 }
 
+bool JSCodeGen::generateCodeWithoutTypes(const QList<Object *> &objects)
+{
+    beginContextScope(ObjectIdMapping(), /*context object*/0);
+    beginObjectScope(/*scope object*/0);
+
+    QQmlJS::MemoryPool *pool = jsEngine->pool();
+    foreach (Object *object, objects) {
+        if (object->functionsAndExpressions->count == 0)
+            continue;
+
+        QList<CompiledFunctionOrExpression> functionsToCompile;
+        for (CompiledFunctionOrExpression *foe = object->functionsAndExpressions->first; foe; foe = foe->next) {
+            foe->disableAcceleratedLookups = true;
+            functionsToCompile << *foe;
+        }
+
+        const QVector<int> runtimeFunctionIndices = generateJSCodeForFunctionsAndBindings(functionsToCompile);
+        if (hasError)
+            return false;
+
+        object->runtimeFunctionIndices = pool->New<FixedPoolArray<int> >();
+        object->runtimeFunctionIndices->init(pool, runtimeFunctionIndices);
+    }
+    return true;
+}
+
 #ifndef V4_BOOTSTRAP
 QQmlPropertyData *JSCodeGen::lookupQmlCompliantProperty(QQmlPropertyCache *cache, const QString &name, bool *propertyExistsButForceNameLookup)
 {
@@ -1725,6 +1906,12 @@ static QV4::IR::Type resolveMetaObjectProperty(QQmlEnginePrivate *qmlEngine, QV4
             if (property->isEnum())
                 return QV4::IR::VarType;
 
+            if (member->property) {
+                const int type = property->propType;
+                member->plainLoad = property->isQObject() || type == QMetaType::Bool || type == QMetaType::Int
+                        || type == QMetaType::Double || type == QMetaType::QString;
+            }
+
             switch (property->propType) {
             case QMetaType::Bool: result = QV4::IR::BoolType; break;
             case QMetaType::Int: result = QV4::IR::SInt32Type; break;
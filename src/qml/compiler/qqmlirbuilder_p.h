@@ -324,6 +324,10 @@ struct Q_QML_PRIVATE_EXPORT Document
     QV4::CompiledData::TypeReferenceMap typeReferences;
     void collectTypeReferences();
 
+    // IRLoader cannot restore the AST, so documents that are stored as compiled units keep the
+    // source of their script bindings in the bindings' string index.
+    void registerScriptBindingSources();
+
     int registerString(const QString &str) { return jsGenerator.registerString(str); }
     QString stringAt(int index) const { return jsGenerator.stringForIndex(index); }
 
@@ -438,6 +442,27 @@ private:
     char *writeBindings(char *bindingPtr, Object *o, BindingFilter filter) const;
 };
 
+// Restores the document of a compiled QML unit, for units that were compiled ahead of time or
+// loaded from the disk cache. The AST is not restored, so the unit has to come with the code of
+// all its functions and bindings (see JSCodeGen::generateCodeWithoutTypes), and only the source
+// of script bindings is available, from registerScriptBindingSources().
+struct Q_QML_PRIVATE_EXPORT IRLoader
+{
+    IRLoader(const QV4::CompiledData::Unit *unit, Document *output);
+
+    void load();
+
+private:
+    Object *loadObject(const QV4::CompiledData::Object *serializedObject);
+    QQmlJS::AST::Statement *scriptBindingStatement(quint32 sourceIndex);
+
+    template <typename _Tp> _Tp *New() { return pool->New<_Tp>(); }
+
+    const QV4::CompiledData::Unit *unit;
+    Document *output;
+    QQmlJS::MemoryPool *pool;
+};
+
 #ifndef V4_BOOTSTRAP
 struct Q_QML_EXPORT PropertyResolver
 {
@@ -479,6 +504,10 @@ struct Q_QML_PRIVATE_EXPORT JSCodeGen : public QQmlJS::Codegen
     // Returns mapping from input functions to index in IR::Module::functions / compiledData->runtimeFunctions
     QVector<int> generateJSCodeForFunctionsAndBindings(const QList<CompiledFunctionOrExpression> &functions);
 
+    // Compiles the functions and bindings of all objects with run-time name lookups only, so the
+    // code doesn't depend on the types the document imports. Returns false on errors.
+    bool generateCodeWithoutTypes(const QList<Object *> &objects);
+
 protected:
     virtual void beginFunctionBodyHook();
     virtual QV4::IR::Expr *fallbackNameLookup(const QString &name, int line, int col);
@@ -227,7 +227,11 @@ bool QQmlTypeCompiler::compile()
     QV4::CompiledData::Unit *qmlUnit = qmlGenerator.generate(*document);
 
     Q_ASSERT(document->javaScriptCompilationUnit);
-    // The js unit owns the data and will free the qml unit.
+    // The js unit owns the data and will free the qml unit. It replaces the QML unit that
+    // precompiled code comes with, which the document was loaded from.
+    QV4::CompiledData::Unit *previousUnit = document->javaScriptCompilationUnit->data;
+    if (previousUnit && !(previousUnit->flags & QV4::CompiledData::Unit::StaticData))
+        free(previousUnit);
     document->javaScriptCompilationUnit->data = qmlUnit;
 
     compiledData->compilationUnit = document->javaScriptCompilationUnit;
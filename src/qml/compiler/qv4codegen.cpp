@@ -1404,7 +1404,14 @@ bool Codegen::visit(FieldMemberExpression *ast)
         return false;
 
     Result base = expression(ast->base);
+    // QML finds Math in the frozen global object, so Math and its properties are constants.
+    IR::Name *n = *base ? (*base)->asName() : 0;
+    const bool frozenMath = n && n->qmlLookup && *n->id == QLatin1String("Math");
+    if (frozenMath)
+        n->freeOfSideEffects = true;
     _expr.code = member(*base, _function->newString(ast->name.toString()));
+    if (frozenMath && _expr.code)
+        _expr.code->asMember()->freeOfSideEffects = true;
     return false;
 }
 
@@ -1459,7 +1466,10 @@ IR::Expr *Codegen::identifier(const QString &name, int line, int col)
         return _block->GLOBALNAME(name, line, col);
 
     // global context or with. Lookup by name
-    return _block->NAME(name, line, col);
+    IR::Name *n = _block->NAME(name, line, col);
+    if (!e->parent && (!f || !f->insideWithOrCatch) && e->compilationMode == QmlBinding)
+        n->qmlLookup = true;
+    return n;
 
 }
 
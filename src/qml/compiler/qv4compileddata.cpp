@@ -183,11 +183,35 @@ void CompilationUnit::markObjects(QV4::ExecutionEngine *e)
     }
 }
 
+bool CompilationUnit::saveCodeToDisk(QByteArray *code) const
+{
+    Q_UNUSED(code);
+    return false;
+}
+
+bool CompilationUnit::loadCodeFromDisk(ExecutionEngine *engine, const QByteArray &code)
+{
+    Q_UNUSED(engine);
+    Q_UNUSED(code);
+    return false;
+}
+
 #endif // V4_BOOTSTRAP
 
 Unit *CompilationUnit::createUnitData(QmlIR::Document *irDocument)
 {
-    return irDocument->jsGenerator.generateUnit(QV4::Compiler::JSUnitGenerator::GenerateWithoutStringTable);
+    if (!data)
+        return irDocument->jsGenerator.generateUnit(QV4::Compiler::JSUnitGenerator::GenerateWithoutStringTable);
+
+    // The code was compiled ahead of time or loaded from the disk cache, together with a QML unit
+    // (see QmlIR::IRLoader). Its JavaScript part comes first and has the same string indices as
+    // the document, so it can be reused as is.
+    const quint32 jsUnitSize = (data->flags & Unit::IsQml) ? data->offsetToImports : data->unitSize;
+    Unit *jsUnit = reinterpret_cast<Unit *>(malloc(jsUnitSize));
+    memcpy(jsUnit, data, jsUnitSize);
+    jsUnit->unitSize = jsUnitSize;
+    jsUnit->flags &= ~Unit::StaticData;
+    return jsUnit;
 }
 
 QString Binding::valueAsString(const Unit *unit) const
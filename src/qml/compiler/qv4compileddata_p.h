@@ -431,6 +431,10 @@ struct Import
     Import(): type(0), uriIndex(0), qualifierIndex(0), majorVersion(0), minorVersion(0) {}
 };
 
+// Bump this whenever the compiler data structures change in an incompatible way.
+// qmlcachegen writes the fields that are not 32-bit numbers for each target, see its UnitDataWriter.
+#define QV4_DATA_STRUCTURE_VERSION 0x01
+
 static const char magic_str[] = "qv4cdata";
 
 struct Unit
@@ -607,6 +611,11 @@ struct Q_QML_PRIVATE_EXPORT CompilationUnit : public QQmlRefCount
 
     virtual QV4::ExecutableAllocator::ChunkOfPages *chunkForFunction(int /*functionIndex*/) { return 0; }
 
+    // For the disk cache: backends that can, store their code next to the unit data and load it
+    // back into a unit created by EvalISelFactory::createUnitForLoading.
+    virtual bool saveCodeToDisk(QByteArray *code) const;
+    virtual bool loadCodeFromDisk(QV4::ExecutionEngine *engine, const QByteArray &code);
+
     void markObjects(QV4::ExecutionEngine *e);
 
 protected:
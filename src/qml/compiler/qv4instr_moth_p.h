@@ -93,6 +93,7 @@ QT_BEGIN_NAMESPACE
     F(CallBuiltinDefineObjectLiteral, callBuiltinDefineObjectLiteral) \
     F(CallBuiltinSetupArgumentsObject, callBuiltinSetupArgumentsObject) \
     F(CallBuiltinConvertThisToObject, callBuiltinConvertThisToObject) \
+    F(CallBuiltinIsClosure, callBuiltinIsClosure) \
     F(CreateValue, createValue) \
     F(CreateProperty, createProperty) \
     F(ConstructPropertyLookup, constructPropertyLookup) \
@@ -101,6 +102,8 @@ QT_BEGIN_NAMESPACE
     F(Jump, jump) \
     F(JumpEq, jumpEq) \
     F(JumpNe, jumpNe) \
+    F(CompareJumpEq, compareJump) \
+    F(CompareJumpNe, compareJump) \
     F(UNot, unot) \
     F(UNotBool, unotBool) \
     F(UPlus, uplus) \
@@ -131,7 +134,8 @@ QT_BEGIN_NAMESPACE
     F(LoadQmlScopeObject, loadQmlScopeObject) \
     F(LoadQmlSingleton, loadQmlSingleton)
 
-#if defined(Q_CC_GNU) && (!defined(Q_CC_INTEL) || __INTEL_COMPILER >= 1200)
+// The host tools only generate code for qmlcachegen, which stores it in its portable form.
+#if defined(Q_CC_GNU) && (!defined(Q_CC_INTEL) || __INTEL_COMPILER >= 1200) && !defined(V4_BOOTSTRAP)
 #  define MOTH_THREADED_INTERPRETER
 #endif
 
@@ -159,8 +163,13 @@ struct Param {
     // Arg(outer): 4
     // Local(outer): 5
     // ...
-    unsigned scope;
-    unsigned index;
+    // Scope and index share one 32 bit word, which keeps the instructions small.
+    enum {
+        ScopeBits = 10,
+        IndexBits = 22
+    };
+    unsigned scope : ScopeBits;
+    unsigned index : IndexBits;
 
     bool isConstant() const { return !scope; }
     bool isArgument() const { return scope >= 2 && !(scope &1); }
@@ -173,6 +182,7 @@ struct Param {
         Param p;
         p.scope = 0;
         p.index = index;
+        Q_ASSERT(p.index == unsigned(index));
         return p;
     }
 
@@ -181,6 +191,7 @@ struct Param {
         Param p;
         p.scope = 2 + 2*scope;
         p.index = idx;
+        Q_ASSERT(p.scope == 2 + 2*scope && p.index == idx);
         return p;
     }
 
@@ -189,6 +200,7 @@ struct Param {
         Param p;
         p.scope = 3;
         p.index = idx;
+        Q_ASSERT(p.index == idx);
         return p;
     }
 
@@ -197,6 +209,7 @@ struct Param {
         Param p;
         p.scope = 1;
         p.index = idx;
+        Q_ASSERT(p.index == idx);
         return p;
     }
 
@@ -205,6 +218,7 @@ struct Param {
         Param p;
         p.scope = 3 + 2*scope;
         p.index = idx;
+        Q_ASSERT(p.scope == 3 + 2*scope && p.index == idx);
         return p;
     }
 
@@ -214,7 +228,10 @@ struct Param {
     inline bool operator!=(const Param &other) const
     { return !(*this == other); }
 };
+Q_STATIC_ASSERT(sizeof(Param) == sizeof(quint32));
 
+// When changing the fields of an instruction, update its description for the portable form of the
+// code in qv4isel_moth.cpp.
 union Instr
 {
     enum Type {
@@ -497,6 +514,13 @@ union Instr
     struct instr_callBuiltinConvertThisToObject {
         MOTH_INSTR_HEADER
     };
+    struct instr_callBuiltinIsClosure {
+        MOTH_INSTR_HEADER
+        Param value;
+        int functionIndex;
+        int scopeDepth;
+        Param result;
+    };
     struct instr_createValue {
         MOTH_INSTR_HEADER
         quint32 argc;
@@ -548,6 +572,14 @@ union Instr
         ptrdiff_t offset;
         Param condition;
     };
+    // Superinstruction for a comparison followed by JumpEq/JumpNe on its result.
+    struct instr_compareJump {
+        MOTH_INSTR_HEADER
+        ptrdiff_t offset;
+        QV4::Runtime::CompareOperation cmp;
+        Param lhs;
+        Param rhs;
+    };
     struct instr_unot {
         MOTH_INSTR_HEADER
         Param source;
@@ -757,6 +789,7 @@ union Instr
     instr_callBuiltinDefineObjectLiteral callBuiltinDefineObjectLiteral;
     instr_callBuiltinSetupArgumentsObject callBuiltinSetupArgumentsObject;
     instr_callBuiltinConvertThisToObject callBuiltinConvertThisToObject;
+    instr_callBuiltinIsClosure callBuiltinIsClosure;
     instr_createValue createValue;
     instr_createProperty createProperty;
     instr_constructPropertyLookup constructPropertyLookup;
@@ -765,6 +798,7 @@ union Instr
     instr_jump jump;
     instr_jumpEq jumpEq;
     instr_jumpNe jumpNe;
+    instr_compareJump compareJump;
     instr_unot unot;
     instr_unotBool unotBool;
     instr_uplus uplus;
@@ -33,13 +33,15 @@
 
 #include "qv4isel_util_p.h"
 #include "qv4isel_moth_p.h"
-#include "qv4vme_moth_p.h"
 #include "qv4ssa_p.h"
+#include <private/qv4compileddata_p.h>
+#ifndef V4_BOOTSTRAP
+#include "qv4vme_moth_p.h"
 #include <private/qv4debugging_p.h>
 #include <private/qv4function_p.h>
 #include <private/qv4regexpobject_p.h>
-#include <private/qv4compileddata_p.h>
 #include <private/qqmlengine_p.h>
+#endif
 
 #undef USE_TYPE_INFO
 
@@ -115,6 +117,46 @@ inline QV4::Runtime::BinaryOperation aluOpFunction(IR::AluOp op)
     }
 };
 
+// Binary operations that need the execution context.
+inline QV4::Runtime::BinaryOperationContext contextAluOpFunction(IR::AluOp op)
+{
+    switch (op) {
+    case IR::OpInstanceof:
+        return QV4::Runtime::instanceof;
+    case IR::OpIn:
+        return QV4::Runtime::in;
+    case IR::OpAdd:
+        return QV4::Runtime::add;
+    default:
+        return 0;
+    }
+}
+
+// Comparisons that can be fused with the conditional jump that consumes their result.
+inline QV4::Runtime::CompareOperation compareOpFunction(IR::AluOp op)
+{
+    switch (op) {
+    case IR::OpGt:
+        return QV4::Runtime::compareGreaterThan;
+    case IR::OpLt:
+        return QV4::Runtime::compareLessThan;
+    case IR::OpGe:
+        return QV4::Runtime::compareGreaterEqual;
+    case IR::OpLe:
+        return QV4::Runtime::compareLessEqual;
+    case IR::OpEqual:
+        return QV4::Runtime::compareEqual;
+    case IR::OpNotEqual:
+        return QV4::Runtime::compareNotEqual;
+    case IR::OpStrictEqual:
+        return QV4::Runtime::compareStrictEqual;
+    case IR::OpStrictNotEqual:
+        return QV4::Runtime::compareStrictNotEqual;
+    default:
+        return 0;
+    }
+}
+
 inline bool isNumberType(IR::Expr *e)
 {
     switch (e->type) {
@@ -304,6 +346,814 @@ protected:
 #endif // defined(QT_NO_DEBUG)
     }
 };
+
+#define MOTH_COUNT_INSTR(I, FMT) + 1
+enum { InstructionTypeCount = 0 FOR_EACH_MOTH_INSTR(MOTH_COUNT_INSTR) };
+#undef MOTH_COUNT_INSTR
+
+// The portable form of the code is what qmlcachegen generates on the build host and what the disk
+// cache stores, so it must not depend on the machine: the layout of the instructions depends on
+// the pointer size and the byte order, and they refer to instruction handlers and runtime
+// functions by address. It is a sequence of 32-bit words: a header, then for each function the
+// number of words of its code and that code. An instruction is its type followed by its fields in
+// the order of their declaration, one word each except for values. Jumps hold the index of the
+// word their target starts at, operations the number of their IR::AluOp, and values a kind and a
+// payload of two words, as the encoding of QV4::Value depends on the pointer size.
+static const quint32 portableCodeMagic = 0x68746f6d; // "moth"
+
+struct PortableCodeHeader {
+    quint32 magic;
+    quint32 instructionTypeCount;
+    quint32 functionCount;
+};
+enum { PortableCodeHeaderSize = sizeof(PortableCodeHeader) / sizeof(quint32) };
+
+// Used for the exception handler that is not set.
+static const quint32 noJumpTarget = ~0u;
+
+enum PortableFieldKind {
+    EndOfFields,
+    WordField,
+    ParamField,
+    BoolField,
+    JumpField,
+    ValueField,
+    BinaryOperationField,
+    ContextOperationField,
+    CompareOperationField
+};
+
+enum PortableValueKind {
+    UndefinedValue,
+    NullValue,
+    BooleanValue,
+    IntegerValue,
+    DoubleValue
+};
+
+struct PortableField {
+    quint16 offset; // in the instruction
+    quint16 kind;
+};
+
+#define MOTH_FIELD(FMT, field, kind) { quint16(offsetof(Instr::instr_##FMT, field)), kind##Field }
+#define MOTH_FIELDS_END { 0, EndOfFields }
+
+const PortableField fields_ret[] = { MOTH_FIELD(ret, result, Param), MOTH_FIELDS_END };
+const PortableField fields_line[] = { MOTH_FIELD(line, lineNumber, Word), MOTH_FIELDS_END };
+const PortableField fields_debug[] = { MOTH_FIELD(debug, lineNumber, Word), MOTH_FIELDS_END };
+const PortableField fields_loadRuntimeString[] = {
+    MOTH_FIELD(loadRuntimeString, stringId, Word),
+    MOTH_FIELD(loadRuntimeString, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadRegExp[] = {
+    MOTH_FIELD(loadRegExp, regExpId, Word),
+    MOTH_FIELD(loadRegExp, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadClosure[] = {
+    MOTH_FIELD(loadClosure, value, Word),
+    MOTH_FIELD(loadClosure, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_move[] = {
+    MOTH_FIELD(move, source, Param),
+    MOTH_FIELD(move, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_moveConst[] = {
+    MOTH_FIELD(moveConst, source, Value),
+    MOTH_FIELD(moveConst, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_swapTemps[] = {
+    MOTH_FIELD(swapTemps, left, Param),
+    MOTH_FIELD(swapTemps, right, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadName[] = {
+    MOTH_FIELD(loadName, name, Word),
+    MOTH_FIELD(loadName, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_getGlobalLookup[] = {
+    MOTH_FIELD(getGlobalLookup, index, Word),
+    MOTH_FIELD(getGlobalLookup, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_storeName[] = {
+    MOTH_FIELD(storeName, name, Word),
+    MOTH_FIELD(storeName, source, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadElement[] = {
+    MOTH_FIELD(loadElement, base, Param),
+    MOTH_FIELD(loadElement, index, Param),
+    MOTH_FIELD(loadElement, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadElementLookup[] = {
+    MOTH_FIELD(loadElementLookup, lookup, Word),
+    MOTH_FIELD(loadElementLookup, base, Param),
+    MOTH_FIELD(loadElementLookup, index, Param),
+    MOTH_FIELD(loadElementLookup, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_storeElement[] = {
+    MOTH_FIELD(storeElement, base, Param),
+    MOTH_FIELD(storeElement, index, Param),
+    MOTH_FIELD(storeElement, source, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_storeElementLookup[] = {
+    MOTH_FIELD(storeElementLookup, lookup, Word),
+    MOTH_FIELD(storeElementLookup, base, Param),
+    MOTH_FIELD(storeElementLookup, index, Param),
+    MOTH_FIELD(storeElementLookup, source, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadProperty[] = {
+    MOTH_FIELD(loadProperty, name, Word),
+    MOTH_FIELD(loadProperty, base, Param),
+    MOTH_FIELD(loadProperty, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_getLookup[] = {
+    MOTH_FIELD(getLookup, index, Word),
+    MOTH_FIELD(getLookup, base, Param),
+    MOTH_FIELD(getLookup, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_storeProperty[] = {
+    MOTH_FIELD(storeProperty, name, Word),
+    MOTH_FIELD(storeProperty, base, Param),
+    MOTH_FIELD(storeProperty, source, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_setLookup[] = {
+    MOTH_FIELD(setLookup, index, Word),
+    MOTH_FIELD(setLookup, base, Param),
+    MOTH_FIELD(setLookup, source, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_storeQObjectProperty[] = {
+    MOTH_FIELD(storeQObjectProperty, base, Param),
+    MOTH_FIELD(storeQObjectProperty, propertyIndex, Word),
+    MOTH_FIELD(storeQObjectProperty, source, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadQObjectProperty[] = {
+    MOTH_FIELD(loadQObjectProperty, propertyIndex, Word),
+    MOTH_FIELD(loadQObjectProperty, base, Param),
+    MOTH_FIELD(loadQObjectProperty, result, Param),
+    MOTH_FIELD(loadQObjectProperty, captureRequired, Bool),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadAttachedQObjectProperty[] = {
+    MOTH_FIELD(loadAttachedQObjectProperty, propertyIndex, Word),
+    MOTH_FIELD(loadAttachedQObjectProperty, result, Param),
+    MOTH_FIELD(loadAttachedQObjectProperty, attachedPropertiesId, Word),
+    MOTH_FIELDS_END
+};
+const PortableField fields_push[] = { MOTH_FIELD(push, value, Word), MOTH_FIELDS_END };
+const PortableField fields_callValue[] = {
+    MOTH_FIELD(callValue, argc, Word),
+    MOTH_FIELD(callValue, callData, Word),
+    MOTH_FIELD(callValue, dest, Param),
+    MOTH_FIELD(callValue, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callProperty[] = {
+    MOTH_FIELD(callProperty, name, Word),
+    MOTH_FIELD(callProperty, argc, Word),
+    MOTH_FIELD(callProperty, callData, Word),
+    MOTH_FIELD(callProperty, base, Param),
+    MOTH_FIELD(callProperty, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callPropertyLookup[] = {
+    MOTH_FIELD(callPropertyLookup, lookupIndex, Word),
+    MOTH_FIELD(callPropertyLookup, argc, Word),
+    MOTH_FIELD(callPropertyLookup, callData, Word),
+    MOTH_FIELD(callPropertyLookup, base, Param),
+    MOTH_FIELD(callPropertyLookup, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callElement[] = {
+    MOTH_FIELD(callElement, base, Param),
+    MOTH_FIELD(callElement, index, Param),
+    MOTH_FIELD(callElement, argc, Word),
+    MOTH_FIELD(callElement, callData, Word),
+    MOTH_FIELD(callElement, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callActivationProperty[] = {
+    MOTH_FIELD(callActivationProperty, name, Word),
+    MOTH_FIELD(callActivationProperty, argc, Word),
+    MOTH_FIELD(callActivationProperty, callData, Word),
+    MOTH_FIELD(callActivationProperty, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callGlobalLookup[] = {
+    MOTH_FIELD(callGlobalLookup, index, Word),
+    MOTH_FIELD(callGlobalLookup, argc, Word),
+    MOTH_FIELD(callGlobalLookup, callData, Word),
+    MOTH_FIELD(callGlobalLookup, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_setExceptionHandler[] = { MOTH_FIELD(setExceptionHandler, offset, Jump), MOTH_FIELDS_END };
+const PortableField fields_callBuiltinThrow[] = { MOTH_FIELD(callBuiltinThrow, arg, Param), MOTH_FIELDS_END };
+const PortableField fields_callBuiltinUnwindException[] = {
+    MOTH_FIELD(callBuiltinUnwindException, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinPushCatchScope[] = {
+    MOTH_FIELD(callBuiltinPushCatchScope, name, Word),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinPushScope[] = { MOTH_FIELD(callBuiltinPushScope, arg, Param), MOTH_FIELDS_END };
+const PortableField fields_callBuiltinPopScope[] = { MOTH_FIELDS_END };
+const PortableField fields_callBuiltinForeachIteratorObject[] = {
+    MOTH_FIELD(callBuiltinForeachIteratorObject, arg, Param),
+    MOTH_FIELD(callBuiltinForeachIteratorObject, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinForeachNextPropertyName[] = {
+    MOTH_FIELD(callBuiltinForeachNextPropertyName, arg, Param),
+    MOTH_FIELD(callBuiltinForeachNextPropertyName, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinDeleteMember[] = {
+    MOTH_FIELD(callBuiltinDeleteMember, member, Word),
+    MOTH_FIELD(callBuiltinDeleteMember, base, Param),
+    MOTH_FIELD(callBuiltinDeleteMember, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinDeleteSubscript[] = {
+    MOTH_FIELD(callBuiltinDeleteSubscript, base, Param),
+    MOTH_FIELD(callBuiltinDeleteSubscript, index, Param),
+    MOTH_FIELD(callBuiltinDeleteSubscript, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinDeleteName[] = {
+    MOTH_FIELD(callBuiltinDeleteName, name, Word),
+    MOTH_FIELD(callBuiltinDeleteName, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinTypeofMember[] = {
+    MOTH_FIELD(callBuiltinTypeofMember, member, Word),
+    MOTH_FIELD(callBuiltinTypeofMember, base, Param),
+    MOTH_FIELD(callBuiltinTypeofMember, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinTypeofSubscript[] = {
+    MOTH_FIELD(callBuiltinTypeofSubscript, base, Param),
+    MOTH_FIELD(callBuiltinTypeofSubscript, index, Param),
+    MOTH_FIELD(callBuiltinTypeofSubscript, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinTypeofName[] = {
+    MOTH_FIELD(callBuiltinTypeofName, name, Word),
+    MOTH_FIELD(callBuiltinTypeofName, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinTypeofValue[] = {
+    MOTH_FIELD(callBuiltinTypeofValue, value, Param),
+    MOTH_FIELD(callBuiltinTypeofValue, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinDeclareVar[] = {
+    MOTH_FIELD(callBuiltinDeclareVar, varName, Word),
+    MOTH_FIELD(callBuiltinDeclareVar, isDeletable, Bool),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinDefineArray[] = {
+    MOTH_FIELD(callBuiltinDefineArray, argc, Word),
+    MOTH_FIELD(callBuiltinDefineArray, args, Word),
+    MOTH_FIELD(callBuiltinDefineArray, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinDefineObjectLiteral[] = {
+    MOTH_FIELD(callBuiltinDefineObjectLiteral, internalClassId, Word),
+    MOTH_FIELD(callBuiltinDefineObjectLiteral, arrayValueCount, Word),
+    MOTH_FIELD(callBuiltinDefineObjectLiteral, arrayGetterSetterCountAndFlags, Word),
+    MOTH_FIELD(callBuiltinDefineObjectLiteral, args, Word),
+    MOTH_FIELD(callBuiltinDefineObjectLiteral, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinSetupArgumentsObject[] = {
+    MOTH_FIELD(callBuiltinSetupArgumentsObject, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_callBuiltinConvertThisToObject[] = { MOTH_FIELDS_END };
+const PortableField fields_callBuiltinIsClosure[] = {
+    MOTH_FIELD(callBuiltinIsClosure, value, Param),
+    MOTH_FIELD(callBuiltinIsClosure, functionIndex, Word),
+    MOTH_FIELD(callBuiltinIsClosure, scopeDepth, Word),
+    MOTH_FIELD(callBuiltinIsClosure, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_createValue[] = {
+    MOTH_FIELD(createValue, argc, Word),
+    MOTH_FIELD(createValue, callData, Word),
+    MOTH_FIELD(createValue, func, Param),
+    MOTH_FIELD(createValue, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_createProperty[] = {
+    MOTH_FIELD(createProperty, name, Word),
+    MOTH_FIELD(createProperty, argc, Word),
+    MOTH_FIELD(createProperty, callData, Word),
+    MOTH_FIELD(createProperty, base, Param),
+    MOTH_FIELD(createProperty, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_constructPropertyLookup[] = {
+    MOTH_FIELD(constructPropertyLookup, index, Word),
+    MOTH_FIELD(constructPropertyLookup, argc, Word),
+    MOTH_FIELD(constructPropertyLookup, callData, Word),
+    MOTH_FIELD(constructPropertyLookup, base, Param),
+    MOTH_FIELD(constructPropertyLookup, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_createActivationProperty[] = {
+    MOTH_FIELD(createActivationProperty, name, Word),
+    MOTH_FIELD(createActivationProperty, argc, Word),
+    MOTH_FIELD(createActivationProperty, callData, Word),
+    MOTH_FIELD(createActivationProperty, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_constructGlobalLookup[] = {
+    MOTH_FIELD(constructGlobalLookup, index, Word),
+    MOTH_FIELD(constructGlobalLookup, argc, Word),
+    MOTH_FIELD(constructGlobalLookup, callData, Word),
+    MOTH_FIELD(constructGlobalLookup, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_jump[] = { MOTH_FIELD(jump, offset, Jump), MOTH_FIELDS_END };
+const PortableField fields_jumpEq[] = {
+    MOTH_FIELD(jumpEq, offset, Jump),
+    MOTH_FIELD(jumpEq, condition, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_jumpNe[] = {
+    MOTH_FIELD(jumpNe, offset, Jump),
+    MOTH_FIELD(jumpNe, condition, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_compareJump[] = {
+    MOTH_FIELD(compareJump, offset, Jump),
+    MOTH_FIELD(compareJump, cmp, CompareOperation),
+    MOTH_FIELD(compareJump, lhs, Param),
+    MOTH_FIELD(compareJump, rhs, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_unot[] = {
+    MOTH_FIELD(unot, source, Param),
+    MOTH_FIELD(unot, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_unotBool[] = {
+    MOTH_FIELD(unotBool, source, Param),
+    MOTH_FIELD(unotBool, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_uplus[] = {
+    MOTH_FIELD(uplus, source, Param),
+    MOTH_FIELD(uplus, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_uminus[] = {
+    MOTH_FIELD(uminus, source, Param),
+    MOTH_FIELD(uminus, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_ucompl[] = {
+    MOTH_FIELD(ucompl, source, Param),
+    MOTH_FIELD(ucompl, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_ucomplInt[] = {
+    MOTH_FIELD(ucomplInt, source, Param),
+    MOTH_FIELD(ucomplInt, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_increment[] = {
+    MOTH_FIELD(increment, source, Param),
+    MOTH_FIELD(increment, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_decrement[] = {
+    MOTH_FIELD(decrement, source, Param),
+    MOTH_FIELD(decrement, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_binop[] = {
+    MOTH_FIELD(binop, alu, BinaryOperation),
+    MOTH_FIELD(binop, lhs, Param),
+    MOTH_FIELD(binop, rhs, Param),
+    MOTH_FIELD(binop, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_add[] = {
+    MOTH_FIELD(add, lhs, Param),
+    MOTH_FIELD(add, rhs, Param),
+    MOTH_FIELD(add, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_bitAnd[] = {
+    MOTH_FIELD(bitAnd, lhs, Param),
+    MOTH_FIELD(bitAnd, rhs, Param),
+    MOTH_FIELD(bitAnd, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_bitOr[] = {
+    MOTH_FIELD(bitOr, lhs, Param),
+    MOTH_FIELD(bitOr, rhs, Param),
+    MOTH_FIELD(bitOr, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_bitXor[] = {
+    MOTH_FIELD(bitXor, lhs, Param),
+    MOTH_FIELD(bitXor, rhs, Param),
+    MOTH_FIELD(bitXor, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_shr[] = {
+    MOTH_FIELD(shr, lhs, Param),
+    MOTH_FIELD(shr, rhs, Param),
+    MOTH_FIELD(shr, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_shl[] = {
+    MOTH_FIELD(shl, lhs, Param),
+    MOTH_FIELD(shl, rhs, Param),
+    MOTH_FIELD(shl, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_bitAndConst[] = {
+    MOTH_FIELD(bitAndConst, lhs, Param),
+    MOTH_FIELD(bitAndConst, rhs, Word),
+    MOTH_FIELD(bitAndConst, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_bitOrConst[] = {
+    MOTH_FIELD(bitOrConst, lhs, Param),
+    MOTH_FIELD(bitOrConst, rhs, Word),
+    MOTH_FIELD(bitOrConst, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_bitXorConst[] = {
+    MOTH_FIELD(bitXorConst, lhs, Param),
+    MOTH_FIELD(bitXorConst, rhs, Word),
+    MOTH_FIELD(bitXorConst, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_shrConst[] = {
+    MOTH_FIELD(shrConst, lhs, Param),
+    MOTH_FIELD(shrConst, rhs, Word),
+    MOTH_FIELD(shrConst, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_shlConst[] = {
+    MOTH_FIELD(shlConst, lhs, Param),
+    MOTH_FIELD(shlConst, rhs, Word),
+    MOTH_FIELD(shlConst, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_mul[] = {
+    MOTH_FIELD(mul, lhs, Param),
+    MOTH_FIELD(mul, rhs, Param),
+    MOTH_FIELD(mul, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_sub[] = {
+    MOTH_FIELD(sub, lhs, Param),
+    MOTH_FIELD(sub, rhs, Param),
+    MOTH_FIELD(sub, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_binopContext[] = {
+    MOTH_FIELD(binopContext, alu, ContextOperation),
+    MOTH_FIELD(binopContext, lhs, Param),
+    MOTH_FIELD(binopContext, rhs, Param),
+    MOTH_FIELD(binopContext, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadThis[] = { MOTH_FIELD(loadThis, result, Param), MOTH_FIELDS_END };
+const PortableField fields_loadQmlIdArray[] = { MOTH_FIELD(loadQmlIdArray, result, Param), MOTH_FIELDS_END };
+const PortableField fields_loadQmlImportedScripts[] = {
+    MOTH_FIELD(loadQmlImportedScripts, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadQmlContextObject[] = {
+    MOTH_FIELD(loadQmlContextObject, result, Param),
+    MOTH_FIELDS_END
+};
+const PortableField fields_loadQmlScopeObject[] = { MOTH_FIELD(loadQmlScopeObject, result, Param), MOTH_FIELDS_END };
+const PortableField fields_loadQmlSingleton[] = {
+    MOTH_FIELD(loadQmlSingleton, result, Param),
+    MOTH_FIELD(loadQmlSingleton, name, Word),
+    MOTH_FIELDS_END
+};
+
+#undef MOTH_FIELDS_END
+#undef MOTH_FIELD
+
+#define MOTH_FIELDS_OF(I, FMT) fields_##FMT,
+const PortableField * const portableFields[] = { FOR_EACH_MOTH_INSTR(MOTH_FIELDS_OF) };
+#undef MOTH_FIELDS_OF
+
+int portableInstructionSize(int type)
+{
+    int size = 1;
+    for (const PortableField *field = portableFields[type]; field->kind != EndOfFields; ++field)
+        size += field->kind == ValueField ? 3 : 1;
+    return size;
+}
+
+template <typename T>
+inline T loadField(const char *field)
+{
+    T value;
+    memcpy(&value, field, sizeof(T));
+    return value;
+}
+
+template <typename T>
+inline void storeField(char *field, T value)
+{
+    memcpy(field, &value, sizeof(T));
+}
+
+inline bool isBinaryAluOp(quint32 op)
+{
+    // aluOpFunction asserts on the in-place operators.
+    return op > IR::OpInvalid && op <= IR::LastAluOp && op != IR::OpIncrement && op != IR::OpDecrement;
+}
+
+template <typename Operation>
+int findAluOp(Operation (*function)(IR::AluOp), Operation operation)
+{
+    for (quint32 op = 0; op <= IR::LastAluOp; ++op) {
+        if (isBinaryAluOp(op) && function(IR::AluOp(op)) == operation)
+            return op;
+    }
+    return -1;
+}
+
+template <typename Operation>
+bool encodeOperation(Operation (*function)(IR::AluOp), const char *field, QVector<quint32> *code)
+{
+    const int op = findAluOp(function, loadField<Operation>(field));
+    if (op < 0)
+        return false;
+    code->append(op);
+    return true;
+}
+
+template <typename Operation>
+bool decodeOperation(Operation (*function)(IR::AluOp), quint32 op, char *field)
+{
+    if (!isBinaryAluOp(op))
+        return false;
+    const Operation operation = function(IR::AluOp(op));
+    if (!operation)
+        return false;
+    storeField(field, operation);
+    return true;
+}
+
+bool encodeValue(QV4::ReturnedValue encoded, QVector<quint32> *code)
+{
+    QV4::Value value;
+    value.setRawValue(encoded);
+    quint32 kind;
+    quint64 payload = 0;
+    if (value.isUndefined()) {
+        kind = UndefinedValue;
+    } else if (value.isNull()) {
+        kind = NullValue;
+    } else if (value.isBoolean()) {
+        kind = BooleanValue;
+        payload = value.booleanValue();
+    } else if (value.isInteger()) {
+        kind = IntegerValue;
+        payload = quint32(value.integerValue());
+    } else if (value.isDouble()) {
+        kind = DoubleValue;
+        const double d = value.doubleValue();
+        memcpy(&payload, &d, sizeof(d));
+    } else {
+        return false;
+    }
+    code->append(kind);
+    code->append(quint32(payload));
+    code->append(quint32(payload >> 32));
+    return true;
+}
+
+int instructionType(const Instr *instr)
+{
+#ifdef MOTH_THREADED_INTERPRETER
+    void **jumpTable = VME::instructionJumpTable();
+    for (int i = 0; i < InstructionTypeCount; ++i) {
+        if (jumpTable[i] == instr->common.code)
+            return i;
+    }
+    return -1;
+#else
+    return instr->common.instructionType;
+#endif
+}
+
+// Appends the size of the code of a function and its portable form to code.
+bool encodeFunction(const QByteArray &function, QVector<quint32> *code)
+{
+    const char *start = function.constData();
+
+    // The word index of each instruction, by its offset, for the jumps.
+    QVector<int> wordIndices(function.size() + 1, -1);
+    int wordCount = 0;
+    for (int offset = 0; offset < function.size(); ) {
+        const int type = instructionType(reinterpret_cast<const Instr *>(start + offset));
+        if (type < 0 || type >= InstructionTypeCount)
+            return false;
+        wordIndices[offset] = wordCount;
+        wordCount += portableInstructionSize(type);
+        offset += Instr::size(Instr::Type(type));
+    }
+    wordIndices[function.size()] = wordCount;
+
+    code->reserve(code->size() + 1 + wordCount);
+    code->append(wordCount);
+    for (int offset = 0; offset < function.size(); ) {
+        const char *instr = start + offset;
+        const int type = instructionType(reinterpret_cast<const Instr *>(instr));
+        code->append(type);
+        for (const PortableField *field = portableFields[type]; field->kind != EndOfFields; ++field) {
+            const char *data = instr + field->offset;
+            switch (field->kind) {
+            case WordField:
+                code->append(loadField<quint32>(data));
+                break;
+            case ParamField: {
+                const Param param = loadField<Param>(data);
+                code->append(param.scope | quint32(param.index) << Param::ScopeBits);
+                break;
+            }
+            case BoolField:
+                code->append(loadField<bool>(data));
+                break;
+            case JumpField: {
+                // Jumps are relative to their field, the exception handler is 0 when not set.
+                const qptrdiff jump = loadField<qptrdiff>(data);
+                if (!jump) {
+                    code->append(noJumpTarget);
+                    break;
+                }
+                const qptrdiff target = offset + field->offset + jump;
+                if (target < 0 || target > function.size() || wordIndices.at(int(target)) < 0)
+                    return false;
+                code->append(wordIndices.at(int(target)));
+                break;
+            }
+            case ValueField:
+                if (!encodeValue(loadField<QV4::ReturnedValue>(data), code))
+                    return false;
+                break;
+            case BinaryOperationField:
+                if (!encodeOperation(aluOpFunction, data, code))
+                    return false;
+                break;
+            case ContextOperationField:
+                if (!encodeOperation(contextAluOpFunction, data, code))
+                    return false;
+                break;
+            case CompareOperationField:
+                if (!encodeOperation(compareOpFunction, data, code))
+                    return false;
+                break;
+            default:
+                Q_UNREACHABLE();
+            }
+        }
+        offset += Instr::size(Instr::Type(type));
+    }
+    return true;
+}
+
+#ifndef V4_BOOTSTRAP
+bool decodeValue(const quint32 *code, QV4::ReturnedValue *encoded)
+{
+    const quint64 payload = code[1] | quint64(code[2]) << 32;
+    switch (code[0]) {
+    case UndefinedValue:
+        *encoded = QV4::Primitive::undefinedValue().asReturnedValue();
+        return true;
+    case NullValue:
+        *encoded = QV4::Primitive::nullValue().asReturnedValue();
+        return true;
+    case BooleanValue:
+        *encoded = QV4::Primitive::fromBoolean(payload != 0).asReturnedValue();
+        return true;
+    case IntegerValue:
+        *encoded = QV4::Primitive::fromInt32(int(quint32(payload))).asReturnedValue();
+        return true;
+    case DoubleValue: {
+        double d;
+        memcpy(&d, &payload, sizeof(d));
+        *encoded = QV4::Primitive::fromDouble(d).asReturnedValue();
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool decodeFunction(const quint32 *code, int wordCount, QByteArray *function)
+{
+    // The offset of each instruction, by the index of its first word, for the jumps.
+    QVector<int> offsets(wordCount + 1, -1);
+    int size = 0;
+    for (int i = 0; i < wordCount; ) {
+        const quint32 type = code[i];
+        if (type >= InstructionTypeCount || wordCount - i < portableInstructionSize(type))
+            return false;
+        offsets[i] = size;
+        size += Instr::size(Instr::Type(type));
+        i += portableInstructionSize(type);
+    }
+    offsets[wordCount] = size;
+
+    *function = QByteArray(size, 0);
+    char *start = function->data();
+    for (int i = 0; i < wordCount; ) {
+        const int offset = offsets.at(i);
+        char *instr = start + offset;
+        const quint32 type = code[i++];
+#ifdef MOTH_THREADED_INTERPRETER
+        reinterpret_cast<Instr *>(instr)->common.code = VME::instructionJumpTable()[type];
+#else
+        reinterpret_cast<Instr *>(instr)->common.instructionType = type;
+#endif
+        for (const PortableField *field = portableFields[type]; field->kind != EndOfFields; ++field) {
+            char *data = instr + field->offset;
+            const quint32 word = code[i++];
+            switch (field->kind) {
+            case WordField:
+                storeField(data, word);
+                break;
+            case ParamField: {
+                Param param;
+                param.scope = word & ((1u << Param::ScopeBits) - 1);
+                param.index = word >> Param::ScopeBits;
+                storeField(data, param);
+                break;
+            }
+            case BoolField:
+                storeField(data, word != 0);
+                break;
+            case JumpField: {
+                if (word == noJumpTarget) {
+                    storeField(data, qptrdiff(0));
+                    break;
+                }
+                if (word > quint32(wordCount) || offsets.at(word) < 0)
+                    return false;
+                storeField(data, qptrdiff(offsets.at(word) - offset - field->offset));
+                break;
+            }
+            case ValueField: {
+                QV4::ReturnedValue value;
+                if (!decodeValue(code + i - 1, &value))
+                    return false;
+                storeField(data, value);
+                i += 2;
+                break;
+            }
+            case BinaryOperationField:
+                if (!decodeOperation(aluOpFunction, word, data))
+                    return false;
+                break;
+            case ContextOperationField:
+                if (!decodeOperation(contextAluOpFunction, word, data))
+                    return false;
+                break;
+            case CompareOperationField:
+                if (!decodeOperation(compareOpFunction, word, data))
+                    return false;
+                break;
+            default:
+                Q_UNREACHABLE();
+            }
+        }
+    }
+    return true;
+}
+#endif // V4_BOOTSTRAP
+
 } // anonymous namespace
 
 InstructionSelection::InstructionSelection(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator)
@@ -421,6 +1271,8 @@ void InstructionSelection::run(int functionIndex)
         }
     }
 
+    codeGenerated(_function, _addrs);
+
     // TODO: patch stack size (the push instruction)
     patchJumpAddresses();
 
@@ -980,12 +1832,7 @@ Param InstructionSelection::binopHelper(IR::AluOp oper, IR::Expr *leftSource, IR
 
     if (oper == IR::OpInstanceof || oper == IR::OpIn || oper == IR::OpAdd) {
         Instruction::BinopContext binop;
-        if (oper == IR::OpInstanceof)
-            binop.alu = QV4::Runtime::instanceof;
-        else if (oper == IR::OpIn)
-            binop.alu = QV4::Runtime::in;
-        else
-            binop.alu = QV4::Runtime::add;
+        binop.alu = contextAluOpFunction(oper);
         binop.lhs = getParam(leftSource);
         binop.rhs = getParam(rightSource);
         binop.result = getResultParam(target);
@@ -1045,6 +1892,17 @@ void InstructionSelection::visitJump(IR::Jump *s)
         addInstruction(debug);
     }
 
+    // A jump to a block that does nothing but return is replaced by the return itself, which
+    // saves a dispatch at the end of most functions with more than one exit.
+    if (!irModule->debugMode) {
+        if (IR::Ret *ret = returnOnlyBlock(s->target)) {
+            Instruction::Ret r;
+            r.result = getParam(ret->expr);
+            addInstruction(r);
+            return;
+        }
+    }
+
     Instruction::Jump jump;
     jump.offset = 0;
     ptrdiff_t loc = addInstruction(jump) + (((const char *)&jump.offset) - ((const char *)&jump));
@@ -1052,6 +1910,17 @@ void InstructionSelection::visitJump(IR::Jump *s)
     _patches[s->target].append(loc);
 }
 
+IR::Ret *InstructionSelection::returnOnlyBlock(IR::BasicBlock *bb) const
+{
+    // Phi-nodes have already been resolved into moves in the predecessors.
+    foreach (IR::Stmt *s, bb->statements()) {
+        if (s->asPhi())
+            continue;
+        return s->asRet();
+    }
+    return 0;
+}
+
 void InstructionSelection::visitCJump(IR::CJump *s)
 {
     if (blockNeedsDebugInstruction) {
@@ -1064,6 +1933,10 @@ void InstructionSelection::visitCJump(IR::CJump *s)
     if (IR::Temp *t = s->cond->asTemp()) {
         condition = getResultParam(t);
     } else if (IR::Binop *b = s->cond->asBinop()) {
+        if (QV4::Runtime::CompareOperation cmp = compareOpFunction(b->op)) {
+            compareAndJump(cmp, b->left, b->right, s);
+            return;
+        }
         condition = binopHelper(b->op, b->left, b->right, /*target*/0);
     } else {
         Q_UNIMPLEMENTED();
@@ -1091,6 +1964,35 @@ void InstructionSelection::visitCJump(IR::CJump *s)
     }
 }
 
+void InstructionSelection::compareAndJump(QV4::Runtime::CompareOperation cmp, IR::Expr *left,
+                                          IR::Expr *right, IR::CJump *s)
+{
+    if (s->iftrue == _nextBlock) {
+        Instruction::CompareJumpNe jump;
+        jump.offset = 0;
+        jump.cmp = cmp;
+        jump.lhs = getParam(left);
+        jump.rhs = getParam(right);
+        ptrdiff_t falseLoc = addInstruction(jump) + (((const char *)&jump.offset) - ((const char *)&jump));
+        _patches[s->iffalse].append(falseLoc);
+    } else {
+        Instruction::CompareJumpEq jump;
+        jump.offset = 0;
+        jump.cmp = cmp;
+        jump.lhs = getParam(left);
+        jump.rhs = getParam(right);
+        ptrdiff_t trueLoc = addInstruction(jump) + (((const char *)&jump.offset) - ((const char *)&jump));
+        _patches[s->iftrue].append(trueLoc);
+
+        if (s->iffalse != _nextBlock) {
+            Instruction::Jump jump;
+            jump.offset = 0;
+            ptrdiff_t falseLoc = addInstruction(jump) + (((const char *)&jump.offset) - ((const char *)&jump));
+            _patches[s->iffalse].append(falseLoc);
+        }
+    }
+}
+
 void InstructionSelection::visitRet(IR::Ret *s)
 {
     if (blockNeedsDebugInstruction) {
@@ -1413,6 +2315,16 @@ void QV4::Moth::InstructionSelection::callBuiltinConvertThisToObject()
     addInstruction(call);
 }
 
+void InstructionSelection::callBuiltinIsClosure(IR::Expr *value, int functionIndex, int scopeDepth, IR::Expr *result)
+{
+    Instruction::CallBuiltinIsClosure call;
+    call.value = getParam(value);
+    call.functionIndex = functionIndex;
+    call.scopeDepth = scopeDepth;
+    call.result = getResultParam(result);
+    addInstruction(call);
+}
+
 ptrdiff_t InstructionSelection::addInstructionHelper(Instr::Type type, Instr &instr)
 {
 
@@ -1504,6 +2416,24 @@ CompilationUnit::~CompilationUnit()
 {
 }
 
+bool CompilationUnit::savePortableCode(QVector<quint32> *code) const
+{
+    PortableCodeHeader header;
+    header.magic = portableCodeMagic;
+    header.instructionTypeCount = InstructionTypeCount;
+    header.functionCount = codeRefs.size();
+    code->append(header.magic);
+    code->append(header.instructionTypeCount);
+    code->append(header.functionCount);
+
+    foreach (const QByteArray &function, codeRefs) {
+        if (!encodeFunction(function, code))
+            return false;
+    }
+    return true;
+}
+
+#ifndef V4_BOOTSTRAP
 void CompilationUnit::linkBackendToEngine(QV4::ExecutionEngine *engine)
 {
     runtimeFunctions.resize(data->functionTableSize);
@@ -1516,3 +2446,68 @@ void CompilationUnit::linkBackendToEngine(QV4::ExecutionEngine *engine)
         runtimeFunctions[i] = runtimeFunction;
     }
 }
+
+bool CompilationUnit::saveCodeToDisk(QByteArray *code) const
+{
+    QVector<quint32> portableCode;
+    if (!savePortableCode(&portableCode))
+        return false;
+    code->append(reinterpret_cast<const char *>(portableCode.constData()), portableCode.size() * sizeof(quint32));
+    return true;
+}
+
+bool CompilationUnit::loadCodeFromDisk(QV4::ExecutionEngine *engine, const QByteArray &code)
+{
+    Q_UNUSED(engine);
+    if (code.size() % sizeof(quint32))
+        return false;
+    // The data of the cache file need not be aligned for the words.
+    QVector<quint32> portableCode(code.size() / sizeof(quint32));
+    memcpy(portableCode.data(), code.constData(), code.size());
+    return isCompatibleCode(portableCode.constData(), portableCode.size())
+            && loadPortableCode(portableCode.constData(), portableCode.size());
+}
+
+bool CompilationUnit::loadPortableCode(const quint32 *code, int size)
+{
+    PortableCodeHeader header;
+    memcpy(&header, code, sizeof(header));
+    if (header.functionCount != data->functionTableSize)
+        return false;
+
+    QVector<QByteArray> functions(header.functionCount);
+    int offset = PortableCodeHeaderSize;
+    for (quint32 i = 0; i < header.functionCount; ++i) {
+        if (offset >= size)
+            return false;
+        const quint32 wordCount = code[offset++];
+        if (quint32(size - offset) < wordCount)
+            return false;
+        if (!decodeFunction(code + offset, wordCount, &functions[i]))
+            return false;
+        offset += wordCount;
+    }
+    if (offset != size)
+        return false;
+
+    codeRefs = functions;
+    return true;
+}
+
+bool CompilationUnit::isCompatibleCode(const quint32 *code, int size)
+{
+    return size >= PortableCodeHeaderSize
+            && code[0] == portableCodeMagic
+            && code[1] == InstructionTypeCount;
+}
+
+QV4::CompiledData::CompilationUnit *CompilationUnit::createForStaticData(const QV4::CompiledData::Unit *data, const quint32 *code, int size)
+{
+    Q_ASSERT(data->flags & QV4::CompiledData::Unit::StaticData);
+    CompilationUnit *unit = new CompilationUnit;
+    unit->data = const_cast<QV4::CompiledData::Unit *>(data);
+    if (!unit->loadPortableCode(code, size))
+        qFatal("Invalid code in the ahead-of-time compiled unit of %s", qPrintable(unit->fileName()));
+    return unit;
+}
+#endif // V4_BOOTSTRAP
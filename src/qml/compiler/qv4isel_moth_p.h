@@ -49,13 +49,28 @@ namespace Moth {
 struct CompilationUnit : public QV4::CompiledData::CompilationUnit
 {
     virtual ~CompilationUnit();
+
+    // Writes the code in a form that doesn't depend on the machine, for qmlcachegen and the disk
+    // cache.
+    bool savePortableCode(QVector<quint32> *code) const;
+
+#ifndef V4_BOOTSTRAP
     virtual void linkBackendToEngine(QV4::ExecutionEngine *engine);
+    virtual bool saveCodeToDisk(QByteArray *code) const;
+    virtual bool loadCodeFromDisk(QV4::ExecutionEngine *engine, const QByteArray &code);
+    bool loadPortableCode(const quint32 *code, int size);
+
+    // For units compiled ahead of time by qmlcachegen: the unit data is static and the code is in
+    // the form written by savePortableCode, which must have been checked with isCompatibleCode.
+    static Q_QML_PRIVATE_EXPORT bool isCompatibleCode(const quint32 *code, int size);
+    static Q_QML_PRIVATE_EXPORT QV4::CompiledData::CompilationUnit *createForStaticData(const QV4::CompiledData::Unit *data, const quint32 *code, int size);
+#endif
 
     QVector<QByteArray> codeRefs;
 
 };
 
-class Q_QML_EXPORT InstructionSelection:
+class Q_QML_PRIVATE_EXPORT InstructionSelection:
         public IR::IRDecoder,
         public EvalInstructionSelection
 {
@@ -68,6 +83,11 @@ public:
 protected:
     virtual QQmlRefPointer<CompiledData::CompilationUnit> backendCompileStep();
 
+    // Called when the code for a function has been generated, with the offsets of its basic
+    // blocks in that code.
+    virtual void codeGenerated(IR::Function *function, const QHash<IR::BasicBlock *, ptrdiff_t> &blockOffsets)
+    { Q_UNUSED(function); Q_UNUSED(blockOffsets); }
+
     virtual void visitJump(IR::Jump *);
     virtual void visitCJump(IR::CJump *);
     virtual void visitRet(IR::Ret *);
@@ -94,6 +114,7 @@ protected:
     virtual void callBuiltinDefineObjectLiteral(IR::Expr *result, int keyValuePairCount, IR::ExprList *keyValuePairs, IR::ExprList *arrayEntries, bool needSparseArray);
     virtual void callBuiltinSetupArgumentObject(IR::Expr *result);
     virtual void callBuiltinConvertThisToObject();
+    virtual void callBuiltinIsClosure(IR::Expr *value, int functionIndex, int scopeDepth, IR::Expr *result);
     virtual void callValue(IR::Expr *value, IR::ExprList *args, IR::Expr *result);
     virtual void callProperty(IR::Expr *base, const QString &name, IR::ExprList *args, IR::Expr *result);
     virtual void callSubscript(IR::Expr *base, IR::Expr *index, IR::ExprList *args, IR::Expr *result);
@@ -126,6 +147,8 @@ protected:
 
 private:
     Param binopHelper(IR::AluOp oper, IR::Expr *leftSource, IR::Expr *rightSource, IR::Expr *target);
+    void compareAndJump(QV4::Runtime::CompareOperation cmp, IR::Expr *left, IR::Expr *right, IR::CJump *s);
+    IR::Ret *returnOnlyBlock(IR::BasicBlock *bb) const;
 
     struct Instruction {
 #define MOTH_INSTR_DATA_TYPEDEF(I, FMT) typedef InstrData<Instr::I> I;
@@ -180,7 +203,7 @@ private:
     QHash<IR::Function *, QByteArray> codeRefs;
 };
 
-class Q_QML_EXPORT ISelFactory: public EvalISelFactory
+class Q_QML_PRIVATE_EXPORT ISelFactory: public EvalISelFactory
 {
 public:
     virtual ~ISelFactory() {}
@@ -188,6 +211,8 @@ public:
     { return new InstructionSelection(qmlEngine, execAllocator, module, jsGenerator); }
     virtual bool jitCompileRegexps() const
     { return false; }
+    virtual QV4::CompiledData::CompilationUnit *createUnitForLoading()
+    { return new CompilationUnit; }
 };
 
 template<int InstrT>
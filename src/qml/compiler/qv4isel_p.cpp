@@ -36,6 +36,7 @@
 #include "qv4jsir_p.h"
 #include "qv4isel_p.h"
 #include "qv4isel_util_p.h"
+#include "qv4ssa_p.h"
 #include <private/qv4value_p.h>
 #ifndef V4_BOOTSTRAP
 #include <private/qqmlpropertycache_p.h>
@@ -71,6 +72,8 @@ EvalISelFactory::~EvalISelFactory()
 
 QQmlRefPointer<CompiledData::CompilationUnit> EvalInstructionSelection::compile(bool generateUnitData)
 {
+    IR::Inliner(irModule).run();
+
     for (int i = 0; i < irModule->functions.size(); ++i)
         run(i);
 
@@ -394,6 +397,14 @@ void IRDecoder::callBuiltin(IR::Call *call, Expr *result)
         callBuiltinConvertThisToObject();
         return;
 
+    case IR::Name::builtin_is_closure: {
+        IR::Expr *value = call->args->expr;
+        IR::Const *functionIndex = call->args->next->expr->asConst();
+        IR::Const *scopeDepth = call->args->next->next->expr->asConst();
+        Q_ASSERT(functionIndex && scopeDepth);
+        callBuiltinIsClosure(value, int(functionIndex->value), int(scopeDepth->value), result);
+    } return;
+
     default:
         break;
     }
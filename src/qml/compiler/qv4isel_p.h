@@ -90,6 +90,9 @@ public:
     virtual ~EvalISelFactory() = 0;
     virtual EvalInstructionSelection *create(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator) = 0;
     virtual bool jitCompileRegexps() const = 0;
+    // Returns an empty unit to load cached code into, or 0 if the code of this backend cannot be
+    // cached.
+    virtual QV4::CompiledData::CompilationUnit *createUnitForLoading() { return 0; }
 };
 
 namespace IR {
@@ -128,6 +131,7 @@ public: // to implement by subclasses:
     virtual void callBuiltinDefineObjectLiteral(IR::Expr *result, int keyValuePairCount, IR::ExprList *keyValuePairs, IR::ExprList *arrayEntries, bool needSparseArray) = 0;
     virtual void callBuiltinSetupArgumentObject(IR::Expr *result) = 0;
     virtual void callBuiltinConvertThisToObject() = 0;
+    virtual void callBuiltinIsClosure(IR::Expr *value, int functionIndex, int scopeDepth, IR::Expr *result) = 0;
     virtual void callValue(IR::Expr *value, IR::ExprList *args, IR::Expr *result) = 0;
     virtual void callProperty(IR::Expr *base, const QString &name, IR::ExprList *args, IR::Expr *result) = 0;
     virtual void callSubscript(IR::Expr *base, IR::Expr *index, IR::ExprList *args, IR::Expr *result) = 0;
@@ -280,6 +280,7 @@ void Name::initGlobal(const QString *id, quint32 line, quint32 column)
     this->global = true;
     this->qmlSingleton = false;
     this->freeOfSideEffects = false;
+    this->qmlLookup = false;
     this->line = line;
     this->column = column;
 }
@@ -291,6 +292,7 @@ void Name::init(const QString *id, quint32 line, quint32 column)
     this->global = false;
     this->qmlSingleton = false;
     this->freeOfSideEffects = false;
+    this->qmlLookup = false;
     this->line = line;
     this->column = column;
 }
@@ -302,6 +304,7 @@ void Name::init(Builtin builtin, quint32 line, quint32 column)
     this->global = false;
     this->qmlSingleton = false;
     this->freeOfSideEffects = false;
+    this->qmlLookup = false;
     this->line = line;
     this->column = column;
 }
@@ -341,6 +344,8 @@ const char *builtin_to_string(Name::Builtin b)
         return "builtin_setup_argument_object";
     case IR::Name::builtin_convert_this_to_object:
         return "builtin_convert_this_to_object";
+    case IR::Name::builtin_is_closure:
+        return "builtin_is_closure";
     case IR::Name::builtin_qml_id_array:
         return "builtin_qml_id_array";
     case IR::Name::builtin_qml_imported_scripts_object:
@@ -375,6 +380,201 @@ Function *Module::newFunction(const QString &name, Function *outer)
     return f;
 }
 
+namespace {
+class CloneFunction: protected StmtVisitor, protected CloneExpr
+{
+public:
+    CloneFunction(Function *function)
+        : function(function)
+        , original(0)
+    {}
+
+    void operator()(Function *f)
+    {
+        foreach (BasicBlock *bb, f->basicBlocks()) {
+            BasicBlock *newBlock = function->newBasicBlock(0);
+            newBlock->setExceptionHandler(bb->isExceptionHandler());
+        }
+
+        foreach (BasicBlock *bb, f->basicBlocks()) {
+            BasicBlock *newBlock = mapped(bb);
+            newBlock->catchBlock = mapped(bb->catchBlock);
+            foreach (BasicBlock *in, bb->in)
+                newBlock->in.append(mapped(in));
+            foreach (BasicBlock *out, bb->out)
+                newBlock->out.append(mapped(out));
+
+            setBasicBlock(newBlock);
+            foreach (Stmt *s, bb->statements()) {
+                original = s;
+                s->accept(this);
+            }
+
+            newBlock->nextLocation = bb->nextLocation;
+            newBlock->setContainingGroup(mapped(bb->containingGroup()));
+            newBlock->markAsGroupStart(bb->isGroupStart());
+        }
+    }
+
+protected:
+    BasicBlock *mapped(BasicBlock *bb) const
+    { return bb ? function->basicBlock(bb->index()) : 0; }
+
+    void append(Stmt *s)
+    {
+        block->appendStatement(s);
+        s->location = original->location;
+    }
+
+    virtual void visitExp(Exp *s)
+    {
+        Exp *newExp = function->NewStmt<Exp>();
+        newExp->init(clone(s->expr));
+        append(newExp);
+    }
+
+    virtual void visitMove(Move *s)
+    {
+        Move *newMove = function->NewStmt<Move>();
+        newMove->init(clone(s->target), clone(s->source));
+        newMove->swap = s->swap;
+        append(newMove);
+    }
+
+    virtual void visitJump(Jump *s)
+    {
+        Jump *newJump = function->NewStmt<Jump>();
+        newJump->init(mapped(s->target));
+        append(newJump);
+    }
+
+    virtual void visitCJump(CJump *s)
+    {
+        CJump *newCJump = function->NewStmt<CJump>();
+        newCJump->init(clone(s->cond), mapped(s->iftrue), mapped(s->iffalse), mapped(s->parent));
+        append(newCJump);
+    }
+
+    virtual void visitRet(Ret *s)
+    {
+        Ret *newRet = function->NewStmt<Ret>();
+        newRet->init(clone(s->expr));
+        append(newRet);
+    }
+
+    virtual void visitPhi(Phi *) { Q_UNREACHABLE(); }
+
+    // The strings are owned by the original function, so they are interned again.
+    virtual void visitString(String *e)
+    {
+        cloned = block->STRING(function->newString(*e->value));
+    }
+
+    virtual void visitRegExp(RegExp *e)
+    {
+        cloned = block->REGEXP(function->newString(*e->value), e->flags);
+    }
+
+    virtual void visitName(Name *e)
+    {
+        Name *newName = cloneName(e, function);
+        if (e->id)
+            newName->id = function->newString(*e->id);
+        cloned = newName;
+    }
+
+    // The member resolvers point to type information that only lives as long as the QML
+    // type compiler does, so the copy gets compiled without it.
+    virtual void visitTemp(Temp *e)
+    {
+        Temp *newTemp = cloneTemp(e, function);
+        newTemp->memberResolver = 0;
+        cloned = newTemp;
+    }
+
+    virtual void visitMember(Member *e)
+    {
+        Expr *clonedBase = clone(e->base);
+        const QString *name = e->name ? function->newString(*e->name) : 0;
+        Member *newMember = block->MEMBER(clonedBase, name, e->property, e->kind, e->attachedPropertiesIdOrEnumValue)->asMember();
+        newMember->freeOfSideEffects = e->freeOfSideEffects;
+        newMember->inhibitTypeConversionOnWrite = e->inhibitTypeConversionOnWrite;
+        newMember->plainLoad = e->plainLoad;
+        cloned = newMember;
+    }
+
+private:
+    Function *function;
+    Stmt *original;
+};
+
+void copyFunction(Function *f, Function *c)
+{
+    c->tempCount = f->tempCount;
+    c->maxNumberOfArguments = f->maxNumberOfArguments;
+    foreach (const QString *formal, f->formals)
+        c->formals.append(c->newString(*formal));
+    c->formalTypes = f->formalTypes;
+    foreach (const QString *local, f->locals)
+        c->locals.append(c->newString(*local));
+    c->insideWithOrCatch = f->insideWithOrCatch;
+    c->hasDirectEval = f->hasDirectEval;
+    c->usesArgumentsObject = f->usesArgumentsObject;
+    c->usesThis = f->usesThis;
+    c->isStrict = f->isStrict;
+    c->isNamedExpression = f->isNamedExpression;
+    c->hasTry = f->hasTry;
+    c->hasWith = f->hasWith;
+    c->hasLoopEntries = f->hasLoopEntries;
+    c->isLoopEntry = f->isLoopEntry;
+    c->line = f->line;
+    c->column = f->column;
+    c->idObjectDependencies = f->idObjectDependencies;
+    c->contextObjectPropertyDependencies = f->contextObjectPropertyDependencies;
+    c->scopeObjectPropertyDependencies = f->scopeObjectPropertyDependencies;
+
+    CloneFunction cloneFunction(c);
+    cloneFunction(f);
+}
+} // anonymous namespace
+
+Module *Module::clone()
+{
+    Module *copy = new Module(debugMode);
+    copy->fileName = fileName;
+    copy->isQmlModule = isQmlModule;
+    copy->callsInlined = callsInlined;
+
+    foreach (Function *f, functions)
+        copy->functions.append(new Function(copy, 0, *f->name));
+    if (rootFunction)
+        copy->rootFunction = copy->functions.at(functions.indexOf(rootFunction));
+
+    for (int i = 0, ei = functions.size(); i != ei; ++i) {
+        Function *f = functions.at(i);
+        Function *c = copy->functions.at(i);
+        if (f->outer)
+            c->outer = copy->functions.at(functions.indexOf(f->outer));
+        foreach (Function *nested, f->nestedFunctions)
+            c->nestedFunctions.append(copy->functions.at(functions.indexOf(nested)));
+
+        copyFunction(f, c);
+    }
+
+    return copy;
+}
+
+Function *Module::cloneFunction(Function *function)
+{
+    Q_ASSERT(function->module == this);
+
+    Function *copy = new Function(this, function->outer, *function->name);
+    functions.append(copy);
+    copy->nestedFunctions = function->nestedFunctions;
+    copyFunction(function, copy);
+    return copy;
+}
+
 Module::~Module()
 {
     qDeleteAll(functions);
@@ -402,6 +602,8 @@ Function::Function(Module *module, Function *outer, const QString &name)
     , isNamedExpression(false)
     , hasTry(false)
     , hasWith(false)
+    , hasLoopEntries(false)
+    , isLoopEntry(false)
     , unused(0)
     , line(-1)
     , column(-1)
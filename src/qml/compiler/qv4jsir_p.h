@@ -337,6 +337,7 @@ struct Name: Expr {
         builtin_define_object_literal,
         builtin_setup_argument_object,
         builtin_convert_this_to_object,
+        builtin_is_closure,
         builtin_qml_id_array,
         builtin_qml_imported_scripts_object,
         builtin_qml_context_object,
@@ -348,6 +349,9 @@ struct Name: Expr {
     bool global : 1;
     bool qmlSingleton : 1;
     bool freeOfSideEffects : 1;
+    // Looked up like in QML code outside of with statements and catch blocks: in the frozen global
+    // object first, then in the QML context, so the lookup doesn't run any script.
+    bool qmlLookup : 1;
     quint32 line;
     quint32 column;
 
@@ -573,6 +577,12 @@ struct Member: Expr {
     // a reset function. And then there's also Qt.binding().
     uchar inhibitTypeConversionOnWrite: 1;
 
+    // Set for reads of a resolved QObject property with a primitive value or a QObject. They don't
+    // run any script, and they return the same value (or the same wrapper) until something writes
+    // to the object. Value type and variant properties are not included, as every read creates a
+    // new object for them.
+    uchar plainLoad : 1;
+
     uchar kind: 3; // MemberKind
 
     void setEnumValue(int value) {
@@ -593,6 +603,7 @@ struct Member: Expr {
         this->attachedPropertiesIdOrEnumValue = attachedPropertiesIdOrEnumValue;
         this->freeOfSideEffects = false;
         this->inhibitTypeConversionOnWrite = property != 0;
+        this->plainLoad = false;
         this->kind = kind;
     }
 
@@ -750,13 +761,24 @@ struct Q_QML_PRIVATE_EXPORT Module {
     QString fileName;
     bool isQmlModule; // implies rootFunction is always 0
     bool debugMode;
+    bool callsInlined; // the Inliner has run, so a clone of this module must not inline again
 
     Function *newFunction(const QString &name, Function *outer);
 
+    // Returns a deep copy that owns its strings, so the functions can be compiled again
+    // after this module is gone. Must be called before any optimization pass has run.
+    Module *clone();
+
+    // Adds a copy of one of this module's functions to it. The copy shares the outer and the
+    // nested functions with the original, and no closure refers to it. Like clone(), it has to
+    // be taken before any optimization pass has run on the function.
+    Function *cloneFunction(Function *function);
+
     Module(bool debugMode)
         : rootFunction(0)
         , isQmlModule(false)
         , debugMode(debugMode)
+        , callsInlined(false)
     {}
     ~Module();
 
@@ -968,6 +990,9 @@ struct Function {
     int maxNumberOfArguments;
     QSet<QString> strings;
     QList<const QString *> formals;
+    // Types the arguments are known to have on entry, because the caller checks them. Only used
+    // when the formals are turned into temporaries; VarType (or no entry) if nothing is known.
+    QVector<Type> formalTypes;
     QList<const QString *> locals;
     QVector<Function *> nestedFunctions;
     Function *outer;
@@ -981,7 +1006,13 @@ struct Function {
     uint isNamedExpression : 1;
     uint hasTry: 1;
     uint hasWith: 1;
-    uint unused : 25;
+    // The interpreter may leave this function at a loop header, see OnStackReplacement. All its
+    // state then has to be in the context, so its variables are not turned into temporaries.
+    uint hasLoopEntries : 1;
+    // This function continues another one at a loop header, so its variables start out with the
+    // values they have in the context.
+    uint isLoopEntry : 1;
+    uint unused : 23;
 
     // Location of declaration in source code (-1 if not specified)
     int line;
@@ -1087,6 +1118,7 @@ public:
         newName->global = n->global;
         newName->qmlSingleton = n->qmlSingleton;
         newName->freeOfSideEffects = n->freeOfSideEffects;
+        newName->qmlLookup = n->qmlLookup;
         newName->line = n->line;
         newName->column = n->column;
         return newName;
@@ -1129,8 +1161,6 @@ protected:
 
 protected:
     IR::BasicBlock *block;
-
-private:
     IR::Expr *cloned;
 };
 
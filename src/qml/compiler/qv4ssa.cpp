@@ -51,6 +51,8 @@
 #include <iostream>
 #include <cassert>
 #include <algorithm>
+#include <cstring>
+#include <limits>
 
 QT_USE_NAMESPACE
 
@@ -1302,6 +1304,12 @@ public:
         return _defUses[variable.index].blockOfStatement;
     }
 
+    void setDefStmtBlock(const Temp &variable, BasicBlock *defBlock)
+    {
+        Q_ASSERT(static_cast<unsigned>(variable.index) < _defUses.size());
+        _defUses[variable.index].blockOfStatement = defBlock;
+    }
+
     void removeUse(Stmt *usingStmt, const Temp &var)
     {
         Q_ASSERT(static_cast<unsigned>(var.index) < _defUses.size());
@@ -2266,6 +2274,7 @@ class TypeInference: public StmtVisitor, public ExprVisitor
     enum { DebugTypeInference = 0 };
 
     QQmlEnginePrivate *qmlEngine;
+    IR::Function *_function;
     const DefUses &_defUses;
     typedef std::vector<DiscoveredType> TempTypes;
     TempTypes _tempTypes;
@@ -2290,8 +2299,9 @@ class TypeInference: public StmtVisitor, public ExprVisitor
     TypingResult _ty;
 
 public:
-    TypeInference(QQmlEnginePrivate *qmlEngine, const DefUses &defUses)
+    TypeInference(QQmlEnginePrivate *qmlEngine, IR::Function *function, const DefUses &defUses)
         : qmlEngine(qmlEngine)
+        , _function(function)
         , _defUses(defUses)
         , _tempTypes(_defUses.tempCount())
         , _worklist(0)
@@ -2423,7 +2433,10 @@ protected:
         setType(e, _ty.type);
     }
     virtual void visitArgLocal(ArgLocal *e) {
-        _ty = TypingResult(VarType);
+        if (e->kind == ArgLocal::Formal && int(e->index) < _function->formalTypes.size())
+            _ty = TypingResult(_function->formalTypes.at(e->index));
+        else
+            _ty = TypingResult(VarType);
         setType(e, _ty.type);
     }
 
@@ -2743,6 +2756,364 @@ private:
     }
 };
 
+// Calculates the interval of values for temps that can only hold integer numbers, and gives the
+// ones that fit in 32 bits the SInt32Type, so the JIT can use plain 32-bit arithmetic on them
+// instead of doing it with doubles. The typical case is a loop counter:
+//     for (var i = 0; i < n; ++i) ...
+// When n is a constant or an int32 value, i + 1 cannot overflow, because i is smaller than n.
+//
+// The intervals are iterated until a fixpoint is reached. An interval that keeps on growing is
+// widened to infinity, and afterwards all of them are narrowed again by re-evaluating the
+// definitions. A use of a temp in a block that can only be entered through one edge of a
+// comparison of that temp gets the interval restricted by the comparison.
+class RangeAnalysis
+{
+    enum {
+        WideningDelay = 3,
+        NarrowingPasses = 2,
+        MaxConditionDepth = 32
+    };
+
+    struct Range {
+        enum State {
+            Undefined,  // not calculated yet
+            Integral,   // an integer number between lo and hi (both inclusive), never -0
+            Anything    // can also be something that is not an integer number
+        };
+
+        State state;
+        double lo;
+        double hi;
+
+        Range(State state = Undefined, double lo = 0, double hi = 0)
+            : state(state), lo(lo), hi(hi)
+        {}
+
+        static Range integral(double lo, double hi)
+        { return Range(Integral, lo, hi); }
+
+        static Range int32()
+        { return integral(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()); }
+
+        bool isUndefined() const { return state == Undefined; }
+        bool isIntegral() const { return state == Integral; }
+
+        bool fitsInInt32() const
+        {
+            return isIntegral()
+                    && lo >= std::numeric_limits<int>::min()
+                    && hi <= std::numeric_limits<int>::max();
+        }
+
+        bool mayBeZero() const { return lo <= 0 && hi >= 0; }
+
+        Range joined(const Range &other) const
+        {
+            if (isUndefined())
+                return other;
+            if (other.isUndefined())
+                return *this;
+            if (!isIntegral() || !other.isIntegral())
+                return Range(Anything);
+            return integral(qMin(lo, other.lo), qMax(hi, other.hi));
+        }
+
+        bool operator==(const Range &other) const
+        {
+            return state == other.state
+                    && (state != Integral || (lo == other.lo && hi == other.hi));
+        }
+
+        bool operator!=(const Range &other) const
+        { return !(*this == other); }
+    };
+
+    const DefUses &_defUses;
+    const DominatorTree &_dt;
+    std::vector<Range> _ranges;
+
+public:
+    RangeAnalysis(const DefUses &defUses, const DominatorTree &dt)
+        : _defUses(defUses)
+        , _dt(dt)
+    {}
+
+    void run(IR::Function *f)
+    {
+        Q_UNUSED(f);
+
+        _ranges.assign(_defUses.tempCount(), Range());
+        const std::vector<const Temp *> temps = _defUses.defs();
+
+        bool changed = true;
+        for (int iteration = 0; changed; ++iteration) {
+            changed = false;
+            for (std::vector<const Temp *>::const_iterator it = temps.begin(), eit = temps.end(); it != eit; ++it) {
+                const Range old = _ranges[(*it)->index];
+                Range r = old.joined(evaluate(**it));
+                if (r == old)
+                    continue;
+                if (iteration >= WideningDelay && old.isIntegral() && r.isIntegral()) {
+                    if (r.lo < old.lo)
+                        r.lo = -qInf();
+                    if (r.hi > old.hi)
+                        r.hi = qInf();
+                }
+                _ranges[(*it)->index] = r;
+                changed = true;
+            }
+        }
+
+        // Re-evaluating the definitions on top of a fixpoint can only make the intervals smaller.
+        for (int pass = 0; pass < NarrowingPasses; ++pass) {
+            for (std::vector<const Temp *>::const_iterator it = temps.begin(), eit = temps.end(); it != eit; ++it)
+                _ranges[(*it)->index] = evaluate(**it);
+        }
+
+        PropagateTempTypes propagator(_defUses);
+        for (std::vector<const Temp *>::const_iterator it = temps.begin(), eit = temps.end(); it != eit; ++it) {
+            const Temp &t = **it;
+            if (!_ranges[t.index].fitsInInt32())
+                continue;
+
+            Stmt *defStmt = _defUses.defStmt(t);
+            Temp *target = 0;
+            Binop *binop = 0;
+            if (Move *m = defStmt->asMove()) {
+                target = m->target->asTemp();
+                binop = m->source->asBinop();
+                if (binop) {
+                    // The operands get converted to int32 too, so they have to fit as well.
+                    BasicBlock *bb = _defUses.defStmtBlock(t);
+                    if (!rangeOf(binop->left, bb).fitsInInt32() || !rangeOf(binop->right, bb).fitsInInt32())
+                        continue;
+                }
+            } else if (Phi *phi = defStmt->asPhi()) {
+                target = phi->targetTemp;
+            }
+            if (!target || target->type != DoubleType)
+                continue;
+
+            propagator.run(UntypedTemp(t), SInt32Type);
+            if (binop)
+                binop->type = SInt32Type;
+        }
+    }
+
+private:
+    Range evaluate(const Temp &t) const
+    {
+        Stmt *defStmt = _defUses.defStmt(t);
+        if (!defStmt)
+            return Range(Range::Anything);
+        BasicBlock *bb = _defUses.defStmtBlock(t);
+
+        if (Phi *phi = defStmt->asPhi()) {
+            Range r;
+            for (int i = 0, ei = phi->d->incoming.size(); i != ei; ++i)
+                r = r.joined(rangeOf(phi->d->incoming.at(i), bb->in.at(i)));
+            return r;
+        }
+
+        if (Move *m = defStmt->asMove()) {
+            if (Binop *b = m->source->asBinop())
+                return evaluateBinop(b, bb);
+            if (Unop *u = m->source->asUnop())
+                return u->op == OpCompl ? Range::int32() : Range(Range::Anything);
+            return rangeOf(m->source, bb);
+        }
+
+        return Range(Range::Anything);
+    }
+
+    Range evaluateBinop(Binop *b, BasicBlock *bb) const
+    {
+        const Range l = rangeOf(b->left, bb);
+        const Range r = rangeOf(b->right, bb);
+        if (l.isUndefined() || r.isUndefined())
+            return Range();
+
+        switch (b->op) {
+        case OpAdd:
+            if (!l.isIntegral() || !r.isIntegral())
+                return Range(Range::Anything);
+            return Range::integral(l.lo + r.lo, l.hi + r.hi);
+
+        case OpSub:
+            if (!l.isIntegral() || !r.isIntegral())
+                return Range(Range::Anything);
+            return Range::integral(l.lo - r.hi, l.hi - r.lo);
+
+        case OpMul: {
+            if (!l.isIntegral() || !r.isIntegral())
+                return Range(Range::Anything);
+            // 0 * -1 is -0, which is not an int32.
+            if ((l.mayBeZero() && r.lo < 0) || (r.mayBeZero() && l.lo < 0))
+                return Range(Range::Anything);
+            const double products[] = {
+                multiply(l.lo, r.lo), multiply(l.lo, r.hi), multiply(l.hi, r.lo), multiply(l.hi, r.hi)
+            };
+            return Range::integral(*std::min_element(products, products + 4),
+                                   *std::max_element(products, products + 4));
+        }
+
+        case OpBitAnd: {
+            // A non-negative operand clears the sign bit and all bits it doesn't have.
+            double hi = -1;
+            if (l.fitsInInt32() && l.lo >= 0)
+                hi = l.hi;
+            if (r.fitsInInt32() && r.lo >= 0)
+                hi = hi < 0 ? r.hi : qMin(hi, r.hi);
+            return hi < 0 ? Range::int32() : Range::integral(0, hi);
+        }
+
+        case OpRShift:
+            if (Const *c = b->right->asConst()) {
+                const double divisor = 1u << (QV4::Primitive::toUInt32(c->value) & 0x1f);
+                const Range shifted = l.fitsInInt32() ? l : Range::int32();
+                return Range::integral(std::floor(shifted.lo / divisor), std::floor(shifted.hi / divisor));
+            }
+            return Range::int32();
+
+        case OpURShift:
+            if (Const *c = b->right->asConst()) {
+                const double divisor = 1u << (QV4::Primitive::toUInt32(c->value) & 0x1f);
+                if (l.fitsInInt32() && l.lo >= 0)
+                    return Range::integral(std::floor(l.lo / divisor), std::floor(l.hi / divisor));
+                return Range::integral(0, std::floor(double(std::numeric_limits<uint>::max()) / divisor));
+            }
+            return Range::integral(0, std::numeric_limits<uint>::max());
+
+        case OpBitOr:
+        case OpBitXor:
+        case OpLShift:
+            return Range::int32();
+
+        default:
+            return Range(Range::Anything);
+        }
+    }
+
+    // Infinity times zero is zero here, because the infinite bound is only the result of widening.
+    static double multiply(double a, double b)
+    { return (a == 0 || b == 0) ? 0 : a * b; }
+
+    // When useBlock is null, the interval is not restricted by the conditions it is used under.
+    Range rangeOf(Expr *e, BasicBlock *useBlock) const
+    {
+        if (Const *c = e->asConst()) {
+            if (!(c->type & NumberType) || !std::isfinite(c->value) || std::floor(c->value) != c->value
+                    || (c->value == 0 && std::signbit(c->value)))
+                return Range(Range::Anything);
+            return Range::integral(c->value, c->value);
+        }
+
+        if (Temp *t = e->asTemp()) {
+            if (t->kind != Temp::VirtualRegister || t->index >= _ranges.size())
+                return Range(Range::Anything);
+            Range r = _ranges[t->index];
+            if (useBlock && r.isIntegral())
+                r = restricted(*t, r, useBlock);
+            return r;
+        }
+
+        return Range(Range::Anything);
+    }
+
+    // Walks up the dominator tree to find blocks that can only be entered through one edge of a
+    // conditional jump, and applies the comparison that has to hold when taking that edge.
+    Range restricted(const Temp &t, Range r, BasicBlock *useBlock) const
+    {
+        int depth = 0;
+        for (BasicBlock *bb = useBlock; bb && depth < MaxConditionDepth; bb = _dt.immediateDominator(bb), ++depth) {
+            if (bb->in.size() != 1)
+                continue;
+            Stmt *terminator = bb->in.first()->terminator();
+            CJump *cjump = terminator ? terminator->asCJump() : 0;
+            if (!cjump || cjump->iftrue == cjump->iffalse)
+                continue;
+            if (Binop *cond = comparison(cjump->cond))
+                r = restricted(t, r, cond, bb == cjump->iftrue);
+        }
+        return r;
+    }
+
+    Range restricted(const Temp &t, Range r, Binop *cond, bool holds) const
+    {
+        AluOp op = cond->op;
+        Expr *other = 0;
+        if (isTemp(cond->left, t)) {
+            other = cond->right;
+        } else if (isTemp(cond->right, t)) {
+            other = cond->left;
+            // x < t is t > x, and so on.
+            switch (op) {
+            case OpLt: op = OpGt; break;
+            case OpLe: op = OpGe; break;
+            case OpGt: op = OpLt; break;
+            case OpGe: op = OpLe; break;
+            default: Q_UNREACHABLE();
+            }
+        } else {
+            return r;
+        }
+
+        // Both sides are integer numbers, so there is no NaN that makes both edges fail.
+        const Range bound = rangeOf(other, 0);
+        if (!bound.isIntegral())
+            return r;
+        if (!holds) {
+            switch (op) {
+            case OpLt: op = OpGe; break;
+            case OpLe: op = OpGt; break;
+            case OpGt: op = OpLe; break;
+            case OpGe: op = OpLt; break;
+            default: Q_UNREACHABLE();
+            }
+        }
+
+        switch (op) {
+        case OpLt: r.hi = qMin(r.hi, bound.hi - 1); break;
+        case OpLe: r.hi = qMin(r.hi, bound.hi); break;
+        case OpGt: r.lo = qMax(r.lo, bound.lo + 1); break;
+        case OpGe: r.lo = qMax(r.lo, bound.lo); break;
+        default: Q_UNREACHABLE();
+        }
+        return r;
+    }
+
+    Binop *comparison(Expr *cond) const
+    {
+        Binop *b = cond->asBinop();
+        if (!b) {
+            if (Temp *t = cond->asTemp()) {
+                if (Stmt *defStmt = _defUses.defStmt(*t)) {
+                    if (Move *m = defStmt->asMove())
+                        b = m->source->asBinop();
+                }
+            }
+        }
+        if (!b)
+            return 0;
+
+        switch (b->op) {
+        case OpLt:
+        case OpLe:
+        case OpGt:
+        case OpGe:
+            return b;
+        default:
+            return 0;
+        }
+    }
+
+    static bool isTemp(Expr *e, const Temp &t)
+    {
+        Temp *other = e->asTemp();
+        return other && other->kind == t.kind && other->index == t.index;
+    }
+};
+
 void convertConst(Const *c, Type targetType)
 {
     switch (targetType) {
@@ -4243,131 +4614,759 @@ void optimizeSSA(StatementWorklist &W, DefUses &defUses, DominatorTree &df)
     W.applyToFunction();
 }
 
-//### TODO: use DefUses from the optimizer, because it already has all this information
-class InputOutputCollector: protected StmtVisitor, protected ExprVisitor {
-    void setOutput(Temp *out)
-    {
-        Q_ASSERT(!output);
-        output = out;
-    }
+// Classification of the source of a move, used by the loop-invariant code motion and the value
+// numbering below. A pure value only depends on its operands. A loaded value also depends on the
+// state of the heap, which can only change by statements with side effects. Reading a property or
+// an element, including a name from the global object or a QML scope, can call an accessor or a
+// host object, so such reads count as side effects. (Reads from non-escaping literals have been
+// replaced by their values already.) The exceptions are:
+// - Math and its properties in QML code, which are found in the frozen global object (see
+//   Codegen::visit(FieldMemberExpression *)), so they are pure values.
+// - Reads of QObject properties that the QML type compiler resolved to a primitive value or a
+//   QObject (see Member::plainLoad). They are loads.
+enum ValueKind {
+    NoValue,
+    PureValue,
+    LoadedValue,
+    SideEffects
+};
 
-public:
-    std::vector<Temp *> inputs;
-    Temp *output;
+bool isValueOperand(Expr *e)
+{
+    if (Temp *t = e->asTemp())
+        return t->kind == Temp::VirtualRegister;
+    return e->asConst() != 0;
+}
 
-    InputOutputCollector()
-    { inputs.reserve(4); }
+bool isPrimitiveOperand(Expr *e)
+{
+    // Operations on anything else can call valueOf() or toString().
+    return isValueOperand(e) && e->type != UnknownType
+            && (e->type & ~(UndefinedType | NullType | BoolType | NumberType)) == 0;
+}
 
-    void collect(Stmt *s) {
-        inputs.resize(0);
-        output = 0;
-        s->accept(this);
-    }
+ValueKind valueKind(Expr *e)
+{
+    if (e->asTemp() || e->asConst() || e->asString() || e->asRegExp() || e->asClosure())
+        return NoValue;
 
-protected:
-    virtual void visitConst(Const *) {}
-    virtual void visitString(IR::String *) {}
-    virtual void visitRegExp(IR::RegExp *) {}
-    virtual void visitName(Name *) {}
-    virtual void visitTemp(Temp *e) {
-        inputs.push_back(e);
-    }
-    virtual void visitArgLocal(ArgLocal *) {}
-    virtual void visitClosure(Closure *) {}
-    virtual void visitConvert(Convert *e) { e->expr->accept(this); }
-    virtual void visitUnop(Unop *e) { e->expr->accept(this); }
-    virtual void visitBinop(Binop *e) { e->left->accept(this); e->right->accept(this); }
-    virtual void visitCall(Call *e) {
-        e->base->accept(this);
-        for (ExprList *it = e->args; it; it = it->next)
-            it->expr->accept(this);
-    }
-    virtual void visitNew(New *e) {
-        e->base->accept(this);
-        for (ExprList *it = e->args; it; it = it->next)
-            it->expr->accept(this);
-    }
-    virtual void visitSubscript(Subscript *e) { e->base->accept(this); e->index->accept(this); }
-    virtual void visitMember(Member *e) { e->base->accept(this); }
-    virtual void visitExp(Exp *s) { s->expr->accept(this); }
-    virtual void visitMove(Move *s) {
-        s->source->accept(this);
-        if (Temp *t = s->target->asTemp()) {
-            setOutput(t);
-        } else {
-            s->target->accept(this);
+    if (Name *n = e->asName()) {
+        switch (n->builtin) {
+        case Name::builtin_invalid:
+            break;
+        case Name::builtin_qml_id_array:
+        case Name::builtin_qml_imported_scripts_object:
+        case Name::builtin_qml_context_object:
+        case Name::builtin_qml_scope_object:
+            return PureValue;
+        default:
+            return SideEffects;
         }
+        if (n->freeOfSideEffects || *n->id == QStringLiteral("this"))
+            return PureValue;
+        return SideEffects;
     }
-    virtual void visitJump(Jump *) {}
-    virtual void visitCJump(CJump *s) { s->cond->accept(this); }
-    virtual void visitRet(Ret *s) { s->expr->accept(this); }
-    virtual void visitPhi(Phi *) {
-        // Handled separately
-    }
-};
-
-/*
- * The algorithm is described in:
- *
- *   Linear Scan Register Allocation on SSA Form
- *   Christian Wimmer & Michael Franz, CGO'10, April 24-28, 2010
- *
- * See LifeTimeIntervals::renumber for details on the numbering.
- */
-class LifeRanges {
-    typedef QSet<Temp> LiveRegs;
-
-    std::vector<LiveRegs> _liveIn;
-    std::vector<LifeTimeInterval *> _intervals;
-    LifeTimeIntervals::Ptr _sortedIntervals;
 
-    LifeTimeInterval &interval(const Temp *temp)
-    {
-        LifeTimeInterval *&lti = _intervals[temp->index];
-        if (Q_UNLIKELY(!lti)) {
-            lti = new LifeTimeInterval;
-            lti->setTemp(*temp);
-        }
-        return *lti;
-    }
+    if (e->asArgLocal())
+        return LoadedValue;
 
-    int defPosition(IR::Stmt *s) const
-    {
-        return usePosition(s) + 1;
+    if (Member *m = e->asMember()) {
+        if (!isValueOperand(m->base))
+            return SideEffects;
+        if (m->kind == Member::MemberOfEnum || m->freeOfSideEffects)
+            return PureValue;
+        if (m->plainLoad)
+            return LoadedValue;
+        return SideEffects;
     }
 
-    int usePosition(IR::Stmt *s) const
-    {
-        return _sortedIntervals->positionForStatement(s);
-    }
+    if (Convert *c = e->asConvert())
+        return isPrimitiveOperand(c->expr) ? PureValue : SideEffects;
 
-    int start(IR::BasicBlock *bb) const
-    {
-        return _sortedIntervals->startPosition(bb);
-    }
+    if (Unop *u = e->asUnop())
+        return isPrimitiveOperand(u->expr) ? PureValue : SideEffects;
 
-    int end(IR::BasicBlock *bb) const
-    {
-        return _sortedIntervals->endPosition(bb);
+    if (Binop *b = e->asBinop()) {
+        if (b->op == OpInstanceof || b->op == OpIn)
+            return SideEffects;
+        return isPrimitiveOperand(b->left) && isPrimitiveOperand(b->right) ? PureValue : SideEffects;
     }
 
-public:
-    LifeRanges(IR::Function *function, const QHash<BasicBlock *, BasicBlock *> &startEndLoops)
-        : _intervals(function->tempCount)
-    {
-        _sortedIntervals = LifeTimeIntervals::create(function);
-        _liveIn.resize(function->basicBlockCount());
-
-        for (int i = function->basicBlockCount() - 1; i >= 0; --i) {
-            BasicBlock *bb = function->basicBlock(i);
-            buildIntervals(bb, startEndLoops.value(bb, 0));
-        }
+    return SideEffects;
+}
 
-        _intervals.clear();
+bool hasSideEffects(Stmt *s)
+{
+    if (Move *m = s->asMove()) {
+        Temp *target = m->target->asTemp();
+        if (!target || target->kind != Temp::VirtualRegister)
+            return true;
+        return valueKind(m->source) == SideEffects;
     }
+    if (CJump *cjump = s->asCJump())
+        return valueKind(cjump->cond) == SideEffects;
+    if (Exp *exp = s->asExp())
+        return valueKind(exp->expr) == SideEffects;
+    return false;
+}
+
+QString operandKey(Expr *e)
+{
+    if (Temp *t = e->asTemp())
+        return QLatin1Char('%') + QString::number(t->index);
+    Const *c = e->asConst();
+    Q_ASSERT(c);
+    quint64 bits;
+    memcpy(&bits, &c->value, sizeof(bits));
+    return QLatin1Char('#') + QString::number(c->type) + QLatin1Char(':') + QString::number(bits, 16);
+}
+
+// Returns the kind of value that is computed by a move into a temp, and fills in a key which is
+// equal for all moves computing the same value.
+ValueKind valueKey(Move *m, QString *key)
+{
+    Temp *target = m->target->asTemp();
+    if (!target || target->kind != Temp::VirtualRegister || m->swap)
+        return SideEffects;
+
+    const ValueKind kind = valueKind(m->source);
+    if (kind != PureValue && kind != LoadedValue)
+        return kind;
+
+    *key = QString::number(target->type) + QLatin1Char('=');
+    Expr *e = m->source;
+    if (Name *n = e->asName()) {
+        if (n->id)
+            *key += QLatin1String("name ") + *n->id;
+        else
+            *key += QLatin1String("builtin ") + QString::number(n->builtin);
+    } else if (ArgLocal *al = e->asArgLocal()) {
+        *key += QLatin1String("arg ") + QString::number(al->kind) + QLatin1Char(' ')
+                + QString::number(al->index) + QLatin1Char(' ') + QString::number(al->scope);
+    } else if (Member *member = e->asMember()) {
+        *key += QLatin1String("member ") + operandKey(member->base) + QLatin1Char('.')
+                + *member->name + QLatin1Char(' ') + QString::number(member->kind)
+                + QLatin1Char(' ') + QString::number(member->attachedPropertiesIdOrEnumValue);
+    } else if (Convert *c = e->asConvert()) {
+        *key += QLatin1String("convert ") + QString::number(c->type) + QLatin1Char(' ')
+                + operandKey(c->expr);
+    } else if (Unop *u = e->asUnop()) {
+        *key += QLatin1String("unop ") + QString::number(u->op) + QLatin1Char(' ')
+                + operandKey(u->expr);
+    } else if (Binop *b = e->asBinop()) {
+        QString left = operandKey(b->left);
+        QString right = operandKey(b->right);
+        switch (b->op) {
+        case OpAdd: // all operands are primitive values that are not strings
+        case OpMul:
+        case OpBitAnd:
+        case OpBitOr:
+        case OpBitXor:
+        case OpEqual:
+        case OpNotEqual:
+        case OpStrictEqual:
+        case OpStrictNotEqual:
+            if (right < left)
+                qSwap(left, right);
+            break;
+        default:
+            break;
+        }
+        *key += QLatin1String("binop ") + QString::number(b->op) + QLatin1Char(' ') + left
+                + QLatin1Char(' ') + right;
+    } else {
+        Q_UNREACHABLE();
+    }
+
+    return kind;
+}
+
+// Replaces object and array literals that never escape the function they are created in by the
+// values they are created from. A literal qualifies when it is only read, and only through
+// properties it defines itself (or, for arrays, through constant indices and length), so no read
+// can end up in the prototype chain or observe a write:
+//     var p = { x: a, y: b }; return p.x * p.y;
+// becomes:
+//     return a * b;
+// Any other use (passing the literal on, storing into it, capturing it in a closure, merging it
+// in a phi-node, ...) makes it escape, and it is left alone.
+class ScalarReplacement
+{
+    IR::Function *function;
+    DefUses &defUses;
+
+public:
+    ScalarReplacement(DefUses &defUses)
+        : function(0)
+        , defUses(defUses)
+    {}
+
+    void run(IR::Function *f)
+    {
+        function = f;
+
+        foreach (BasicBlock *bb, function->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+
+            // Iterate over a copy: replacing a literal removes statements.
+            const QVector<Stmt *> statements = bb->statements();
+            foreach (Stmt *s, statements) {
+                Move *m = s->asMove();
+                if (!m)
+                    continue;
+                Temp *t = m->target->asTemp();
+                Call *c = m->source->asCall();
+                if (!t || !c)
+                    continue;
+                Name *n = c->base->asName();
+                if (!n)
+                    continue;
+
+                if (n->builtin == Name::builtin_define_object_literal)
+                    replaceObjectLiteral(m, bb, *t, c->args);
+                else if (n->builtin == Name::builtin_define_array)
+                    replaceArrayLiteral(m, bb, *t, c->args);
+            }
+        }
+    }
+
+private:
+    static bool isReplaceableValue(Expr *e)
+    {
+        if (Const *c = e->asConst())
+            return c->type != MissingType;
+        return e->asTemp() != 0;
+    }
+
+    // Collects all reads from the literal stored in t, following copies. Returns false when the
+    // literal escapes.
+    bool collectUses(const Temp &t, QVector<Move *> *loads, QVector<Move *> *copies) const
+    {
+        foreach (Stmt *use, defUses.uses(t)) {
+            Move *m = use->asMove();
+            if (!m || !m->target->asTemp())
+                return false;
+
+            if (Temp *source = m->source->asTemp()) {
+                Q_ASSERT(*source == t);
+                Q_UNUSED(source);
+                copies->append(m);
+                if (!collectUses(*m->target->asTemp(), loads, copies))
+                    return false;
+            } else if (Member *member = m->source->asMember()) {
+                Temp *base = member->base->asTemp();
+                if (!base || *base != t || member->kind != Member::UnspecifiedMember
+                        || member->property)
+                    return false;
+                loads->append(m);
+            } else if (Subscript *subscript = m->source->asSubscript()) {
+                Temp *base = subscript->base->asTemp();
+                if (!base || *base != t)
+                    return false;
+                loads->append(m);
+            } else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void replaceObjectLiteral(Move *define, BasicBlock *bb, const Temp &t, ExprList *args)
+    {
+        QHash<QString, Expr *> properties;
+
+        const int keyValuePairsCount = args->expr->asConst()->value;
+        args = args->next;
+        for (int i = 0; i < keyValuePairsCount; ++i) {
+            Name *key = args->expr->asName();
+            args = args->next;
+            const bool isData = args->expr->asConst()->value;
+            args = args->next;
+            if (!isData || *key->id == QLatin1String("__proto__")
+                    || !isReplaceableValue(args->expr))
+                return;
+            properties.insert(*key->id, args->expr);
+            args = args->next;
+        }
+
+        QVector<Move *> loads, copies;
+        if (!collectUses(t, &loads, &copies))
+            return;
+
+        QVector<Expr *> values;
+        values.reserve(loads.size());
+        foreach (Move *load, loads) {
+            Member *member = load->source->asMember();
+            if (!member)
+                return;
+            Expr *value = properties.value(*member->name, 0);
+            if (!value)
+                return;
+            values.append(value);
+        }
+
+        replace(define, bb, loads, values, copies);
+    }
+
+    void replaceArrayLiteral(Move *define, BasicBlock *bb, const Temp &t, ExprList *args)
+    {
+        QVector<Expr *> elements;
+        for (ExprList *it = args; it; it = it->next)
+            elements.append(it->expr);
+
+        QVector<Move *> loads, copies;
+        if (!collectUses(t, &loads, &copies))
+            return;
+
+        QVector<Expr *> values;
+        values.reserve(loads.size());
+        foreach (Move *load, loads) {
+            if (Member *member = load->source->asMember()) {
+                if (*member->name != QLatin1String("length"))
+                    return;
+                Const *length = function->New<Const>();
+                length->init(SInt32Type, elements.size());
+                values.append(length);
+                continue;
+            }
+
+            Expr *index = load->source->asSubscript()->index;
+            if (Temp *indexTemp = index->asTemp()) {
+                Move *indexDef = defUses.defStmt(*indexTemp) ? defUses.defStmt(*indexTemp)->asMove()
+                                                             : 0;
+                index = indexDef ? indexDef->source : 0;
+            }
+            Const *c = index ? index->asConst() : 0;
+            if (!c || !(c->type & NumberType))
+                return;
+            if (!(c->value >= 0 && c->value < elements.size()))
+                return;
+            const int i = int(c->value);
+            if (double(i) != c->value || !isReplaceableValue(elements.at(i)))
+                return;
+            values.append(elements.at(i));
+        }
+
+        replace(define, bb, loads, values, copies);
+    }
+
+    void replace(Move *define, BasicBlock *bb, const QVector<Move *> &loads,
+                 const QVector<Expr *> &values, const QVector<Move *> &copies)
+    {
+        for (int i = 0, ei = loads.size(); i != ei; ++i) {
+            Move *load = loads.at(i);
+            foreach (const Temp &used, defUses.usedVars(load))
+                defUses.removeUse(load, used);
+
+            if (Temp *value = values.at(i)->asTemp()) {
+                Temp *newSource = CloneExpr::cloneTemp(value, function);
+                load->source = newSource;
+                defUses.addUse(*newSource, load);
+            } else {
+                load->source = CloneExpr::cloneConst(values.at(i)->asConst(), function);
+            }
+        }
+
+        foreach (Move *copy, copies)
+            removeDefinition(copy, defUses.defStmtBlock(*copy->target->asTemp()));
+        removeDefinition(define, bb);
+    }
+
+    void removeDefinition(Move *m, BasicBlock *bb)
+    {
+        defUses.removeDefUses(m);
+        bb->removeStatement(m);
+    }
+};
+
+// Replaces all uses of the temp defined by the given move with the given value, and removes the
+// move.
+void replaceValue(Move *m, BasicBlock *bb, const Temp &value, ExprReplacer &replaceUses,
+                  DefUses &defUses, StatementWorklist &W)
+{
+    Temp replacement = value;
+    QVector<Stmt *> newUses;
+    replaceUses(m->target->asTemp(), &replacement, W, &newUses);
+    defUses.addUses(value, newUses);
+    defUses.removeDefUses(m);
+    bb->removeStatement(m);
+}
+
+// Moves computations that don't change inside a loop to the immediate dominator of the loop
+// header, so they are done only once. Pure values are moved when all their operands are defined
+// outside the loop.
+//
+// Loads are only moved out of loops without side effects, and only when they can't introduce a
+// load that wasn't done before. So either the same load is done right before the loop is entered
+// (for example in the first iteration when the loop was peeled), in which case that value is
+// reused, or the load is done in the loop header and the loop is entered directly from the block
+// it is moved to.
+class LoopInvariantCodeMotion
+{
+    DefUses &defUses;
+    DominatorTree &dt;
+    StatementWorklist &W;
+    ExprReplacer replaceUses;
+    std::vector<bool> loopHasSideEffects; // indexed by the loop header
+
+public:
+    LoopInvariantCodeMotion(DefUses &defUses, DominatorTree &dt, StatementWorklist &W)
+        : defUses(defUses)
+        , dt(dt)
+        , W(W)
+        , replaceUses(defUses, W.function())
+    {}
+
+    void run(IR::Function *function)
+    {
+        loopHasSideEffects.assign(function->basicBlockCount(), false);
+        foreach (BasicBlock *bb, function->basicBlocks()) {
+            if (bb->isRemoved() || !loopHeader(bb))
+                continue;
+            foreach (Stmt *s, bb->statements()) {
+                if (hasSideEffects(s)) {
+                    for (BasicBlock *header = loopHeader(bb); header; header = header->containingGroup())
+                        loopHasSideEffects[header->index()] = true;
+                    break;
+                }
+            }
+        }
+
+        // Blocks are visited with dominating blocks first, so by the time a statement is
+        // looked at, all invariant statements it depends on are already moved out of the loop.
+        const QVector<BasicBlock *> order = dt.calculateDFNodeIterOrder();
+        for (int i = order.size() - 1; i >= 0; --i) {
+            BasicBlock *bb = order.at(i);
+            if (!loopHeader(bb))
+                continue;
+            foreach (Stmt *s, bb->statements()) {
+                if (Move *m = s->asMove())
+                    hoist(m, bb);
+            }
+        }
+    }
+
+private:
+    static BasicBlock *loopHeader(BasicBlock *bb)
+    {
+        return bb->isGroupStart() ? bb : bb->containingGroup();
+    }
+
+    static bool isInLoop(BasicBlock *bb, BasicBlock *header)
+    {
+        for (BasicBlock *it = loopHeader(bb); it; it = it->containingGroup()) {
+            if (it == header)
+                return true;
+        }
+        return false;
+    }
+
+    bool isDefinedOutsideLoop(Expr *e, BasicBlock *header) const
+    {
+        if (Temp *t = e->asTemp()) {
+            BasicBlock *defBlock = defUses.defStmtBlock(*t);
+            return !defBlock || !isInLoop(defBlock, header);
+        }
+        return true;
+    }
+
+    bool isInvariant(Expr *e, BasicBlock *header) const
+    {
+        if (Member *m = e->asMember())
+            return isDefinedOutsideLoop(m->base, header);
+        if (Subscript *s = e->asSubscript())
+            return isDefinedOutsideLoop(s->base, header) && isDefinedOutsideLoop(s->index, header);
+        if (Convert *c = e->asConvert())
+            return isDefinedOutsideLoop(c->expr, header);
+        if (Unop *u = e->asUnop())
+            return isDefinedOutsideLoop(u->expr, header);
+        if (Binop *b = e->asBinop())
+            return isDefinedOutsideLoop(b->left, header) && isDefinedOutsideLoop(b->right, header);
+        return true;
+    }
+
+    // Looks for the same load in the straight-line code leading to the end of the given block.
+    bool findLoad(const QString &key, BasicBlock *bb, Temp *value) const
+    {
+        QString candidateKey;
+        while (bb) {
+            const QVector<Stmt *> &statements = bb->statements();
+            for (int i = statements.size() - 1; i >= 0; --i) {
+                Stmt *s = statements.at(i);
+                if (hasSideEffects(s))
+                    return false;
+                Move *candidate = s->asMove();
+                if (candidate && valueKey(candidate, &candidateKey) == LoadedValue
+                        && candidateKey == key) {
+                    *value = *candidate->target->asTemp();
+                    return true;
+                }
+            }
+            bb = bb->in.size() == 1 ? bb->in.first() : 0;
+        }
+        return false;
+    }
+
+    void hoist(Move *m, BasicBlock *bb)
+    {
+        QString key;
+        const ValueKind kind = valueKey(m, &key);
+        if (kind != PureValue && kind != LoadedValue)
+            return;
+
+        BasicBlock *destination = bb;
+        for (BasicBlock *header = loopHeader(bb); header; header = loopHeader(destination)) {
+            BasicBlock *preheader = dt.immediateDominator(header);
+            if (!preheader || !isInvariant(m->source, header))
+                break;
+
+            if (kind == LoadedValue) {
+                if (loopHasSideEffects[header->index()])
+                    break;
+                if (preheader->out.size() != 1 || preheader->out.first() != header)
+                    break;
+                Temp value;
+                if (findLoad(key, preheader, &value)) {
+                    replaceValue(m, bb, value, replaceUses, defUses, W);
+                    return;
+                }
+                if (destination != header)
+                    break;
+            }
+
+            destination = preheader;
+        }
+
+        if (destination == bb)
+            return;
+
+        bb->removeStatement(m);
+        destination->insertStatementBeforeTerminator(m);
+        defUses.setDefStmtBlock(*m->target->asTemp(), destination);
+    }
+};
+
+// Dominator based global value numbering: a pure value that is already computed in a dominating
+// block is reused instead of being computed again. Loads are only reused within a basic block,
+// when there are no statements with side effects between the two loads.
+class GlobalValueNumbering
+{
+    DefUses &defUses;
+    DominatorTree &dt;
+    StatementWorklist &W;
+    ExprReplacer replaceUses;
+    QHash<QString, Temp> values;
+
+    struct Visit {
+        BasicBlock *bb;
+        int scopeStart; // -1 when entering the block
+    };
+
+public:
+    GlobalValueNumbering(DefUses &defUses, DominatorTree &dt, StatementWorklist &W)
+        : defUses(defUses)
+        , dt(dt)
+        , W(W)
+        , replaceUses(defUses, W.function())
+    {}
+
+    void run(IR::Function *function)
+    {
+        std::vector<std::vector<BasicBlock *> > children(function->basicBlockCount());
+        std::vector<BasicBlock *> roots;
+        foreach (BasicBlock *bb, function->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+            if (BasicBlock *idom = dt.immediateDominator(bb))
+                children[idom->index()].push_back(bb);
+            else
+                roots.push_back(bb);
+        }
+
+        // Walk the dominator tree depth-first. The values numbered in a block are only visible
+        // in the blocks it dominates, so they are dropped again when the walk leaves the block.
+        std::vector<Visit> stack;
+        std::vector<QString> scope;
+        foreach (BasicBlock *root, roots) {
+            Visit rootVisit = { root, -1 };
+            stack.push_back(rootVisit);
+        }
+        while (!stack.empty()) {
+            Visit visit = stack.back();
+            stack.pop_back();
+
+            if (visit.scopeStart != -1) {
+                for (int i = int(scope.size()) - 1; i >= visit.scopeStart; --i)
+                    values.remove(scope.at(i));
+                scope.resize(visit.scopeStart);
+                continue;
+            }
+
+            Visit leave = { visit.bb, int(scope.size()) };
+            stack.push_back(leave);
+            numberValues(visit.bb, &scope);
+            foreach (BasicBlock *child, children[visit.bb->index()]) {
+                Visit enter = { child, -1 };
+                stack.push_back(enter);
+            }
+        }
+    }
+
+private:
+    void numberValues(BasicBlock *bb, std::vector<QString> *scope)
+    {
+        QHash<QString, Temp> loads;
+        QString key;
+        foreach (Stmt *s, bb->statements()) {
+            Move *m = s->asMove();
+            const ValueKind kind = m ? valueKey(m, &key) : (hasSideEffects(s) ? SideEffects : NoValue);
+            if (kind == SideEffects) {
+                loads.clear();
+                continue;
+            }
+            if (kind == NoValue)
+                continue;
+
+            QHash<QString, Temp> &table = kind == PureValue ? values : loads;
+            QHash<QString, Temp>::const_iterator it = table.constFind(key);
+            if (it != table.constEnd()) {
+                replaceValue(m, bb, *it, replaceUses, defUses, W);
+            } else {
+                table.insert(key, *m->target->asTemp());
+                if (kind == PureValue)
+                    scope->push_back(key);
+            }
+        }
+    }
+};
+
+//### TODO: use DefUses from the optimizer, because it already has all this information
+class InputOutputCollector: protected StmtVisitor, protected ExprVisitor {
+    void setOutput(Temp *out)
+    {
+        Q_ASSERT(!output);
+        output = out;
+    }
+
+public:
+    std::vector<Temp *> inputs;
+    Temp *output;
+
+    InputOutputCollector()
+    { inputs.reserve(4); }
+
+    void collect(Stmt *s) {
+        inputs.resize(0);
+        output = 0;
+        s->accept(this);
+    }
+
+protected:
+    virtual void visitConst(Const *) {}
+    virtual void visitString(IR::String *) {}
+    virtual void visitRegExp(IR::RegExp *) {}
+    virtual void visitName(Name *) {}
+    virtual void visitTemp(Temp *e) {
+        inputs.push_back(e);
+    }
+    virtual void visitArgLocal(ArgLocal *) {}
+    virtual void visitClosure(Closure *) {}
+    virtual void visitConvert(Convert *e) { e->expr->accept(this); }
+    virtual void visitUnop(Unop *e) { e->expr->accept(this); }
+    virtual void visitBinop(Binop *e) { e->left->accept(this); e->right->accept(this); }
+    virtual void visitCall(Call *e) {
+        e->base->accept(this);
+        for (ExprList *it = e->args; it; it = it->next)
+            it->expr->accept(this);
+    }
+    virtual void visitNew(New *e) {
+        e->base->accept(this);
+        for (ExprList *it = e->args; it; it = it->next)
+            it->expr->accept(this);
+    }
+    virtual void visitSubscript(Subscript *e) { e->base->accept(this); e->index->accept(this); }
+    virtual void visitMember(Member *e) { e->base->accept(this); }
+    virtual void visitExp(Exp *s) { s->expr->accept(this); }
+    virtual void visitMove(Move *s) {
+        s->source->accept(this);
+        if (Temp *t = s->target->asTemp()) {
+            setOutput(t);
+        } else {
+            s->target->accept(this);
+        }
+    }
+    virtual void visitJump(Jump *) {}
+    virtual void visitCJump(CJump *s) { s->cond->accept(this); }
+    virtual void visitRet(Ret *s) { s->expr->accept(this); }
+    virtual void visitPhi(Phi *) {
+        // Handled separately
+    }
+};
+
+/*
+ * The algorithm is described in:
+ *
+ *   Linear Scan Register Allocation on SSA Form
+ *   Christian Wimmer & Michael Franz, CGO'10, April 24-28, 2010
+ *
+ * See LifeTimeIntervals::renumber for details on the numbering.
+ */
+class LifeRanges {
+    typedef QSet<Temp> LiveRegs;
+
+    std::vector<LiveRegs> _liveIn;
+    std::vector<LifeTimeInterval *> _intervals;
+    LifeTimeIntervals::Ptr _sortedIntervals;
+
+    LifeTimeInterval &interval(const Temp *temp)
+    {
+        LifeTimeInterval *&lti = _intervals[temp->index];
+        if (Q_UNLIKELY(!lti)) {
+            lti = new LifeTimeInterval;
+            lti->setTemp(*temp);
+        }
+        return *lti;
+    }
+
+    int defPosition(IR::Stmt *s) const
+    {
+        return usePosition(s) + 1;
+    }
+
+    int usePosition(IR::Stmt *s) const
+    {
+        return _sortedIntervals->positionForStatement(s);
+    }
+
+    int start(IR::BasicBlock *bb) const
+    {
+        return _sortedIntervals->startPosition(bb);
+    }
+
+    int end(IR::BasicBlock *bb) const
+    {
+        return _sortedIntervals->endPosition(bb);
+    }
+
+public:
+    LifeRanges(IR::Function *function, const QHash<BasicBlock *, BasicBlock *> &startEndLoops)
+        : _intervals(function->tempCount)
+    {
+        _sortedIntervals = LifeTimeIntervals::create(function);
+        _liveIn.resize(function->basicBlockCount());
+
+        for (int i = function->basicBlockCount() - 1; i >= 0; --i) {
+            BasicBlock *bb = function->basicBlock(i);
+            buildIntervals(bb, startEndLoops.value(bb, 0));
+        }
+
+        _intervals.clear();
+    }
+
+    LifeTimeIntervals::Ptr intervals() const { return _sortedIntervals; }
 
-    LifeTimeIntervals::Ptr intervals() const { return _sortedIntervals; }
-
     void dump() const
     {
         QBuffer buf;
@@ -4485,7 +5484,11 @@ public:
 
     void toTemps()
     {
-        if (function->variablesCanEscape())
+        // Argument types can only be relied on when the formals are read once, on entry.
+        if (!convertArgs || function->variablesCanEscape() || function->hasLoopEntries)
+            function->formalTypes.clear();
+
+        if (function->variablesCanEscape() || function->hasLoopEntries)
             return;
 
         QVector<Stmt *> extraMoves;
@@ -4506,7 +5509,23 @@ public:
 
                 Move *m = function->NewStmt<Move>();
                 m->init(target, source);
-                extraMoves[i] = m;
+                extraMoves[i] = m;
+            }
+        }
+
+        if (function->isLoopEntry) {
+            // The locals have been assigned to before entering, so they are read just like the
+            // arguments.
+            for (int i = 0, ei = function->locals.size(); i != ei; ++i) {
+                ArgLocal *source = function->New<ArgLocal>();
+                source->init(ArgLocal::Local, i, 0);
+
+                Temp *target = function->New<Temp>();
+                target->init(Temp::VirtualRegister, fetchTempForLocal(i));
+
+                Move *m = function->NewStmt<Move>();
+                m->init(target, source);
+                extraMoves.append(m);
             }
         }
 
@@ -4515,7 +5534,7 @@ public:
                 foreach (Stmt *s, bb->statements())
                     s->accept(this);
 
-        if (convertArgs && function->formals.size() > 0)
+        if (!extraMoves.isEmpty())
             function->basicBlock(0)->prependStatements(extraMoves);
 
         function->locals.clear();
@@ -4927,6 +5946,397 @@ static void verifyNoPointerSharing(IR::Function *function)
     V(function);
 }
 
+enum {
+    MaxInlinedCalleeStatements = 24,
+    MaxInlinedStatementsPerFunction = 256
+};
+
+// In functions that are inside a with or a catch, or that can see a direct eval, names can
+// resolve at run-time to something else than what the code generator saw.
+static bool hasStaticScopeChain(IR::Function *f)
+{
+    for (; f; f = f->outer) {
+        if (f->hasDirectEval || f->hasWith || f->hasTry)
+            return false;
+    }
+    return true;
+}
+
+static IR::Function *enclosingFunction(IR::Function *f, unsigned scope)
+{
+    while (f && scope--)
+        f = f->outer;
+    return f;
+}
+
+static bool declaresName(IR::Function *f, const QString &name)
+{
+    if (f->isNamedExpression && *f->name == name)
+        return true;
+    foreach (const QString *formal, f->formals) {
+        if (*formal == name)
+            return true;
+    }
+    foreach (const QString *local, f->locals) {
+        if (*local == name)
+            return true;
+    }
+    return false;
+}
+
+// Collects what the inliner needs to know about a callee: its size, the names it looks up at
+// run-time, and which enclosing scopes it reaches into. Only leaf functions are considered, so an
+// inlined callee is never missing from a stack trace of a call it makes.
+class InlineCandidate: protected StmtVisitor, protected ExprVisitor
+{
+public:
+    InlineCandidate(IR::Function *callee)
+        : callee(callee)
+        , statementCount(0)
+        , inlinable(true)
+    {
+        foreach (BasicBlock *bb, callee->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+            if (bb->catchBlock || bb->isExceptionHandler())
+                inlinable = false;
+            statementCount += bb->statementCount();
+        }
+    }
+
+    int size() const
+    { return statementCount; }
+
+    // On success, scopes maps the scope count of every enclosing local the callee uses to the
+    // scope count of the same local when seen from the caller.
+    bool canBeInlinedInto(IR::Function *caller, QVector<int> *scopes)
+    {
+        if (!inlinable || statementCount > MaxInlinedCalleeStatements)
+            return false;
+        if (callee == caller || !callee->nestedFunctions.isEmpty() || callee->hasDirectEval
+                || callee->usesArgumentsObject || callee->usesThis || callee->isNamedExpression
+                || callee->isStrict != caller->isStrict || !hasStaticScopeChain(callee))
+            return false;
+
+        foreach (BasicBlock *bb, callee->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+            foreach (Stmt *s, bb->statements()) {
+                s->accept(this);
+                if (!inlinable)
+                    return false;
+            }
+        }
+
+        // A name the callee looks up must not be declared anywhere between the caller and the
+        // global scope, otherwise the copy would find the declaration instead.
+        foreach (const QString *name, names) {
+            for (IR::Function *f = caller; f; f = f->outer) {
+                if (declaresName(f, *name))
+                    return false;
+            }
+        }
+
+        scopes->fill(-1, usedScopes.isEmpty() ? 0 : *std::max_element(usedScopes.begin(), usedScopes.end()) + 1);
+        foreach (unsigned scope, usedScopes) {
+            IR::Function *declaringFunction = enclosingFunction(callee, scope);
+            IR::Function *f = caller;
+            int distance = 0;
+            while (f && f != declaringFunction) {
+                f = f->outer;
+                ++distance;
+            }
+            if (!f)
+                return false;
+            (*scopes)[scope] = distance;
+        }
+
+        return true;
+    }
+
+protected:
+    virtual void visitExp(Exp *s) { s->expr->accept(this); }
+    virtual void visitMove(Move *s) { s->target->accept(this); s->source->accept(this); }
+    virtual void visitJump(Jump *) {}
+    virtual void visitCJump(CJump *s) { s->cond->accept(this); }
+    virtual void visitRet(Ret *s) { s->expr->accept(this); }
+    virtual void visitPhi(Phi *) { inlinable = false; }
+
+    virtual void visitConst(Const *) {}
+    virtual void visitString(IR::String *) {}
+    virtual void visitRegExp(IR::RegExp *) {}
+    virtual void visitTemp(Temp *) {}
+    virtual void visitClosure(Closure *) { inlinable = false; }
+    virtual void visitConvert(Convert *e) { e->expr->accept(this); }
+    virtual void visitUnop(Unop *e) { e->expr->accept(this); }
+    virtual void visitBinop(Binop *e) { e->left->accept(this); e->right->accept(this); }
+    virtual void visitNew(New *) { inlinable = false; }
+    virtual void visitSubscript(Subscript *e) { e->base->accept(this); e->index->accept(this); }
+    virtual void visitMember(Member *e) { e->base->accept(this); }
+
+    virtual void visitName(Name *e)
+    {
+        if (e->id) {
+            if (*e->id == QLatin1String("this"))
+                inlinable = false;
+            else if (!e->global)
+                names.append(e->id);
+        }
+    }
+
+    virtual void visitArgLocal(ArgLocal *e)
+    {
+        if (e->isArgumentsOrEval)
+            inlinable = false;
+        else if (e->scope && !usedScopes.contains(e->scope))
+            usedScopes.append(e->scope);
+    }
+
+    virtual void visitCall(Call *e)
+    {
+        Name *n = e->base->asName();
+        if (!n || n->builtin == Name::builtin_invalid) {
+            inlinable = false;
+            return;
+        }
+
+        switch (n->builtin) {
+        case Name::builtin_throw:
+        case Name::builtin_rethrow:
+        case Name::builtin_unwind_exception:
+        case Name::builtin_push_catch_scope:
+        case Name::builtin_push_with_scope:
+        case Name::builtin_pop_scope:
+        case Name::builtin_declare_vars:
+        case Name::builtin_setup_argument_object:
+        case Name::builtin_convert_this_to_object:
+            inlinable = false;
+            return;
+        default:
+            break;
+        }
+
+        for (ExprList *it = e->args; it; it = it->next)
+            it->expr->accept(this);
+    }
+
+private:
+    IR::Function *callee;
+    int statementCount;
+    bool inlinable;
+    QVector<const QString *> names;
+    QVector<unsigned> usedScopes;
+};
+
+// Copies the body of a callee into a caller. The temps of the callee are moved past the ones of
+// the caller, its arguments and locals become temps too, and locals of enclosing functions get
+// the scope count they have when seen from the caller. A return stores the result and continues
+// in the block after the call.
+class InlinedBody: protected StmtVisitor, protected CloneExpr
+{
+public:
+    InlinedBody(IR::Function *caller, IR::Function *callee, const QVector<int> &scopes)
+        : caller(caller)
+        , callee(callee)
+        , scopes(scopes)
+        , tempOffset(0)
+        , result(0)
+        , continuation(0)
+        , original(0)
+    {}
+
+    // Returns the block that binds the arguments and then jumps into the copied body.
+    BasicBlock *operator()(ExprList *args, Expr *result, BasicBlock *continuation,
+                           BasicBlock *group, const QQmlJS::AST::SourceLocation &location)
+    {
+        this->result = result;
+        this->continuation = continuation;
+        BasicBlock *catchBlock = continuation->catchBlock;
+
+        tempOffset = caller->tempCount;
+        caller->tempCount += callee->tempCount;
+
+        BasicBlock *entry = caller->newBasicBlock(catchBlock);
+        entry->setContainingGroup(group);
+        CloneExpr cloneArg(entry);
+        for (int i = 0, ei = callee->formals.size(); i != ei; ++i) {
+            const unsigned t = entry->newTemp();
+            tempForFormal.append(t);
+            Expr *value = args ? cloneArg(args->expr) : entry->CONST(UndefinedType, 0);
+            entry->MOVE(entry->TEMP(t), value)->location = location;
+            if (args)
+                args = args->next;
+        }
+        for (int i = 0, ei = callee->locals.size(); i != ei; ++i)
+            tempForLocal.append(entry->newTemp());
+
+        copies.resize(callee->basicBlockCount());
+        foreach (BasicBlock *bb, callee->basicBlocks()) {
+            if (!bb->isRemoved())
+                copies[bb->index()] = caller->newBasicBlock(catchBlock);
+        }
+
+        foreach (BasicBlock *bb, callee->basicBlocks()) {
+            if (bb->isRemoved())
+                continue;
+
+            BasicBlock *copy = mapped(bb);
+            copy->setContainingGroup(bb->containingGroup() ? mapped(bb->containingGroup()) : group);
+            copy->markAsGroupStart(bb->isGroupStart());
+            foreach (BasicBlock *in, bb->in)
+                copy->in.append(mapped(in));
+            foreach (BasicBlock *out, bb->out)
+                copy->out.append(mapped(out));
+
+            setBasicBlock(copy);
+            foreach (Stmt *s, bb->statements()) {
+                original = s;
+                s->accept(this);
+            }
+        }
+
+        entry->JUMP(mapped(callee->basicBlock(0)))->location = location;
+        return entry;
+    }
+
+protected:
+    BasicBlock *mapped(BasicBlock *bb) const
+    { return copies.at(bb->index()); }
+
+    // The statements keep the location they have in the callee, so an error raised in the copy
+    // still reports the line it comes from.
+    void append(Stmt *s)
+    {
+        block->appendStatement(s);
+        s->location = original->location;
+    }
+
+    virtual void visitExp(Exp *s)
+    {
+        Exp *newExp = caller->NewStmt<Exp>();
+        newExp->init(clone(s->expr));
+        append(newExp);
+    }
+
+    virtual void visitMove(Move *s)
+    {
+        Move *newMove = caller->NewStmt<Move>();
+        newMove->init(clone(s->target), clone(s->source));
+        newMove->swap = s->swap;
+        append(newMove);
+    }
+
+    virtual void visitJump(Jump *s)
+    {
+        Jump *newJump = caller->NewStmt<Jump>();
+        newJump->init(mapped(s->target));
+        append(newJump);
+    }
+
+    virtual void visitCJump(CJump *s)
+    {
+        CJump *newCJump = caller->NewStmt<CJump>();
+        newCJump->init(clone(s->cond), mapped(s->iftrue), mapped(s->iffalse), block);
+        append(newCJump);
+    }
+
+    virtual void visitRet(Ret *s)
+    {
+        if (result) {
+            Move *store = caller->NewStmt<Move>();
+            store->init(CloneExpr(block)(result), clone(s->expr));
+            append(store);
+        }
+
+        Jump *jump = caller->NewStmt<Jump>();
+        jump->init(continuation);
+        append(jump);
+        block->out.append(continuation);
+        continuation->in.append(block);
+    }
+
+    virtual void visitPhi(Phi *) { Q_UNREACHABLE(); }
+
+    virtual void visitTemp(Temp *e)
+    {
+        Temp *newTemp = cloneTemp(e, caller);
+        newTemp->index = e->index + tempOffset;
+        cloned = newTemp;
+    }
+
+    virtual void visitArgLocal(ArgLocal *e)
+    {
+        if (e->kind == ArgLocal::Formal)
+            cloned = block->TEMP(tempForFormal.at(e->index));
+        else if (e->kind == ArgLocal::Local)
+            cloned = block->TEMP(tempForLocal.at(e->index));
+        else if (e->kind == ArgLocal::ScopedFormal)
+            cloned = block->ARG(e->index, scopes.at(e->scope));
+        else
+            cloned = block->LOCAL(e->index, scopes.at(e->scope));
+    }
+
+    virtual void visitMember(Member *e)
+    {
+        Expr *clonedBase = clone(e->base);
+        Member *newMember = block->MEMBER(clonedBase, e->name, e->property, e->kind, e->attachedPropertiesIdOrEnumValue)->asMember();
+        newMember->freeOfSideEffects = e->freeOfSideEffects;
+        newMember->inhibitTypeConversionOnWrite = e->inhibitTypeConversionOnWrite;
+        newMember->plainLoad = e->plainLoad;
+        cloned = newMember;
+    }
+
+private:
+    IR::Function *caller;
+    IR::Function *callee;
+    const QVector<int> &scopes;
+    unsigned tempOffset;
+    Expr *result;
+    BasicBlock *continuation;
+    Stmt *original;
+    QVector<unsigned> tempForFormal;
+    QVector<unsigned> tempForLocal;
+    QVector<BasicBlock *> copies;
+};
+
+// Moves the statements of a block from the given index on into a new block, which also takes over
+// the outgoing edges.
+static BasicBlock *splitBlock(BasicBlock *bb, int index)
+{
+    BasicBlock *tail = bb->function->newBasicBlock(bb->catchBlock);
+    tail->setContainingGroup(bb->isGroupStart() ? bb : bb->containingGroup());
+    tail->setStatements(bb->statements().mid(index));
+    while (bb->statementCount() > index)
+        bb->removeStatement(bb->statementCount() - 1);
+
+    if (Stmt *terminator = tail->terminator()) {
+        if (CJump *cjump = terminator->asCJump())
+            cjump->parent = tail;
+    }
+
+    tail->out = bb->out;
+    bb->out.clear();
+    foreach (BasicBlock *out, tail->out) {
+        const int idx = out->in.indexOf(bb);
+        Q_ASSERT(idx != -1);
+        out->in[idx] = tail;
+    }
+
+    return tail;
+}
+
+static void mergeDependencies(IR::Function *caller, IR::Function *callee)
+{
+    caller->maxNumberOfArguments = qMax(caller->maxNumberOfArguments, callee->maxNumberOfArguments);
+    caller->idObjectDependencies += callee->idObjectDependencies;
+    for (PropertyDependencyMap::const_iterator it = callee->contextObjectPropertyDependencies.constBegin(),
+         end = callee->contextObjectPropertyDependencies.constEnd(); it != end; ++it)
+        caller->contextObjectPropertyDependencies.insert(it.key(), it.value());
+    for (PropertyDependencyMap::const_iterator it = callee->scopeObjectPropertyDependencies.constBegin(),
+         end = callee->scopeObjectPropertyDependencies.constEnd(); it != end; ++it)
+        caller->scopeObjectPropertyDependencies.insert(it.key(), it.value());
+}
+
 } // anonymous namespace
 
 void LifeTimeInterval::setFrom(int from) {
@@ -5204,24 +6614,32 @@ void Optimizer::run(QQmlEnginePrivate *qmlEngine, bool doTypeInference, bool pee
         cleanupPhis(defUses);
         showMeTheCode(function, "After cleaning up phi-nodes");
 
+        static bool doOpt = qgetenv("QV4_NO_OPT").isEmpty();
+        if (doOpt) {
+            ScalarReplacement(defUses).run(function);
+            showMeTheCode(function, "After scalar replacement");
+        }
+
         StatementWorklist worklist(function);
 
         if (doTypeInference) {
 //            qout << "Running type inference..." << endl;
-            TypeInference(qmlEngine, defUses).run(worklist);
+            TypeInference(qmlEngine, function, defUses).run(worklist);
             showMeTheCode(function, "After type inference");
 
 //            qout << "Doing reverse inference..." << endl;
             ReverseInference(defUses).run(function);
 //            showMeTheCode(function);
 
+            RangeAnalysis(defUses, df).run(function);
+            showMeTheCode(function, "After range analysis");
+
 //            qout << "Doing type propagation..." << endl;
             TypePropagation(defUses).run(function, worklist);
 //            showMeTheCode(function);
             verifyNoPointerSharing(function);
         }
 
-        static bool doOpt = qgetenv("QV4_NO_OPT").isEmpty();
         if (doOpt) {
 //            qout << "Running SSA optimization..." << endl;
             worklist.reset();
@@ -5241,6 +6659,17 @@ void Optimizer::run(QQmlEnginePrivate *qmlEngine, bool doTypeInference, bool pee
         cleanupBasicBlocks(function);
 //        showMeTheCode(function);
 
+        // Both passes rely on the types to know which operations can't have side effects.
+        if (doOpt && doTypeInference) {
+            LoopInvariantCodeMotion(defUses, df, worklist).run(function);
+            showMeTheCode(function, "After loop-invariant code motion");
+
+            GlobalValueNumbering(defUses, df, worklist).run(function);
+            showMeTheCode(function, "After global value numbering");
+
+            verifyCFG(function);
+        }
+
         // Transform the CFG into edge-split SSA.
 //        qout << "Starting edge splitting..." << endl;
         splitCriticalEdges(function, df, worklist, defUses);
@@ -5366,6 +6795,251 @@ void Optimizer::showMeTheCode(IR::Function *function, const char *marker)
     ::showMeTheCode(function, marker);
 }
 
+Inliner::Inliner(Module *module)
+    : module(module)
+{
+}
+
+void Inliner::run()
+{
+    static const bool doInline = qgetenv("QV4_NO_INLINE").isEmpty();
+    if (!doInline || module->debugMode || module->callsInlined)
+        return;
+    module->callsInlined = true;
+
+    foreach (Function *caller, module->functions) {
+        if (hasStaticScopeChain(caller))
+            inlineCalls(caller);
+    }
+}
+
+// The binding a call goes through can always be changed at run-time, so the result is only the
+// function it is most likely to call: a function declared in an enclosing function and called
+// through the local that holds it, or a function declared in global code. scopeDepth is set to the
+// number of scopes between the caller and the one the callee is declared in.
+IR::Function *Inliner::resolveCallee(IR::Function *caller, Expr *base, int *scopeDepth) const
+{
+    Function *scope = 0;
+    const QString *name = 0;
+    if (ArgLocal *al = base->asArgLocal()) {
+        if (al->kind != ArgLocal::Local && al->kind != ArgLocal::ScopedLocal)
+            return 0;
+        scope = enclosingFunction(caller, al->scope);
+        if (!scope || al->index >= unsigned(scope->locals.size()))
+            return 0;
+        name = scope->locals.at(al->index);
+        *scopeDepth = al->scope;
+    } else if (Name *n = base->asName()) {
+        if (n->builtin != Name::builtin_invalid || !n->id)
+            return 0;
+        scope = module->rootFunction;
+        name = n->id;
+        *scopeDepth = 0;
+        for (Function *f = caller; f && f != scope; f = f->outer)
+            ++*scopeDepth;
+    }
+    if (!scope)
+        return 0;
+
+    Function *callee = 0;
+    foreach (Function *nested, scope->nestedFunctions) {
+        if (nested->isNamedExpression || *nested->name != *name)
+            continue;
+        if (callee) // declared more than once
+            return 0;
+        callee = nested;
+    }
+    return callee;
+}
+
+// A call is replaced by:
+//     f = <callee>
+//     ok = builtin_is_closure(f, <index of the callee>, <scopes up to the one it is declared in>)
+//     if ok goto inlined else goto call
+// inlined:
+//     <arguments and body of the callee>
+//     goto continuation
+// call:
+//     <the original call>
+//     goto continuation
+// continuation:
+//     <rest of the block>
+void Inliner::inlineCalls(IR::Function *caller)
+{
+    int budget = MaxInlinedStatementsPerFunction;
+    bool changed = false;
+
+    // Only the original blocks (and the parts they get split into) are visited, so calls in the
+    // inlined code stay as they are.
+    for (int i = 0, ei = caller->basicBlockCount(); i != ei; ++i) {
+        BasicBlock *bb = caller->basicBlock(i);
+        if (bb->isRemoved())
+            continue;
+
+        for (int s = 0; s < bb->statementCount(); ++s) {
+            Stmt *stmt = bb->statements().at(s);
+            Call *call = 0;
+            Expr *result = 0;
+            if (Move *m = stmt->asMove()) {
+                call = m->source->asCall();
+                result = m->target;
+                if (!result->asTemp() && !result->asArgLocal())
+                    continue;
+            } else if (Exp *e = stmt->asExp()) {
+                call = e->expr->asCall();
+            }
+            if (!call)
+                continue;
+
+            int scopeDepth = 0;
+            Function *callee = resolveCallee(caller, call->base, &scopeDepth);
+            if (!callee)
+                continue;
+            InlineCandidate candidate(callee);
+            QVector<int> scopes;
+            if (candidate.size() > budget || !candidate.canBeInlinedInto(caller, &scopes))
+                continue;
+            budget -= candidate.size();
+
+            const QQmlJS::AST::SourceLocation location = stmt->location;
+            BasicBlock *group = bb->isGroupStart() ? bb : bb->containingGroup();
+            BasicBlock *continuation = splitBlock(bb, s + 1);
+            bb->removeStatement(s);
+
+            BasicBlock *slowPath = caller->newBasicBlock(bb->catchBlock);
+            slowPath->setContainingGroup(group);
+            slowPath->appendStatement(stmt);
+            slowPath->JUMP(continuation)->location = location;
+
+            BasicBlock *inlined = InlinedBody(caller, callee, scopes)(call->args, result, continuation,
+                                                                      group, location);
+
+            const unsigned closure = bb->newTemp();
+            bb->MOVE(bb->TEMP(closure), CloneExpr(bb)(call->base))->location = location;
+            ExprList *depth = caller->New<ExprList>();
+            depth->init(bb->CONST(NumberType, scopeDepth));
+            ExprList *functionIndex = caller->New<ExprList>();
+            functionIndex->init(bb->CONST(NumberType, module->functions.indexOf(callee)), depth);
+            ExprList *args = caller->New<ExprList>();
+            args->init(bb->TEMP(closure), functionIndex);
+            const unsigned isClosure = bb->newTemp();
+            bb->MOVE(bb->TEMP(isClosure), bb->CALL(bb->NAME(Name::builtin_is_closure, location.startLine, location.startColumn), args))->location = location;
+            bb->CJUMP(bb->TEMP(isClosure), inlined, slowPath)->location = location;
+
+            mergeDependencies(caller, callee);
+            changed = true;
+
+            bb = continuation;
+            s = -1;
+        }
+    }
+
+    if (changed)
+        showMeTheCode(caller, "After inlining");
+}
+
+QVector<int> OnStackReplacement::loopHeaders(IR::Function *function)
+{
+    QVector<int> headers;
+    if (function->hasTry || function->hasWith || function->hasDirectEval
+            || function->module->debugMode)
+        return headers;
+
+    cleanupBasicBlocks(function);
+
+    {
+        DominatorTree df(function);
+        LoopDetection loopDetection(df);
+        loopDetection.run(function);
+        foreach (LoopDetection::LoopInfo *loop, loopDetection.allLoops()) {
+            if (loop->loopHeader->index() != 0)
+                headers.append(loop->loopHeader->index());
+        }
+    }
+
+    // The loop detection stores the loops it finds in the blocks, and the optimizer expects to
+    // start out without them.
+    foreach (BasicBlock *bb, function->basicBlocks()) {
+        if (bb->isRemoved())
+            continue;
+        bb->setContainingGroup(0);
+        bb->markAsGroupStart(false);
+    }
+
+    if (headers.isEmpty())
+        return headers;
+
+    // Temporaries that are live at a loop header would be lost when continuing there, so only
+    // the headers where everything is in variables qualify.
+    const int blockCount = function->basicBlockCount();
+    QVector<QBitArray> uses(blockCount), defs(blockCount), liveIn(blockCount);
+    InputOutputCollector collector;
+    foreach (BasicBlock *bb, function->basicBlocks()) {
+        if (bb->isRemoved())
+            continue;
+        QBitArray &used = uses[bb->index()];
+        QBitArray &defined = defs[bb->index()];
+        used.resize(function->tempCount);
+        defined.resize(function->tempCount);
+        liveIn[bb->index()].resize(function->tempCount);
+        foreach (Stmt *s, bb->statements()) {
+            collector.collect(s);
+            for (size_t i = 0, ei = collector.inputs.size(); i != ei; ++i) {
+                if (!defined.testBit(collector.inputs[i]->index))
+                    used.setBit(collector.inputs[i]->index);
+            }
+            if (collector.output)
+                defined.setBit(collector.output->index);
+        }
+    }
+
+    for (bool changed = true; changed; ) {
+        changed = false;
+        for (int i = blockCount - 1; i >= 0; --i) {
+            BasicBlock *bb = function->basicBlock(i);
+            if (bb->isRemoved())
+                continue;
+            QBitArray live(function->tempCount);
+            foreach (BasicBlock *out, bb->out)
+                live |= liveIn.at(out->index());
+            live &= ~defs.at(i);
+            live |= uses.at(i);
+            if (live != liveIn.at(i)) {
+                liveIn[i] = live;
+                changed = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < headers.size(); ) {
+        if (liveIn.at(headers.at(i)).count(true) == 0)
+            ++i;
+        else
+            headers.remove(i);
+    }
+
+    return headers;
+}
+
+IR::Function *OnStackReplacement::createLoopEntry(IR::Function *function, int loopHeader)
+{
+    IR::Function *entry = function->module->cloneFunction(function);
+    entry->isLoopEntry = true;
+    entry->formalTypes.clear(); // the arguments may have been assigned to by then
+
+    // The start block is reduced to a jump to the loop header. Whatever it did before has
+    // already happened when the function is entered this way.
+    BasicBlock *start = entry->basicBlock(0);
+    foreach (BasicBlock *out, start->out)
+        out->in.remove(out->in.indexOf(start));
+    start->out.clear();
+    while (!start->isEmpty())
+        start->removeStatement(start->statements().size() - 1);
+    start->JUMP(entry->basicBlock(loopHeader));
+
+    return entry;
+}
+
 static inline bool overlappingStorage(const Temp &t1, const Temp &t2)
 {
     // This is the same as the operator==, but for one detail: memory locations are not sensitive
@@ -227,6 +227,41 @@ private:
     QHash<BasicBlock *, BasicBlock *> startEndLoops;
 };
 
+// Replaces calls to small functions of the same module by a copy of the callee's body. The copy
+// is guarded by a check that the called value still is a closure of that function, and the
+// original call is kept as the fallback. Has to run before any function of the module is
+// optimized.
+class Q_QML_PRIVATE_EXPORT Inliner
+{
+    Q_DISABLE_COPY(Inliner)
+
+public:
+    Inliner(Module *module);
+
+    void run();
+
+private:
+    void inlineCalls(Function *caller);
+    Function *resolveCallee(Function *caller, Expr *base, int *scopeDepth) const;
+
+    Module *module;
+};
+
+// Lets the interpreter hand a function over to compiled code at the header of a hot loop. The
+// interpreter keeps all variables of such a function in its context (Function::hasLoopEntries),
+// and the compiled code runs a copy of the function that starts at the loop header and reads the
+// variables from there. Both work on the IR before any optimization pass has run.
+class Q_QML_PRIVATE_EXPORT OnStackReplacement
+{
+public:
+    // Returns the indices of the loop headers of the function at which no temporaries are live,
+    // so that the variables hold all of its state.
+    static QVector<int> loopHeaders(Function *function);
+
+    // Adds a copy of the function to its module that starts at the given loop header.
+    static Function *createLoopEntry(Function *function, int loopHeader);
+};
+
 class MoveMapping
 {
     struct Move {
@@ -52,22 +52,41 @@ QV4ProfilerAdapter::QV4ProfilerAdapter(QQmlProfilerService *service, QV4::Execut
     connect(this, SIGNAL(referenceTimeKnown(QElapsedTimer)),
             engine->profiler, SLOT(setTimer(QElapsedTimer)));
     connect(engine->profiler, SIGNAL(dataReady(QVector<QV4::Profiling::FunctionCallProperties>,
-                                               QVector<QV4::Profiling::MemoryAllocationProperties>)),
+                                               QVector<QV4::Profiling::MemoryAllocationProperties>,
+                                               QVector<QV4::Profiling::GarbageCollectionProperties>)),
             this, SLOT(receiveData(QVector<QV4::Profiling::FunctionCallProperties>,
-                                   QVector<QV4::Profiling::MemoryAllocationProperties>)));
+                                   QVector<QV4::Profiling::MemoryAllocationProperties>,
+                                   QVector<QV4::Profiling::GarbageCollectionProperties>)));
 }
 
 qint64 QV4ProfilerAdapter::appendMemoryEvents(qint64 until, QList<QByteArray> &messages)
 {
     QByteArray message;
-    while (!memory_data.empty() && memory_data.front().timestamp <= until) {
-        QQmlDebugStream d(&message, QIODevice::WriteOnly);
-        QV4::Profiling::MemoryAllocationProperties &props = memory_data.front();
-        d << props.timestamp << MemoryAllocation << props.type << props.size;
-        memory_data.pop_front();
-        messages.append(message);
+    while (true) {
+        const bool memoryNext = !memory_data.empty() && (gc_data.empty()
+                || memory_data.front().timestamp <= gc_data.front().timestamp);
+        if (memoryNext && memory_data.front().timestamp <= until) {
+            QQmlDebugStream d(&message, QIODevice::WriteOnly);
+            QV4::Profiling::MemoryAllocationProperties &props = memory_data.front();
+            d << props.timestamp << MemoryAllocation << props.type << props.size;
+            memory_data.pop_front();
+            messages.append(message);
+        } else if (!memoryNext && !gc_data.empty() && gc_data.front().timestamp <= until) {
+            QQmlDebugStream d(&message, QIODevice::WriteOnly);
+            QV4::Profiling::GarbageCollectionProperties &props = gc_data.front();
+            d << props.timestamp << GarbageCollection << props.pause << props.allocatedBytes
+              << props.heapSize << props.usedMemory << props.largeItemsMemory;
+            gc_data.pop_front();
+            messages.append(message);
+        } else {
+            break;
+        }
     }
-    return memory_data.empty() ? -1 : memory_data.front().timestamp;
+
+    if (memory_data.empty())
+        return gc_data.empty() ? -1 : gc_data.front().timestamp;
+    return gc_data.empty() ? memory_data.front().timestamp
+                           : qMin(memory_data.front().timestamp, gc_data.front().timestamp);
 }
 
 qint64 QV4ProfilerAdapter::sendMessages(qint64 until, QList<QByteArray> &messages)
@@ -115,10 +134,12 @@ qint64 QV4ProfilerAdapter::sendMessages(qint64 until, QList<QByteArray> &message
 
 void QV4ProfilerAdapter::receiveData(
         const QVector<QV4::Profiling::FunctionCallProperties> &new_data,
-        const QVector<QV4::Profiling::MemoryAllocationProperties> &new_memory_data)
+        const QVector<QV4::Profiling::MemoryAllocationProperties> &new_memory_data,
+        const QVector<QV4::Profiling::GarbageCollectionProperties> &new_gc_data)
 {
     data = new_data;
     memory_data = new_memory_data;
+    gc_data = new_gc_data;
     stack.clear();
     service->dataReady(this);
 }
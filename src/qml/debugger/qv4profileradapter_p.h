@@ -64,11 +64,13 @@ public:
 
 public slots:
     void receiveData(const QVector<QV4::Profiling::FunctionCallProperties> &,
-                     const QVector<QV4::Profiling::MemoryAllocationProperties> &);
+                     const QVector<QV4::Profiling::MemoryAllocationProperties> &,
+                     const QVector<QV4::Profiling::GarbageCollectionProperties> &);
 
 private:
     QVector<QV4::Profiling::FunctionCallProperties> data;
     QVector<QV4::Profiling::MemoryAllocationProperties> memory_data;
+    QVector<QV4::Profiling::GarbageCollectionProperties> gc_data;
     QStack<qint64> stack;
     qint64 appendMemoryEvents(qint64 until, QList<QByteArray> &messages);
 };
@@ -8,6 +8,7 @@ HEADERS += \
     $$PWD/qv4regalloc_p.h \
     $$PWD/qv4targetplatform_p.h \
     $$PWD/qv4isel_masm_p.h \
+    $$PWD/qv4isel_tiered_p.h \
     $$PWD/qv4binop_p.h \
     $$PWD/qv4unop_p.h \
     $$PWD/qv4registerinfo_p.h
@@ -16,6 +17,7 @@ SOURCES += \
     $$PWD/qv4assembler.cpp \
     $$PWD/qv4regalloc.cpp \
     $$PWD/qv4isel_masm.cpp \
+    $$PWD/qv4isel_tiered.cpp \
     $$PWD/qv4binop.cpp \
     $$PWD/qv4unop.cpp \
 
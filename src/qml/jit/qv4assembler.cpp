@@ -45,6 +45,8 @@
 #include <assembler/LinkBuffer.h>
 #include <WTFStubs.h>
 
+#include <private/qqmldiskcache_p.h>
+
 #include <iostream>
 
 #if ENABLE(ASSEMBLER)
@@ -62,6 +64,10 @@ CompilationUnit::~CompilationUnit()
 
 void CompilationUnit::linkBackendToEngine(ExecutionEngine *engine)
 {
+    // Code is only written to the disk cache before the unit is linked.
+    relocations.clear();
+    relocations.squeeze();
+
     runtimeFunctions.resize(data->functionTableSize);
     runtimeFunctions.fill(0);
     for (int i = 0 ;i < runtimeFunctions.size(); ++i) {
@@ -83,6 +89,173 @@ QV4::ExecutableAllocator::ChunkOfPages *CompilationUnit::chunkForFunction(int fu
     return handle->chunk();
 }
 
+namespace {
+
+void relocationAnchor()
+{
+}
+
+typedef void (*ExternalFunction)();
+
+const char cachedCodeMagic[] = "masm";
+
+struct CachedCodeHeader {
+    char magic[4];
+    quint32 pointerSize;
+    quint32 valueSize;
+    quint32 functionCount;
+    quint32 constantTableCount;
+    char imageKey[20];
+};
+
+template <typename T>
+void storeData(QByteArray *data, const T &value)
+{
+    data->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool loadData(const QByteArray &data, int *offset, T *value)
+{
+    if (data.size() - *offset < int(sizeof(T)))
+        return false;
+    memcpy(value, data.constData() + *offset, sizeof(T));
+    *offset += sizeof(T);
+    return true;
+}
+
+} // anonymous namespace
+
+// External relocation targets are stored relative to relocationAnchor, so they are only valid for
+// the very same binary.
+qint64 CompilationUnit::externalTarget(const void *address)
+{
+    return qint64(quintptr(address)) - qint64(quintptr(reinterpret_cast<void *>(&relocationAnchor)));
+}
+
+bool CompilationUnit::saveCodeToDisk(QByteArray *code) const
+{
+    static const QByteArray key = QQmlDiskCache::imageKey();
+    if (key.size() != sizeof(CachedCodeHeader().imageKey) || relocations.size() != codeRefs.size())
+        return false;
+
+    CachedCodeHeader header;
+    memcpy(header.magic, cachedCodeMagic, sizeof(header.magic));
+    header.pointerSize = sizeof(void *);
+    header.valueSize = sizeof(QV4::Primitive);
+    header.functionCount = codeRefs.size();
+    header.constantTableCount = constantValues.size();
+    memcpy(header.imageKey, key.constData(), sizeof(header.imageKey));
+    storeData(code, header);
+
+    foreach (const QVector<QV4::Primitive> &table, constantValues) {
+        storeData(code, quint32(table.size()));
+        code->append(reinterpret_cast<const char *>(table.constData()), table.size() * sizeof(QV4::Primitive));
+    }
+
+    for (int i = 0; i < codeRefs.size(); ++i) {
+        JSC::ExecutableMemoryHandle *handle = codeRefs.at(i).executableMemory();
+        if (!handle)
+            return false;
+        const QVector<CodeRelocation> &functionRelocations = relocations.at(i);
+        storeData(code, quint32(handle->sizeInBytes()));
+        storeData(code, quint32(functionRelocations.size()));
+        code->append(reinterpret_cast<const char *>(functionRelocations.constData()),
+                     functionRelocations.size() * sizeof(CodeRelocation));
+        code->append(static_cast<const char *>(handle->start()), handle->sizeInBytes());
+    }
+    return true;
+}
+
+bool CompilationUnit::loadCodeFromDisk(ExecutionEngine *engine, const QByteArray &code)
+{
+    static const QByteArray key = QQmlDiskCache::imageKey();
+    int offset = 0;
+    CachedCodeHeader header;
+    if (!loadData(code, &offset, &header)
+            || memcmp(header.magic, cachedCodeMagic, sizeof(header.magic)) != 0
+            || header.pointerSize != sizeof(void *)
+            || header.valueSize != sizeof(QV4::Primitive)
+            || header.functionCount != data->functionTableSize
+            || key.size() != sizeof(header.imageKey)
+            || memcmp(header.imageKey, key.constData(), sizeof(header.imageKey)) != 0) {
+        return false;
+    }
+
+    QList<QVector<QV4::Primitive> > tables;
+    for (quint32 i = 0; i < header.constantTableCount; ++i) {
+        quint32 count;
+        if (!loadData(code, &offset, &count) || quint32(code.size() - offset) / sizeof(QV4::Primitive) < count)
+            return false;
+        QVector<QV4::Primitive> table(count);
+        memcpy(table.data(), code.constData() + offset, count * sizeof(QV4::Primitive));
+        offset += count * sizeof(QV4::Primitive);
+        tables.append(table);
+    }
+
+    const char *anchor = reinterpret_cast<const char *>(&relocationAnchor);
+    QVector<JSC::MacroAssemblerCodeRef> functions;
+    functions.reserve(header.functionCount);
+    for (quint32 i = 0; i < header.functionCount; ++i) {
+        quint32 size;
+        quint32 relocationCount;
+        if (!loadData(code, &offset, &size) || !loadData(code, &offset, &relocationCount)
+                || quint32(code.size() - offset) / sizeof(CodeRelocation) < relocationCount)
+            return false;
+        const CodeRelocation *functionRelocations = reinterpret_cast<const CodeRelocation *>(code.constData() + offset);
+        offset += relocationCount * sizeof(CodeRelocation);
+        if (size == 0 || quint32(code.size() - offset) < size)
+            return false;
+
+        RefPtr<JSC::ExecutableMemoryHandle> handle = adoptRef(new JSC::ExecutableMemoryHandle(engine->executableAllocator, size));
+        char *start = static_cast<char *>(handle->start());
+        memcpy(start, code.constData() + offset, size);
+        offset += size;
+
+        JSC::ExecutableAllocator::makeWritable(start, size);
+        for (quint32 r = 0; r < relocationCount; ++r) {
+            CodeRelocation relocation;
+            memcpy(&relocation, functionRelocations + r, sizeof(relocation));
+            if (relocation.offset > size || size - relocation.offset < sizeof(void *))
+                return false;
+            void *location = start + relocation.offset;
+            switch (relocation.kind) {
+            case CodeRelocation::ExternalCall:
+                JSC::MacroAssembler::repatchCall(JSC::CodeLocationCall(location),
+                                                 JSC::FunctionPtr(reinterpret_cast<ExternalFunction>(anchor + relocation.target)));
+                break;
+            case CodeRelocation::ExternalAddress:
+                JSC::MacroAssembler::repatchPointer(JSC::CodeLocationDataLabelPtr(location),
+                                                    const_cast<char *>(anchor + relocation.target));
+                break;
+            case CodeRelocation::ConstantTable:
+                if (relocation.target < 0 || relocation.target >= tables.size())
+                    return false;
+                JSC::MacroAssembler::repatchPointer(JSC::CodeLocationDataLabelPtr(location),
+                                                    const_cast<QV4::Primitive *>(tables.at(relocation.target).constData()));
+                break;
+            case CodeRelocation::CodeAddress:
+                if (relocation.target < 0 || relocation.target >= size)
+                    return false;
+                JSC::MacroAssembler::repatchPointer(JSC::CodeLocationDataLabelPtr(location),
+                                                    JSC::CodeLocationLabel(start + relocation.target).executableAddress());
+                break;
+            default:
+                return false;
+            }
+        }
+        JSC::ExecutableAllocator::makeExecutable(start, size);
+        functions.append(JSC::MacroAssemblerCodeRef(handle.release()));
+    }
+    if (offset != code.size())
+        return false;
+
+    // The code points into the tables, whose data is shared with constantValues.
+    constantValues = tables;
+    codeRefs = functions;
+    return true;
+}
+
 const Assembler::VoidType Assembler::Void;
 
 Assembler::Assembler(InstructionSelection *isel, IR::Function* function, QV4::ExecutableAllocator *executableAllocator)
@@ -63,6 +63,21 @@ namespace JIT {
 
 class InstructionSelection;
 
+// An absolute address embedded in generated code, recorded so that the code can be written to the
+// disk cache and patched when it is loaded into another process.
+struct CodeRelocation {
+    enum Kind {
+        ExternalCall,    // call to a runtime function, target is relative to the QtQml image
+        ExternalAddress, // pointer to static data, target is relative to the QtQml image
+        ConstantTable,   // pointer to a constant table, target is the index in constantValues
+        CodeAddress      // pointer into the code itself, target is the offset in the code
+    };
+
+    quint32 kind;
+    quint32 offset; // of the patched location in the code
+    qint64 target;
+};
+
 struct CompilationUnit : public QV4::CompiledData::CompilationUnit
 {
     virtual ~CompilationUnit();
@@ -71,10 +86,17 @@ struct CompilationUnit : public QV4::CompiledData::CompilationUnit
 
     virtual QV4::ExecutableAllocator::ChunkOfPages *chunkForFunction(int functionIndex);
 
+    virtual bool saveCodeToDisk(QByteArray *code) const;
+    virtual bool loadCodeFromDisk(QV4::ExecutionEngine *engine, const QByteArray &code);
+
+    static qint64 externalTarget(const void *address);
+
     // Coderef + execution engine
 
     QVector<JSC::MacroAssemblerCodeRef> codeRefs;
     QList<QVector<QV4::Primitive> > constantValues;
+    // Per function, only kept until the unit is linked to an engine.
+    QVector<QVector<CodeRelocation> > relocations;
 };
 
 struct RelativeCall {
@@ -291,7 +313,7 @@ public:
         int add(const QV4::Primitive &v);
         Address loadValueAddress(IR::Const *c, RegisterID baseReg);
         Address loadValueAddress(const QV4::Primitive &v, RegisterID baseReg);
-        void finalize(JSC::LinkBuffer &linkBuffer, InstructionSelection *isel);
+        void finalize(JSC::LinkBuffer &linkBuffer, InstructionSelection *isel, QVector<CodeRelocation> *relocations);
 
     private:
         Assembler *_as;
@@ -1140,7 +1162,7 @@ public:
         // it's not in signed int range, so load it as a double, and truncate it down
         loadDouble(addr, FPGpr0);
         static const double magic = double(INT_MAX) + 1;
-        move(TrustedImmPtr(&magic), scratchReg);
+        moveExternalAddress(&magic, scratchReg);
         subDouble(Address(scratchReg, 0), FPGpr0);
         Jump canNeverHappen = branchTruncateDoubleToUint32(FPGpr0, scratchReg);
         canNeverHappen.link(this);
@@ -1154,7 +1176,15 @@ public:
         return scratchReg;
     }
 
-    JSC::MacroAssemblerCodeRef link(int *codeSize);
+    void moveExternalAddress(const void *address, RegisterID dest)
+    {
+        ExternalAddress ea;
+        ea.dataLabel = moveWithPatch(TrustedImmPtr(address), dest);
+        ea.address = address;
+        _externalAddresses.append(ea);
+    }
+
+    JSC::MacroAssemblerCodeRef link(int *codeSize, QVector<CodeRelocation> *relocations);
 
     void setStackLayout(int maxArgCountForBuiltins, int regularRegistersToSave, int fpRegistersToSave);
     const StackLayout &stackLayout() const { return *_stackLayout.data(); }
@@ -1177,6 +1207,12 @@ private:
     };
     QList<DataLabelPatch> _dataLabelPatches;
 
+    struct ExternalAddress {
+        DataLabelPtr dataLabel;
+        const void *address;
+    };
+    QList<ExternalAddress> _externalAddresses;
+
     QHash<IR::BasicBlock *, QVector<DataLabelPtr> > _labelPatches;
     IR::BasicBlock *_nextBlock;
 
@@ -43,6 +43,7 @@
 #include "qv4assembler_p.h"
 #include "qv4unop_p.h"
 #include "qv4binop_p.h"
+#include "qv4perfmap_p.h"
 
 #include <QtCore/QBuffer>
 
@@ -120,7 +121,12 @@ static void printDisassembledOutputWithCalls(QByteArray processedOutput, const Q
     qDebug("%s", processedOutput.constData());
 }
 
-JSC::MacroAssemblerCodeRef Assembler::link(int *codeSize)
+static quint32 codeOffset(JSC::LinkBuffer &linkBuffer, void *location)
+{
+    return static_cast<char *>(location) - static_cast<char *>(linkBuffer.debugAddress());
+}
+
+JSC::MacroAssemblerCodeRef Assembler::link(int *codeSize, QVector<CodeRelocation> *relocations)
 {
     Label endOfCode = label();
 
@@ -143,10 +149,26 @@ JSC::MacroAssemblerCodeRef Assembler::link(int *codeSize)
     foreach (CallToLink ctl, _callsToLink) {
         linkBuffer.link(ctl.call, ctl.externalFunction);
         functions[linkBuffer.locationOf(ctl.label).dataLocation()] = ctl.functionName;
+        CodeRelocation r = { CodeRelocation::ExternalCall,
+                             codeOffset(linkBuffer, linkBuffer.locationOf(ctl.call).dataLocation()),
+                             CompilationUnit::externalTarget(ctl.externalFunction.executableAddress()) };
+        relocations->append(r);
     }
 
-    foreach (const DataLabelPatch &p, _dataLabelPatches)
+    foreach (const ExternalAddress &ea, _externalAddresses) {
+        CodeRelocation r = { CodeRelocation::ExternalAddress,
+                             codeOffset(linkBuffer, linkBuffer.locationOf(ea.dataLabel).dataLocation()),
+                             CompilationUnit::externalTarget(ea.address) };
+        relocations->append(r);
+    }
+
+    foreach (const DataLabelPatch &p, _dataLabelPatches) {
         linkBuffer.patch(p.dataLabel, linkBuffer.locationOf(p.target));
+        CodeRelocation r = { CodeRelocation::CodeAddress,
+                             codeOffset(linkBuffer, linkBuffer.locationOf(p.dataLabel).dataLocation()),
+                             linkBuffer.offsetOf(p.target) };
+        relocations->append(r);
+    }
 
     // link exception handlers
     foreach(Jump jump, exceptionPropagationJumps)
@@ -159,11 +181,16 @@ JSC::MacroAssemblerCodeRef Assembler::link(int *codeSize)
             IR::BasicBlock *block = it.key();
             Label target = _addrs.value(block);
             Q_ASSERT(target.isSet());
-            foreach (DataLabelPtr label, it.value())
+            foreach (DataLabelPtr label, it.value()) {
                 linkBuffer.patch(label, linkBuffer.locationOf(target));
+                CodeRelocation r = { CodeRelocation::CodeAddress,
+                                     codeOffset(linkBuffer, linkBuffer.locationOf(label).dataLocation()),
+                                     linkBuffer.offsetOf(target) };
+                relocations->append(r);
+            }
         }
     }
-    _constTable.finalize(linkBuffer, _isel);
+    _constTable.finalize(linkBuffer, _isel, relocations);
 
     *codeSize = linkBuffer.offsetOf(endOfCode);
 
@@ -200,6 +227,7 @@ InstructionSelection::InstructionSelection(QQmlEnginePrivate *qmlEngine, QV4::Ex
     , qmlEngine(qmlEngine)
 {
     compilationUnit->codeRefs.resize(module->functions.size());
+    compilationUnit->relocations.resize(module->functions.size());
 }
 
 InstructionSelection::~InstructionSelection()
@@ -294,18 +322,24 @@ void InstructionSelection::run(int functionIndex)
     if (!_as->exceptionReturnLabel.isSet())
         visitRet(0);
 
-    int dummySize;
-    JSC::MacroAssemblerCodeRef codeRef =_as->link(&dummySize);
+    int codeSize;
+    JSC::MacroAssemblerCodeRef codeRef =_as->link(&codeSize, &compilationUnit->relocations[functionIndex]);
     compilationUnit->codeRefs[functionIndex] = codeRef;
 
+    if (PerfMap::isEnabled()) {
+        PerfMap::recordCode(codeRef.code().executableAddress(), codeSize, *_function->name,
+                            irModule->fileName, qMax(_function->line, 0));
+    }
+
     qSwap(_function, function);
     delete _as;
     _as = oldAssembler;
     qSwap(_removableJumps, removableJumps);
 }
 
-const void *InstructionSelection::addConstantTable(QVector<Primitive> *values)
+const void *InstructionSelection::addConstantTable(QVector<Primitive> *values, int *index)
 {
+    *index = compilationUnit->constantValues.size();
     compilationUnit->constantValues.append(*values);
     values->clear();
 
@@ -546,6 +580,13 @@ void InstructionSelection::callBuiltinConvertThisToObject()
     generateFunctionCall(Assembler::Void, Runtime::convertThisToObject, Assembler::EngineRegister);
 }
 
+void InstructionSelection::callBuiltinIsClosure(IR::Expr *value, int functionIndex, int scopeDepth, IR::Expr *result)
+{
+    generateFunctionCall(result, Runtime::isClosure, Assembler::EngineRegister,
+                         Assembler::PointerToValue(value), Assembler::TrustedImm32(functionIndex),
+                         Assembler::TrustedImm32(scopeDepth));
+}
+
 void InstructionSelection::callValue(IR::Expr *value, IR::ExprList *args, IR::Expr *result)
 {
     Q_ASSERT(value);
@@ -1628,12 +1669,18 @@ Assembler::Address Assembler::ConstantTable::loadValueAddress(const Primitive &v
     return addr;
 }
 
-void Assembler::ConstantTable::finalize(JSC::LinkBuffer &linkBuffer, InstructionSelection *isel)
+void Assembler::ConstantTable::finalize(JSC::LinkBuffer &linkBuffer, InstructionSelection *isel, QVector<CodeRelocation> *relocations)
 {
-    const void *tablePtr = isel->addConstantTable(&_values);
+    int tableIndex;
+    const void *tablePtr = isel->addConstantTable(&_values, &tableIndex);
 
-    foreach (DataLabelPtr label, _toPatch)
+    foreach (DataLabelPtr label, _toPatch) {
         linkBuffer.patch(label, const_cast<void *>(tablePtr));
+        CodeRelocation r = { CodeRelocation::ConstantTable,
+                             codeOffset(linkBuffer, linkBuffer.locationOf(label).dataLocation()),
+                             tableIndex };
+        relocations->append(r);
+    }
 }
 
 bool InstructionSelection::visitCJumpDouble(IR::AluOp op, IR::Expr *left, IR::Expr *right,
@@ -64,7 +64,7 @@ public:
 
     virtual void run(int functionIndex);
 
-    const void *addConstantTable(QVector<QV4::Primitive> *values);
+    const void *addConstantTable(QVector<QV4::Primitive> *values, int *index);
 protected:
     virtual QQmlRefPointer<QV4::CompiledData::CompilationUnit> backendCompileStep();
 
@@ -90,6 +90,7 @@ protected:
     virtual void callBuiltinDefineObjectLiteral(IR::Expr *result, int keyValuePairCount, IR::ExprList *keyValuePairs, IR::ExprList *arrayEntries, bool needSparseArray);
     virtual void callBuiltinSetupArgumentObject(IR::Expr *result);
     virtual void callBuiltinConvertThisToObject();
+    virtual void callBuiltinIsClosure(IR::Expr *value, int functionIndex, int scopeDepth, IR::Expr *result);
     virtual void callValue(IR::Expr *value, IR::ExprList *args, IR::Expr *result);
     virtual void callProperty(IR::Expr *base, const QString &name, IR::ExprList *args, IR::Expr *result);
     virtual void callSubscript(IR::Expr *base, IR::Expr *index, IR::ExprList *args, IR::Expr *result);
@@ -271,6 +272,8 @@ public:
     { return new InstructionSelection(qmlEngine, execAllocator, module, jsGenerator); }
     virtual bool jitCompileRegexps() const
     { return true; }
+    virtual QV4::CompiledData::CompilationUnit *createUnitForLoading()
+    { return new CompilationUnit; }
 };
 
 } // end of namespace JIT
@@ -0,0 +1,404 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4isel_tiered_p.h"
+#include "qv4vme_moth_p.h"
+#include "qv4context_p.h"
+#include "qv4function_p.h"
+#include "qv4ssa_p.h"
+
+#if ENABLE(ASSEMBLER)
+
+using namespace QV4;
+using namespace QV4::JIT;
+
+BackgroundCompiler::Job::Job(IR::Module *module, bool useFastLookups, ExecutableAllocator *executableAllocator)
+    : irModule(module)
+    , useFastLookups(useFastLookups)
+    , executableAllocator(executableAllocator)
+{
+}
+
+void BackgroundCompiler::Job::compile()
+{
+    {
+        QV4::Compiler::JSUnitGenerator jsGenerator(irModule.data());
+        JIT::InstructionSelection isel(/*qmlEngine*/ 0, executableAllocator, irModule.data(), &jsGenerator);
+        isel.setUseFastLookups(useFastLookups);
+        result = isel.compile();
+    }
+    irModule.reset();
+    finished.storeRelease(1);
+}
+
+BackgroundCompiler::BackgroundCompiler()
+    : stopped(false)
+{
+}
+
+BackgroundCompiler::~BackgroundCompiler()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopped = true;
+        jobsAvailable.wakeAll();
+    }
+    wait();
+
+    // The jobs that did not get compiled are cancelled.
+    foreach (const QSharedPointer<Job> &job, queue)
+        job->finished.storeRelease(1);
+}
+
+void BackgroundCompiler::enqueue(const QSharedPointer<Job> &job)
+{
+    QMutexLocker locker(&mutex);
+    queue.enqueue(job);
+    if (!isRunning())
+        start();
+    jobsAvailable.wakeOne();
+}
+
+void BackgroundCompiler::run()
+{
+    forever {
+        QSharedPointer<Job> job;
+        {
+            QMutexLocker locker(&mutex);
+            while (queue.isEmpty() && !stopped)
+                jobsAvailable.wait(&mutex);
+            if (stopped)
+                return;
+            job = queue.dequeue();
+        }
+        job->compile();
+    }
+}
+
+TieredCompilationUnit::TieredCompilationUnit(IR::Module *module, bool useFastLookups, int threshold, BackgroundCompiler *compiler)
+    : irModule(module)
+    , useFastLookups(useFastLookups)
+    , threshold(threshold)
+    , compiler(compiler)
+{
+}
+
+TieredCompilationUnit::~TieredCompilationUnit()
+{
+}
+
+void TieredCompilationUnit::linkBackendToEngine(ExecutionEngine *engine)
+{
+    Moth::CompilationUnit::linkBackendToEngine(engine);
+
+    // The root function only runs once, so it always stays in the interpreter.
+    functions.resize(runtimeFunctions.size());
+    for (int i = 0; i < runtimeFunctions.size(); ++i) {
+        if (i == data->indexOfRootFunction)
+            continue;
+
+        QV4::Function *runtimeFunction = runtimeFunctions.at(i);
+        TieredFunction &function = functions[i];
+        function.unit = this;
+        function.index = i;
+        function.hotness = 0;
+        function.interpreterCode = runtimeFunction->codeData;
+        function.compiledCode = 0;
+        function.jitCode = 0;
+        function.loopEntries = loopEntries.take(i);
+        function.argumentTypes.fill(0, runtimeFunction->compiledFunction->nFormals);
+        function.deoptimized = false;
+
+        runtimeFunction->code = &TieredCompilationUnit::exec;
+        runtimeFunction->codeData = reinterpret_cast<const uchar *>(&function);
+    }
+}
+
+ReturnedValue TieredCompilationUnit::exec(ExecutionEngine *engine, const uchar *data)
+{
+    TieredFunction *function = reinterpret_cast<TieredFunction *>(const_cast<uchar *>(data));
+    if (function->jitCode && !checkArgumentTypes(engine, function)) {
+        function->jitCode = 0;
+        function->deoptimized = true;
+        function->hotness = 0;
+    }
+
+    if (!function->jitCode) {
+        if (function->unit->irModule) // not handed to the compiler yet
+            recordArgumentTypes(engine, function);
+        if (++function->hotness < function->unit->threshold || !function->unit->tierUp(engine, function)) {
+            // The function may have been called through a closure created by compiled code.
+            function->unit->switchToInterpreterUnit(engine);
+            if (function->loopEntries.isEmpty())
+                return Moth::VME::exec(engine, function->interpreterCode, &function->hotness);
+            return Moth::VME::exec(engine, function->interpreterCode, &function->hotness,
+                                   &TieredCompilationUnit::enterLoop, function, function->unit->threshold);
+        }
+    }
+
+    function->unit->switchToJitUnit(engine);
+    return function->jitCode(engine, 0);
+}
+
+bool TieredCompilationUnit::enterLoop(void *data, ExecutionEngine *engine, const uchar *target, ReturnedValue *result)
+{
+    TieredFunction *function = static_cast<TieredFunction *>(data);
+    const ptrdiff_t offset = target - function->interpreterCode;
+    foreach (const LoopEntry &entry, function->loopEntries) {
+        if (entry.codeOffset != offset)
+            continue;
+        if (!function->jitCode && !function->unit->tierUp(engine, function) && !function->unit->jitUnit)
+            return false;
+
+        // The variables are all in the context, so the entry function picks them up from there.
+        function->unit->switchToJitUnit(engine);
+        QV4::Function *entryFunction = function->unit->jitUnit->runtimeFunctions.at(entry.jitFunction);
+        *result = entryFunction->code(engine, 0);
+        return true;
+    }
+    return false;
+}
+
+static inline quint8 argumentType(const CallData *callData, int index)
+{
+    if (index >= callData->argc)
+        return TieredCompilationUnit::OtherArgument; // undefined
+    const Value &value = callData->args[index];
+    if (value.isInteger())
+        return TieredCompilationUnit::IntArgument;
+    if (value.isDouble())
+        return TieredCompilationUnit::DoubleArgument;
+    return TieredCompilationUnit::OtherArgument;
+}
+
+void TieredCompilationUnit::recordArgumentTypes(ExecutionEngine *engine, TieredFunction *function)
+{
+    const CallData *callData = engine->currentContext()->callData;
+    for (int i = 0, ei = function->argumentTypes.size(); i != ei; ++i)
+        function->argumentTypes[i] |= argumentType(callData, i);
+}
+
+bool TieredCompilationUnit::checkArgumentTypes(ExecutionEngine *engine, const TieredFunction *function)
+{
+    const CallData *callData = engine->currentContext()->callData;
+    for (int i = 0, ei = function->argumentTypes.size(); i != ei; ++i) {
+        const quint8 required = function->argumentTypes.at(i);
+        if (required && argumentType(callData, i) != required)
+            return false;
+    }
+    return true;
+}
+
+// Turns the argument types seen by the interpreter into the ones the compiled code relies on.
+void TieredCompilationUnit::speculate(IR::Function *irFunction, TieredFunction *function)
+{
+    QVector<quint8> &types = function->argumentTypes;
+    if (irFunction->usesArgumentsObject || irFunction->variablesCanEscape()
+            || irFunction->hasTry || irFunction->hasWith) {
+        types.clear();
+        return;
+    }
+
+    bool speculating = false;
+    irFunction->formalTypes.fill(IR::VarType, types.size());
+    for (int i = 0, ei = types.size(); i != ei; ++i) {
+        if (types.at(i) == IntArgument) {
+            irFunction->formalTypes[i] = IR::SInt32Type;
+            speculating = true;
+        } else if (types.at(i) == DoubleArgument) {
+            irFunction->formalTypes[i] = IR::DoubleType;
+            speculating = true;
+        } else {
+            types[i] = 0;
+        }
+    }
+
+    if (!speculating) {
+        types.clear();
+        irFunction->formalTypes.clear();
+    }
+}
+
+// The compiled code finds its strings and lookups through the context, so the call context of the
+// function is switched over to the unit the code was compiled into.
+void TieredCompilationUnit::switchToJitUnit(ExecutionEngine *engine)
+{
+    Heap::ExecutionContext *ctx = engine->currentContext();
+    ctx->compilationUnit = jitUnit.data();
+    ctx->lookups = ctx->compilationUnit->runtimeLookups;
+}
+
+void TieredCompilationUnit::switchToInterpreterUnit(ExecutionEngine *engine)
+{
+    Heap::ExecutionContext *ctx = engine->currentContext();
+    ctx->compilationUnit = this;
+    ctx->lookups = runtimeLookups;
+}
+
+// Closures created by the compiled code get their functions from the JIT compiled unit. Without
+// going through exec() they would skip the argument type check and keep running the compiled code
+// of deoptimized functions, so those functions are replaced by ones that go through exec() and
+// belong to this unit. That also keeps this unit, which owns the TieredFunctions, alive for as
+// long as such a closure is. The loop entry functions are only called from enterLoop().
+void TieredCompilationUnit::linkJitUnit(ExecutionEngine *engine)
+{
+    jitUnit->linkToEngine(engine);
+
+    for (int i = 0, ei = functions.size(); i != ei; ++i) {
+        if (i == data->indexOfRootFunction)
+            continue;
+        QV4::Function *compiledFunction = jitUnit->runtimeFunctions.at(i);
+        functions[i].compiledCode = compiledFunction->code;
+        QV4::Function *runtimeFunction = new QV4::Function(engine, this, runtimeFunctions.at(i)->compiledFunction,
+                                                           &TieredCompilationUnit::exec);
+        runtimeFunction->codeData = reinterpret_cast<const uchar *>(&functions[i]);
+        jitUnit->runtimeFunctions[i] = runtimeFunction;
+        delete compiledFunction;
+    }
+}
+
+bool TieredCompilationUnit::tierUp(ExecutionEngine *engine, TieredFunction *function)
+{
+    // JIT compiled code cannot be debugged.
+    if (engine->debugger) {
+        function->hotness = 0;
+        return false;
+    }
+
+    if (!jitUnit) {
+        if (!job) {
+            if (!irModule) { // the compilation was cancelled
+                function->hotness = 0;
+                return false;
+            }
+            // The entry functions are appended, so they don't change the index of any other.
+            for (int i = 0, ei = functions.size(); i != ei; ++i) {
+                QVector<LoopEntry> &entries = functions[i].loopEntries;
+                for (int j = 0, ej = entries.size(); j != ej; ++j) {
+                    entries[j].jitFunction = irModule->functions.size();
+                    IR::OnStackReplacement::createLoopEntry(irModule->functions.at(i), entries.at(j).loopHeader);
+                }
+                if (i != data->indexOfRootFunction)
+                    speculate(irModule->functions.at(i), &functions[i]);
+            }
+            job.reset(new BackgroundCompiler::Job(irModule.take(), useFastLookups, engine->executableAllocator));
+            compiler->enqueue(job);
+            return false;
+        }
+
+        // Keep interpreting until the code is ready.
+        if (!job->finished.loadAcquire())
+            return false;
+
+        jitUnit = job->result;
+        job->result = QQmlRefPointer<QV4::CompiledData::CompilationUnit>();
+        job.clear();
+        if (!jitUnit) {
+            function->hotness = 0;
+            return false;
+        }
+        linkJitUnit(engine);
+    }
+
+    if (function->deoptimized) {
+        function->hotness = 0;
+        return false;
+    }
+
+    function->jitCode = function->compiledCode;
+    return true;
+}
+
+TieredInstructionSelection::TieredInstructionSelection(QQmlEnginePrivate *qmlEngine, ExecutableAllocator *execAllocator, IR::Module *module, Compiler::JSUnitGenerator *jsGenerator, int threshold, BackgroundCompiler *compiler)
+    : Moth::InstructionSelection(qmlEngine, execAllocator, module, jsGenerator)
+    , threshold(threshold)
+    , compiler(compiler)
+    , currentFunction(-1)
+{
+}
+
+TieredInstructionSelection::~TieredInstructionSelection()
+{
+}
+
+void TieredInstructionSelection::run(int functionIndex)
+{
+    // Take the copy before the interpreter's instruction selection starts transforming the IR.
+    if (!moduleCopy)
+        moduleCopy.reset(irModule->clone());
+
+    // The blocks are remembered, because the optimizer renumbers them.
+    IR::Function *function = irModule->functions.at(functionIndex);
+    currentFunction = functionIndex;
+    currentLoopHeaders.clear();
+    if (function != irModule->rootFunction) {
+        foreach (int header, IR::OnStackReplacement::loopHeaders(function))
+            currentLoopHeaders.append(qMakePair(header, function->basicBlock(header)));
+        function->hasLoopEntries = !currentLoopHeaders.isEmpty();
+    }
+
+    Moth::InstructionSelection::run(functionIndex);
+}
+
+void TieredInstructionSelection::codeGenerated(IR::Function *function, const QHash<IR::BasicBlock *, ptrdiff_t> &blockOffsets)
+{
+    Q_UNUSED(function);
+
+    QVector<TieredCompilationUnit::LoopEntry> entries;
+    for (int i = 0, ei = currentLoopHeaders.size(); i != ei; ++i) {
+        QHash<IR::BasicBlock *, ptrdiff_t>::const_iterator it = blockOffsets.find(currentLoopHeaders.at(i).second);
+        if (it == blockOffsets.end()) // optimized away
+            continue;
+        TieredCompilationUnit::LoopEntry entry;
+        entry.codeOffset = it.value();
+        entry.loopHeader = currentLoopHeaders.at(i).first;
+        entry.jitFunction = -1;
+        entries.append(entry);
+    }
+    if (!entries.isEmpty())
+        loopEntries.insert(currentFunction, entries);
+}
+
+QQmlRefPointer<CompiledData::CompilationUnit> TieredInstructionSelection::backendCompileStep()
+{
+    QQmlRefPointer<CompiledData::CompilationUnit> interpreted = Moth::InstructionSelection::backendCompileStep();
+
+    TieredCompilationUnit *unit = new TieredCompilationUnit(moduleCopy.take(), useFastLookups, threshold, compiler);
+    unit->codeRefs = static_cast<Moth::CompilationUnit *>(interpreted.data())->codeRefs;
+    unit->loopEntries = loopEntries;
+    QQmlRefPointer<CompiledData::CompilationUnit> result;
+    result.adopt(unit);
+    return result;
+}
+
+#endif // ENABLE(ASSEMBLER)
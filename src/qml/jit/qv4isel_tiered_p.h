@@ -0,0 +1,203 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QV4ISEL_TIERED_P_H
+#define QV4ISEL_TIERED_P_H
+
+#include "qv4isel_masm_p.h"
+#include <private/qv4isel_moth_p.h>
+
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+#if ENABLE(ASSEMBLER)
+
+QT_BEGIN_NAMESPACE
+
+namespace QV4 {
+namespace JIT {
+
+// JIT compiles the IR retained by tiered compilation units on a worker thread, so the JS thread
+// keeps interpreting while the code gets ready. Linking the result to the engine is left to the
+// JS thread.
+class BackgroundCompiler : public QThread
+{
+public:
+    struct Job {
+        Job(IR::Module *module, bool useFastLookups, QV4::ExecutableAllocator *executableAllocator);
+
+        void compile();
+
+        QScopedPointer<IR::Module> irModule;
+        bool useFastLookups;
+        QV4::ExecutableAllocator *executableAllocator;
+        QQmlRefPointer<QV4::CompiledData::CompilationUnit> result; // 0 if cancelled
+        QAtomicInt finished;
+    };
+
+    BackgroundCompiler();
+    ~BackgroundCompiler();
+
+    void enqueue(const QSharedPointer<Job> &job);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    QMutex mutex;
+    QWaitCondition jobsAvailable;
+    QQueue<QSharedPointer<Job> > queue;
+    bool stopped;
+};
+
+// Functions start out in the interpreter. Every call and every loop iteration adds to the
+// hotness of a function. The first function getting hot has the whole unit compiled in the
+// background, from a copy of the IR taken before the interpreter's instruction selection, and
+// each function switches to the JIT compiled code on its first hot call after that.
+//
+// A function that is still in a hot loop at that point continues in the JIT compiled code at the
+// next iteration of the loop (on-stack replacement). For that, each suitable loop header gets a
+// copy of the function compiled, which starts at the loop header; see IR::OnStackReplacement.
+//
+// The interpreter also records the types of the arguments each function gets called with. An
+// argument that was always an int, or always a double, is compiled as one. Before the compiled
+// code runs, the arguments are checked to still have those types. If they don't, the function is
+// deoptimized: it goes back to the interpreter for good. Closures created by compiled code refer
+// to the functions of the JIT compiled unit, so those are routed through the same check.
+//
+// Only the formal parameters are speculated on, as they can be checked once on entry. Values
+// produced inside a function (property reads, calls, globals) keep their generic types, since a
+// failing check there would need the interpreter to take over in the middle of the function. So
+// the root function and functions without arguments, like QML bindings, only get the JIT
+// compiled code, not the typed one.
+struct TieredCompilationUnit : public Moth::CompilationUnit
+{
+    enum ArgumentType {
+        IntArgument = 0x1,
+        DoubleArgument = 0x2,
+        OtherArgument = 0x4
+    };
+
+    struct LoopEntry {
+        ptrdiff_t codeOffset; // of the loop header in the interpreter code
+        int loopHeader; // index of the loop header in the IR
+        int jitFunction; // index of the entry function in the JIT compiled unit
+    };
+
+    struct TieredFunction {
+        TieredCompilationUnit *unit;
+        int index;
+        int hotness;
+        const uchar *interpreterCode;
+        ReturnedValue (*compiledCode)(ExecutionEngine *, const uchar *); // once the JIT unit is linked
+        ReturnedValue (*jitCode)(ExecutionEngine *, const uchar *); // once the function tiered up
+        QVector<LoopEntry> loopEntries;
+        // The ArgumentTypes seen so far, until the unit is compiled. After that, the type each
+        // argument is required to have, or 0.
+        QVector<quint8> argumentTypes;
+        bool deoptimized;
+    };
+
+    TieredCompilationUnit(IR::Module *module, bool useFastLookups, int threshold, BackgroundCompiler *compiler);
+    virtual ~TieredCompilationUnit();
+    virtual void linkBackendToEngine(QV4::ExecutionEngine *engine);
+
+    static ReturnedValue exec(ExecutionEngine *engine, const uchar *data);
+    static bool enterLoop(void *data, ExecutionEngine *engine, const uchar *target, ReturnedValue *result);
+
+    QHash<int, QVector<LoopEntry> > loopEntries; // by function index, until linked
+
+private:
+    bool tierUp(ExecutionEngine *engine, TieredFunction *function);
+    static void recordArgumentTypes(ExecutionEngine *engine, TieredFunction *function);
+    static bool checkArgumentTypes(ExecutionEngine *engine, const TieredFunction *function);
+    void speculate(IR::Function *irFunction, TieredFunction *function);
+    void switchToJitUnit(ExecutionEngine *engine);
+    void switchToInterpreterUnit(ExecutionEngine *engine);
+    void linkJitUnit(ExecutionEngine *engine);
+
+    QScopedPointer<IR::Module> irModule; // handed to the compile job
+    bool useFastLookups;
+    int threshold;
+    BackgroundCompiler *compiler;
+    QSharedPointer<BackgroundCompiler::Job> job;
+    QVector<TieredFunction> functions;
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> jitUnit;
+};
+
+class Q_QML_EXPORT TieredInstructionSelection: public Moth::InstructionSelection
+{
+public:
+    TieredInstructionSelection(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator, int threshold, BackgroundCompiler *compiler);
+    ~TieredInstructionSelection();
+
+    virtual void run(int functionIndex);
+
+protected:
+    virtual QQmlRefPointer<QV4::CompiledData::CompilationUnit> backendCompileStep();
+    virtual void codeGenerated(IR::Function *function, const QHash<IR::BasicBlock *, ptrdiff_t> &blockOffsets);
+
+private:
+    QScopedPointer<IR::Module> moduleCopy;
+    int currentFunction;
+    QVector<QPair<int, IR::BasicBlock *> > currentLoopHeaders; // index before optimization, block
+    QHash<int, QVector<TieredCompilationUnit::LoopEntry> > loopEntries;
+    int threshold;
+    BackgroundCompiler *compiler;
+};
+
+class Q_QML_EXPORT TieredISelFactory: public EvalISelFactory
+{
+public:
+    TieredISelFactory(int threshold) : threshold(threshold) {}
+    virtual ~TieredISelFactory() {}
+    virtual EvalInstructionSelection *create(QQmlEnginePrivate *qmlEngine, QV4::ExecutableAllocator *execAllocator, IR::Module *module, QV4::Compiler::JSUnitGenerator *jsGenerator)
+    { return new TieredInstructionSelection(qmlEngine, execAllocator, module, jsGenerator, threshold, &compiler); }
+    virtual bool jitCompileRegexps() const
+    { return true; }
+
+private:
+    int threshold;
+    BackgroundCompiler compiler;
+};
+
+} // end of namespace JIT
+} // end of namespace QV4
+
+QT_END_NAMESPACE
+
+#endif // ENABLE(ASSEMBLER)
+
+#endif // QV4ISEL_TIERED_P_H
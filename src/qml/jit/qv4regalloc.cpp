@@ -289,6 +289,7 @@ protected: // IRDecoder
     virtual void callBuiltinDefineObjectLiteral(IR::Expr *, int, IR::ExprList *, IR::ExprList *, bool) {}
     virtual void callBuiltinSetupArgumentObject(IR::Expr *) {}
     virtual void callBuiltinConvertThisToObject() {}
+    virtual void callBuiltinIsClosure(IR::Expr *, int, int, IR::Expr *) {}
 
     virtual void callValue(IR::Expr *value, IR::ExprList *args, IR::Expr *result)
     {
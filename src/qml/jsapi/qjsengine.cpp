@@ -231,7 +231,81 @@ QJSEngine::~QJSEngine()
 */
 void QJSEngine::collectGarbage()
 {
-    d->m_v4Engine->memoryManager->runGC();
+    d->m_v4Engine->memoryManager->runGC(/*forceFullCollection*/true);
+}
+
+/*!
+  \since 5.6
+
+  Returns statistics about the garbage collected heap of this engine.
+
+  The map contains the following entries:
+
+    \table
+    \header \li Key \li Description
+    \row \li \c allocatedMemory \li Bytes of memory allocated for small items.
+    \row \li \c usedMemory \li Bytes of the small item memory that are in use.
+    \row \li \c largeItemsMemory \li Bytes allocated for large items.
+    \row \li \c largeItemsMappedMemory \li Bytes of address space mapped for large items
+        spanning several pages, including mappings kept for reuse.
+    \row \li \c largeItems \li The number of large items.
+    \row \li \c sizeClasses \li A list with a map for each size of small items, holding
+            the \c itemSize in bytes, the number of \c chunks, and the total number of
+            \c items and \c usedItems in them.
+    \row \li \c collections \li The number of garbage collections run so far.
+    \row \li \c maxPauseNsecs \li The longest pause of a garbage collection in nanoseconds.
+    \row \li \c totalPauseNsecs \li The time spent in garbage collections in nanoseconds.
+    \row \li \c allocatedBytes \li Bytes allocated since the last garbage collection.
+    \row \li \c recentCollections \li A list with a map for each of the most recent garbage
+            collections, oldest first, holding its \c pauseNsecs, the part of it spent in
+            the final marking as \c markNsecs, the \c allocatedBytes
+            since the one before, whether it was a \c minorCollection, and the part of the
+            pause spent resetting the dirty page tracking of generational collection as
+            \c dirtyPagesResetNsecs. That reset covers all the memory of the process, not
+            just the heap.
+    \endtable
+
+  Gathering the statistics involves visiting the whole heap, so this function should not
+  be called in performance critical code.
+*/
+QVariantMap QJSEngine::heapStatistics() const
+{
+    const QV4::MemoryManager::HeapStatistics stats = d->m_v4Engine->memoryManager->statistics();
+
+    QVariantList sizeClasses;
+    foreach (const QV4::MemoryManager::SizeClassStatistics &sizeClass, stats.sizeClasses) {
+        QVariantMap map;
+        map.insert(QStringLiteral("itemSize"), sizeClass.itemSize);
+        map.insert(QStringLiteral("chunks"), sizeClass.chunks);
+        map.insert(QStringLiteral("items"), sizeClass.items);
+        map.insert(QStringLiteral("usedItems"), sizeClass.usedItems);
+        sizeClasses.append(map);
+    }
+
+    QVariantList recentCollections;
+    foreach (const QV4::MemoryManager::CollectionStatistics &collection, stats.recentCollections) {
+        QVariantMap map;
+        map.insert(QStringLiteral("pauseNsecs"), collection.pause);
+        map.insert(QStringLiteral("markNsecs"), collection.markTime);
+        map.insert(QStringLiteral("allocatedBytes"), collection.allocatedBytes);
+        map.insert(QStringLiteral("minorCollection"), collection.minorCollection);
+        map.insert(QStringLiteral("dirtyPagesResetNsecs"), collection.dirtyPagesResetTime);
+        recentCollections.append(map);
+    }
+
+    QVariantMap result;
+    result.insert(QStringLiteral("allocatedMemory"), quint64(stats.allocatedMem));
+    result.insert(QStringLiteral("usedMemory"), quint64(stats.usedMem));
+    result.insert(QStringLiteral("largeItemsMemory"), quint64(stats.largeItemsMem));
+    result.insert(QStringLiteral("largeItemsMappedMemory"), quint64(stats.largeItemsMappedMem));
+    result.insert(QStringLiteral("largeItems"), stats.largeItems);
+    result.insert(QStringLiteral("sizeClasses"), sizeClasses);
+    result.insert(QStringLiteral("collections"), stats.collections);
+    result.insert(QStringLiteral("maxPauseNsecs"), stats.maxPause);
+    result.insert(QStringLiteral("totalPauseNsecs"), stats.totalPause);
+    result.insert(QStringLiteral("allocatedBytes"), stats.allocatedBytes);
+    result.insert(QStringLiteral("recentCollections"), recentCollections);
+    return result;
 }
 
 /*!
@@ -80,6 +80,7 @@ public:
     }
 
     void collectGarbage();
+    QVariantMap heapStatistics() const;
 
     void installTranslatorFunctions(const QJSValue &object = QJSValue());
 
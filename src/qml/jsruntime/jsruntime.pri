@@ -41,6 +41,7 @@ SOURCES += \
     $$PWD/qv4qobjectwrapper.cpp \
     $$PWD/qv4vme_moth.cpp \
     $$PWD/qv4profiling.cpp \
+    $$PWD/qv4perfmap.cpp \
     $$PWD/qv4arraybuffer.cpp \
     $$PWD/qv4typedarray.cpp \
     $$PWD/qv4dataview.cpp
@@ -89,6 +90,7 @@ HEADERS += \
     $$PWD/qv4qobjectwrapper_p.h \
     $$PWD/qv4vme_moth_p.h \
     $$PWD/qv4profiling_p.h \
+    $$PWD/qv4perfmap_p.h \
     $$PWD/qv4arraybuffer_p.h \
     $$PWD/qv4typedarray_p.h \
     $$PWD/qv4dataview_p.h
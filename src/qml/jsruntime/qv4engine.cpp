@@ -63,6 +63,7 @@
 #include "qv4arraybuffer_p.h"
 #include "qv4dataview_p.h"
 #include "qv4typedarray_p.h"
+#include "qv4lookup_p.h"
 #include <private/qv8engine_p.h>
 #include <private/qjsvalue_p.h>
 #include <private/qqmlcontextwrapper_p.h>
@@ -78,6 +79,7 @@
 
 #ifdef V4_ENABLE_JIT
 #include "qv4isel_masm_p.h"
+#include "qv4isel_tiered_p.h"
 #endif // V4_ENABLE_JIT
 
 #include "qv4isel_moth_p.h"
@@ -197,6 +199,7 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     , regExpAllocator(new QV4::ExecutableAllocator)
     , bumperPointerAllocator(new WTF::BumpPointerAllocator)
     , jsStack(new WTF::PageAllocation)
+    , markingInParallel(false)
     , debugger(0)
     , profiler(0)
     , globalCode(0)
@@ -213,8 +216,12 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
 
 #ifdef V4_ENABLE_JIT
         static const bool forceMoth = !qgetenv("QV4_FORCE_INTERPRETER").isEmpty();
+        // Interpret functions until they have been called or looped this many times.
+        const int jitThreshold = qgetenv("QV4_JIT_THRESHOLD").toInt();
         if (forceMoth)
             factory = new Moth::ISelFactory;
+        else if (jitThreshold > 0)
+            factory = new JIT::TieredISelFactory(jitThreshold);
         else
             factory = new JIT::ISelFactory;
 #else // !V4_ENABLE_JIT
@@ -252,6 +259,8 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
     identifierTable = new IdentifierTable(this);
 
     classPool = new InternalClassPool;
+    internalClassIdCount = 0;
+    megamorphicLookupCache = new MegamorphicLookupCache;
 
     emptyClass =  new (classPool) InternalClass(this);
 
@@ -455,6 +464,9 @@ ExecutionEngine::ExecutionEngine(EvalISelFactory *factory)
 
 ExecutionEngine::~ExecutionEngine()
 {
+    // stops background compilation before the executable allocator goes away
+    iselFactory.reset();
+
     delete debugger;
     debugger = 0;
     delete profiler;
@@ -471,6 +483,7 @@ ExecutionEngine::~ExecutionEngine()
 
     emptyClass->destroy();
     delete classPool;
+    delete megamorphicLookupCache;
     delete bumperPointerAllocator;
     delete regExpCache;
     delete regExpAllocator;
@@ -894,7 +907,7 @@ void ExecutionEngine::requireArgumentsAccessors(int n)
     }
 }
 
-void ExecutionEngine::markObjects()
+void ExecutionEngine::markObjects(bool markCurrentContexts)
 {
     identifierTable->mark(this);
 
@@ -906,13 +919,13 @@ void ExecutionEngine::markObjects()
             setter->mark(this);
     }
 
-    Heap::ExecutionContext *c = currentContext();
+    // Always visit the current contexts: with generational GC the ones living on
+    // the stack keep their mark bit from a previous collection.
+    Heap::ExecutionContext *c = markCurrentContexts ? currentContext() : 0;
     while (c) {
         Q_ASSERT(c->inUse());
-        if (!c->isMarked()) {
-            c->setMarkBit();
-            c->gcGetVtable()->markObjects(c, this);
-        }
+        c->setMarkBit();
+        c->gcGetVtable()->markObjects(c, this);
         c = c->parent;
     }
 
@@ -923,6 +936,11 @@ void ExecutionEngine::markObjects()
         (*it)->markObjects(this);
 }
 
+void ExecutionEngine::markInParallel(Heap::Base *m)
+{
+    memoryManager->markInParallel(m);
+}
+
 ReturnedValue ExecutionEngine::throwError(const Value &value)
 {
     // we can get in here with an exception already set, as the runtime
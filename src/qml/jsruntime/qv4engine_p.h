@@ -63,6 +63,7 @@ class Profiler;
 namespace CompiledData {
 struct CompilationUnit;
 }
+struct MegamorphicLookupCache;
 
 #define CHECK_STACK_LIMITS(v4) \
     if ((v4->jsStackTop <= v4->jsStackLimit) && (reinterpret_cast<quintptr>(&v4) >= v4->cStackLimit || v4->recheckCStackLimits())) {}  \
@@ -98,6 +99,11 @@ public:
     WTF::PageAllocation *jsStack;
     Value *jsStackBase;
 
+    // Set while the mark phase is spread over several threads, see MemoryManager::mark().
+    // Heap::Base::mark() then pushes to the mark stack of the current thread instead.
+    bool markingInParallel;
+    void markInParallel(Heap::Base *m);
+
     void pushForGC(Heap::Base *m) {
         *jsStackTop = m;
         ++jsStackTop;
@@ -219,8 +225,12 @@ public:
     Object *valueTypeWrapperPrototype() const { return reinterpret_cast<Object *>(jsObjects + ValueTypeProto); }
 
     InternalClassPool *classPool;
+    uint internalClassIdCount;
     InternalClass *emptyClass;
 
+    // shared by all property lookups that have seen too many different classes
+    MegamorphicLookupCache *megamorphicLookupCache;
+
     InternalClass *arrayClass;
 
     InternalClass *functionClass;
@@ -398,7 +408,7 @@ public:
 
     void requireArgumentsAccessors(int n);
 
-    void markObjects();
+    void markObjects(bool markCurrentContexts = true);
 
     void initRootContext();
 
@@ -479,6 +489,10 @@ void Heap::Base::mark(QV4::ExecutionEngine *engine)
 #ifndef QT_NO_DEBUG
     engine->assertObjectBelongsToEngine(*this);
 #endif
+    if (Q_UNLIKELY(engine->markingInParallel)) {
+        engine->markInParallel(this);
+        return;
+    }
     setMarkBit();
     engine->pushForGC(this);
 }
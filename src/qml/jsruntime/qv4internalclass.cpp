@@ -112,6 +112,7 @@ uint PropertyHash::lookup(const Identifier *identifier) const
 
 InternalClass::InternalClass(ExecutionEngine *engine)
     : engine(engine)
+    , id(++engine->internalClassIdCount)
     , m_sealed(0)
     , m_frozen(0)
     , size(0)
@@ -123,6 +124,7 @@ InternalClass::InternalClass(ExecutionEngine *engine)
 InternalClass::InternalClass(const QV4::InternalClass &other)
     : QQmlJS::Managed()
     , engine(other.engine)
+    , id(++engine->internalClassIdCount)
     , propertyTable(other.propertyTable)
     , nameMap(other.nameMap)
     , propertyData(other.propertyData)
@@ -212,10 +214,33 @@ InternalClass *InternalClass::nonExtensible()
     return newClass;
 }
 
+InternalClass *InternalClass::findAddTransition(Identifier *identifier, PropertyAttributes data) const
+{
+    // Adding and changing a member share the transition key, but only one of them can
+    // apply to any one class. Only an added member ends up right behind the old ones.
+    Transition temp = { identifier, 0, (int)data.flags() };
+    std::vector<Transition>::const_iterator it = std::lower_bound(transitions.begin(), transitions.end(), temp);
+    if (it == transitions.end() || !(*it == temp) || !it->lookup)
+        return 0;
+    InternalClass *newClass = it->lookup;
+    if (newClass->size <= size || newClass->nameMap.at(size) != identifier)
+        return 0;
+    return newClass;
+}
+
 void InternalClass::addMember(Object *object, String *string, PropertyAttributes data, uint *index)
 {
     data.resolve();
     object->internalClass()->engine->identifierTable->identifier(string);
+    // objects of the same shape usually get their members added in the same order, so
+    // following the transition tree spares the property table lookup
+    if (InternalClass *newClass = object->internalClass()->findAddTransition(string->identifier(), data)) {
+        if (index)
+            *index = object->internalClass()->size;
+        object->setInternalClass(newClass);
+        return;
+    }
+
     if (object->internalClass()->propertyTable.lookup(string->d()->identifier) < object->internalClass()->size) {
         changeMember(object, string, data, index);
         return;
@@ -239,6 +264,12 @@ InternalClass *InternalClass::addMember(Identifier *identifier, PropertyAttribut
 {
     data.resolve();
 
+    if (InternalClass *newClass = findAddTransition(identifier, data)) {
+        if (index)
+            *index = size;
+        return newClass;
+    }
+
     if (propertyTable.lookup(identifier) < size)
         return changeMember(identifier, data, index);
 
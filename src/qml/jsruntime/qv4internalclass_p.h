@@ -206,6 +206,9 @@ struct InternalClassTransition
 
 struct InternalClass : public QQmlJS::Managed {
     ExecutionEngine *engine;
+    // Unique and never reused for the lifetime of the engine, so that lookups can cache
+    // compact ids instead of class pointers. 0 is never handed out.
+    uint id;
 
     PropertyHash propertyTable; // id to valueIndex
     SharedInternalClassData<Identifier *> nameMap;
@@ -238,6 +241,7 @@ struct InternalClass : public QQmlJS::Managed {
 
 private:
     InternalClass *addMemberImpl(Identifier *identifier, PropertyAttributes data, uint *index);
+    InternalClass *findAddTransition(Identifier *identifier, PropertyAttributes data) const;
     friend struct ExecutionEngine;
     InternalClass(ExecutionEngine *engine);
     InternalClass(const InternalClass &other);
@@ -333,6 +333,54 @@ ReturnedValue Lookup::getterFallback(Lookup *l, ExecutionEngine *engine, const V
     return o->get(name);
 }
 
+ReturnedValue Lookup::getterPolymorphic(Lookup *l, ExecutionEngine *engine, const Value &object)
+{
+    if (object.isObject()) {
+        Object *o = object.objectValue();
+        InternalClass *c = o->internalClass();
+        for (int i = 0; i < Size; ++i) {
+            if (l->polymorphicEntries[i].classId == c->id)
+                return o->memberData()->data[l->polymorphicEntries[i].index].asReturnedValue();
+        }
+
+        Identifier *name = engine->currentContext()->compilationUnit->runtimeStrings[l->nameIndex]->identifier;
+        uint index = c->find(name);
+        if (index != UINT_MAX && c->propertyData.at(index).isData()) {
+            for (int i = 0; i < Size; ++i) {
+                if (!l->polymorphicEntries[i].classId) {
+                    l->polymorphicEntries[i].classId = c->id;
+                    l->polymorphicEntries[i].index = index;
+                    return o->memberData()->data[index].asReturnedValue();
+                }
+            }
+            l->getter = getterMegamorphic;
+            return getterMegamorphic(l, engine, object);
+        }
+    }
+    return getterFallback(l, engine, object);
+}
+
+ReturnedValue Lookup::getterMegamorphic(Lookup *l, ExecutionEngine *engine, const Value &object)
+{
+    if (object.isObject()) {
+        Object *o = object.objectValue();
+        InternalClass *c = o->internalClass();
+        Identifier *name = engine->currentContext()->compilationUnit->runtimeStrings[l->nameIndex]->identifier;
+        MegamorphicLookupCache::Entry &e = engine->megamorphicLookupCache->entry(c->id, name);
+        if (e.classId == c->id && e.name == name)
+            return o->memberData()->data[e.index].asReturnedValue();
+
+        uint index = c->find(name);
+        if (index != UINT_MAX && c->propertyData.at(index).isData()) {
+            e.classId = c->id;
+            e.index = index;
+            e.name = name;
+            return o->memberData()->data[index].asReturnedValue();
+        }
+    }
+    return getterFallback(l, engine, object);
+}
+
 ReturnedValue Lookup::getter0(Lookup *l, ExecutionEngine *engine, const Value &object)
 {
     if (object.isManaged()) {
@@ -388,8 +436,15 @@ ReturnedValue Lookup::getter0getter0(Lookup *l, ExecutionEngine *engine, const V
         if (l->classList[2] == o->internalClass())
             return o->memberData()->data[l->index2].asReturnedValue();
     }
-    l->getter = getterFallback;
-    return getterFallback(l, engine, object);
+
+    // A third class showed up, keep both known ones and compare class ids from now on.
+    const PolymorphicEntry first = { l->classList[0]->id, l->index };
+    const PolymorphicEntry second = { l->classList[2]->id, l->index2 };
+    memset(l->polymorphicEntries, 0, sizeof(l->polymorphicEntries));
+    l->polymorphicEntries[0] = first;
+    l->polymorphicEntries[1] = second;
+    l->getter = getterPolymorphic;
+    return getterPolymorphic(l, engine, object);
 }
 
 ReturnedValue Lookup::getter0getter1(Lookup *l, ExecutionEngine *engine, const Value &object)
@@ -46,6 +46,10 @@ namespace QV4 {
 
 struct Lookup {
     enum { Size = 4 };
+    struct PolymorphicEntry {
+        uint classId;
+        uint index;
+    };
     union {
         ReturnedValue (*indexedGetter)(Lookup *l, const Value &object, const Value &index);
         void (*indexedSetter)(Lookup *l, const Value &object, const Value &index, const Value &v);
@@ -56,6 +60,7 @@ struct Lookup {
     union {
         ExecutionEngine *engine;
         InternalClass *classList[Size];
+        PolymorphicEntry polymorphicEntries[Size]; // own data members by InternalClass::id
         struct {
             void *dummy0;
             void *dummy1;
@@ -81,6 +86,8 @@ struct Lookup {
     static ReturnedValue getterGeneric(Lookup *l, ExecutionEngine *engine, const Value &object);
     static ReturnedValue getterTwoClasses(Lookup *l, ExecutionEngine *engine, const Value &object);
     static ReturnedValue getterFallback(Lookup *l, ExecutionEngine *engine, const Value &object);
+    static ReturnedValue getterPolymorphic(Lookup *l, ExecutionEngine *engine, const Value &object);
+    static ReturnedValue getterMegamorphic(Lookup *l, ExecutionEngine *engine, const Value &object);
 
     static ReturnedValue getter0(Lookup *l, ExecutionEngine *engine, const Value &object);
     static ReturnedValue getter1(Lookup *l, ExecutionEngine *engine, const Value &object);
@@ -121,6 +128,24 @@ struct Lookup {
 
 };
 
+// A direct mapped cache of own data members, shared by all getter lookups of an engine
+// that have seen more classes than fit into their polymorphic entries.
+struct MegamorphicLookupCache {
+    enum { Size = 1024 };
+    struct Entry {
+        uint classId;
+        uint index;
+        const Identifier *name;
+    };
+    Entry entries[Size];
+
+    MegamorphicLookupCache()
+    { memset(entries, 0, sizeof(entries)); }
+
+    Entry &entry(uint classId, const Identifier *name)
+    { return entries[(classId ^ uint(quintptr(name) >> 4)) % Size]; }
+};
+
 }
 
 QT_END_NAMESPACE
@@ -0,0 +1,295 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qv4perfmap_p.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+
+#if defined(Q_OS_LINUX)
+#  include <elf.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <time.h>
+#  include <unistd.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+using namespace QV4;
+
+namespace {
+
+#if defined(Q_OS_LINUX)
+// See tools/perf/Documentation/jitdump-specification.txt in the Linux sources.
+struct JitDumpHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 totalSize;
+    quint32 elfMach;
+    quint32 pad1;
+    quint32 pid;
+    quint64 timestamp;
+    quint64 flags;
+};
+
+struct JitDumpRecordHeader {
+    enum Id {
+        CodeLoad = 0,
+        CodeDebugInfo = 2
+    };
+
+    quint32 id;
+    quint32 totalSize;
+    quint64 timestamp;
+};
+
+struct JitDumpCodeLoad {
+    JitDumpRecordHeader header;
+    quint32 pid;
+    quint32 tid;
+    quint64 vma;
+    quint64 codeAddress;
+    quint64 codeSize;
+    quint64 codeIndex;
+    // followed by the zero terminated name and the code
+};
+
+struct JitDumpDebugInfo {
+    JitDumpRecordHeader header;
+    quint64 codeAddress;
+    quint64 entryCount;
+    // followed by the entries
+};
+
+struct JitDumpDebugEntry {
+    quint64 address;
+    qint32 line;
+    qint32 discriminator;
+    // followed by the zero terminated file name
+};
+
+static quint64 monotonicTimestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static quint32 elfMachine()
+{
+#if defined(Q_PROCESSOR_X86_64)
+    return EM_X86_64;
+#elif defined(Q_PROCESSOR_X86_32)
+    return EM_386;
+#elif defined(Q_PROCESSOR_ARM_64)
+    return EM_AARCH64;
+#elif defined(Q_PROCESSOR_ARM)
+    return EM_ARM;
+#elif defined(Q_PROCESSOR_MIPS)
+    return EM_MIPS;
+#else
+    return EM_NONE;
+#endif
+}
+#endif // Q_OS_LINUX
+
+class PerfMapWriter
+{
+public:
+    enum Mode {
+        Disabled,
+        Map,
+        JitDump
+    };
+
+    PerfMapWriter();
+    ~PerfMapWriter();
+
+    void recordCode(const void *code, size_t size, const QString &name, const QString &sourceFile, int line);
+
+    Mode mode;
+
+private:
+    void writeJitDumpHeader();
+    void writeJitDumpDebugInfo(const void *code, const QByteArray &sourceFile, int line);
+
+    QMutex mutex;
+    QFile file;
+    void *marker;
+    quint64 codeIndex;
+};
+
+PerfMapWriter::PerfMapWriter()
+    : mode(Disabled)
+    , marker(0)
+    , codeIndex(0)
+{
+#if defined(Q_OS_LINUX)
+    const QByteArray setting = qgetenv("QV4_PERF_MAP");
+    if (setting.isEmpty() || setting == "0")
+        return;
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    if (setting == "jitdump") {
+        file.setFileName(QStringLiteral("/tmp/jit-%1.dump").arg(pid));
+        if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate | QIODevice::Unbuffered))
+            return;
+        // perf finds the dump through the executable mapping of it in the process.
+        const long pageSize = sysconf(_SC_PAGESIZE);
+        marker = mmap(0, pageSize, PROT_READ | PROT_EXEC, MAP_PRIVATE, file.handle(), 0);
+        if (marker == MAP_FAILED) {
+            marker = 0;
+            file.close();
+            return;
+        }
+        mode = JitDump;
+        writeJitDumpHeader();
+    } else {
+        file.setFileName(QStringLiteral("/tmp/perf-%1.map").arg(pid));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered))
+            return;
+        mode = Map;
+    }
+#endif
+}
+
+PerfMapWriter::~PerfMapWriter()
+{
+#if defined(Q_OS_LINUX)
+    if (marker)
+        munmap(marker, sysconf(_SC_PAGESIZE));
+#endif
+}
+
+void PerfMapWriter::recordCode(const void *code, size_t size, const QString &name, const QString &sourceFile, int line)
+{
+#if defined(Q_OS_LINUX)
+    QByteArray symbol = name.isEmpty() ? QByteArrayLiteral("<anonymous>") : name.toUtf8();
+    symbol.replace('\n', ' ');
+    if (!sourceFile.isEmpty())
+        symbol += " (" + sourceFile.toUtf8() + ':' + QByteArray::number(line) + ')';
+
+    QMutexLocker locker(&mutex);
+    if (mode == Map) {
+        file.write(QByteArray::number(quintptr(code), 16) + ' ' + QByteArray::number(quint64(size), 16)
+                   + ' ' + symbol + '\n');
+        return;
+    }
+
+    if (!sourceFile.isEmpty())
+        writeJitDumpDebugInfo(code, sourceFile.toUtf8(), line);
+
+    JitDumpCodeLoad record;
+    record.header.id = JitDumpRecordHeader::CodeLoad;
+    record.header.totalSize = sizeof(record) + symbol.size() + 1 + size;
+    record.header.timestamp = monotonicTimestamp();
+    record.pid = QCoreApplication::applicationPid();
+    record.tid = syscall(SYS_gettid);
+    record.vma = quintptr(code);
+    record.codeAddress = quintptr(code);
+    record.codeSize = size;
+    record.codeIndex = codeIndex++;
+    file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    file.write(symbol.constData(), symbol.size() + 1);
+    file.write(static_cast<const char *>(code), size);
+#else
+    Q_UNUSED(code);
+    Q_UNUSED(size);
+    Q_UNUSED(name);
+    Q_UNUSED(sourceFile);
+    Q_UNUSED(line);
+#endif
+}
+
+void PerfMapWriter::writeJitDumpHeader()
+{
+#if defined(Q_OS_LINUX)
+    JitDumpHeader header;
+    header.magic = 0x4A695444;
+    header.version = 1;
+    header.totalSize = sizeof(header);
+    header.elfMach = elfMachine();
+    header.pad1 = 0;
+    header.pid = QCoreApplication::applicationPid();
+    header.timestamp = monotonicTimestamp();
+    header.flags = 0;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+#endif
+}
+
+void PerfMapWriter::writeJitDumpDebugInfo(const void *code, const QByteArray &sourceFile, int line)
+{
+#if defined(Q_OS_LINUX)
+    // A single entry for the start of the function is enough to get at the source location.
+    JitDumpDebugInfo record;
+    record.header.id = JitDumpRecordHeader::CodeDebugInfo;
+    record.header.totalSize = sizeof(record) + sizeof(JitDumpDebugEntry) + sourceFile.size() + 1;
+    record.header.timestamp = monotonicTimestamp();
+    record.codeAddress = quintptr(code);
+    record.entryCount = 1;
+
+    JitDumpDebugEntry entry;
+    entry.address = quintptr(code);
+    entry.line = line;
+    entry.discriminator = 0;
+
+    file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    file.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    file.write(sourceFile.constData(), sourceFile.size() + 1);
+#else
+    Q_UNUSED(code);
+    Q_UNUSED(sourceFile);
+    Q_UNUSED(line);
+#endif
+}
+
+Q_GLOBAL_STATIC(PerfMapWriter, perfMapWriter)
+
+} // anonymous namespace
+
+bool PerfMap::isEnabled()
+{
+    PerfMapWriter *writer = perfMapWriter();
+    return writer && writer->mode != PerfMapWriter::Disabled;
+}
+
+void PerfMap::recordCode(const void *code, size_t size, const QString &name, const QString &sourceFile, int line)
+{
+    PerfMapWriter *writer = perfMapWriter();
+    if (writer && writer->mode != PerfMapWriter::Disabled)
+        writer->recordCode(code, size, name, sourceFile, line);
+}
+
+QT_END_NAMESPACE
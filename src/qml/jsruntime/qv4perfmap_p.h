@@ -0,0 +1,62 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QV4PERFMAP_P_H
+#define QV4PERFMAP_P_H
+
+#include "qv4global_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace QV4 {
+
+// Tells Linux perf about generated code, so that profiles show JS functions and regular
+// expressions instead of anonymous addresses. Setting QV4_PERF_MAP to "1" appends the code to
+// /tmp/perf-<pid>.map, setting it to "jitdump" writes /tmp/jit-<pid>.dump for
+// "perf record -k mono" followed by "perf inject --jit". Code that gets freed is not reported,
+// so entries can be stale once the address range is reused.
+namespace PerfMap {
+
+Q_QML_PRIVATE_EXPORT bool isEnabled();
+
+// Thread-safe, the JIT may run in the background. sourceFile and line are optional.
+Q_QML_PRIVATE_EXPORT void recordCode(const void *code, size_t size, const QString &name,
+                                     const QString &sourceFile = QString(), int line = 0);
+
+} // namespace PerfMap
+
+} // namespace QV4
+
+QT_END_NAMESPACE
+
+#endif // QV4PERFMAP_P_H
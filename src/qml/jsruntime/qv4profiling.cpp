@@ -58,8 +58,10 @@ Profiler::Profiler(QV4::ExecutionEngine *engine) : featuresEnabled(0), m_engine(
 {
     static int meta = qRegisterMetaType<QVector<QV4::Profiling::FunctionCallProperties> >();
     static int meta2 = qRegisterMetaType<QVector<QV4::Profiling::MemoryAllocationProperties> >();
+    static int meta3 = qRegisterMetaType<QVector<QV4::Profiling::GarbageCollectionProperties> >();
     Q_UNUSED(meta);
     Q_UNUSED(meta2);
+    Q_UNUSED(meta3);
     m_timer.start();
 }
 
@@ -83,7 +85,7 @@ void Profiler::reportData()
         FunctionCallProperties props = call.resolve();
         resolved.insert(std::upper_bound(resolved.begin(), resolved.end(), props, comp), props);
     }
-    emit dataReady(resolved, m_memory_data);
+    emit dataReady(resolved, m_memory_data, m_gc_data);
 }
 
 void Profiler::startProfiling(quint64 features)
@@ -91,6 +93,7 @@ void Profiler::startProfiling(quint64 features)
     if (featuresEnabled == 0) {
         m_data.clear();
         m_memory_data.clear();
+        m_gc_data.clear();
 
         if (features & (1 << FeatureMemoryAllocation)) {
             qint64 timestamp = m_timer.nsecsElapsed();
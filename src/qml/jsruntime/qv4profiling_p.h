@@ -72,6 +72,15 @@ struct MemoryAllocationProperties {
     MemoryType type;
 };
 
+struct GarbageCollectionProperties {
+    qint64 timestamp;
+    qint64 pause;
+    qint64 allocatedBytes;
+    qint64 heapSize;
+    qint64 usedMemory;
+    qint64 largeItemsMemory;
+};
+
 class FunctionCall {
 public:
 
@@ -146,6 +155,15 @@ public:
         return pointer;
     }
 
+    void trackGarbageCollection(qint64 pause, qint64 allocatedBytes, qint64 heapSize,
+                                qint64 usedMemory, qint64 largeItemsMemory)
+    {
+        GarbageCollectionProperties collection = {m_timer.nsecsElapsed() - pause, pause,
+                                                  allocatedBytes, heapSize, usedMemory,
+                                                  largeItemsMemory};
+        m_gc_data.append(collection);
+    }
+
     quint64 featuresEnabled;
 
 public slots:
@@ -156,13 +174,15 @@ public slots:
 
 signals:
     void dataReady(const QVector<QV4::Profiling::FunctionCallProperties> &,
-                   const QVector<QV4::Profiling::MemoryAllocationProperties> &);
+                   const QVector<QV4::Profiling::MemoryAllocationProperties> &,
+                   const QVector<QV4::Profiling::GarbageCollectionProperties> &);
 
 private:
     QV4::ExecutionEngine *m_engine;
     QElapsedTimer m_timer;
     QVector<FunctionCall> m_data;
     QVector<MemoryAllocationProperties> m_memory_data;
+    QVector<GarbageCollectionProperties> m_gc_data;
 
     friend class FunctionCallProfiler;
 };
@@ -198,11 +218,13 @@ public:
 } // namespace QV4
 
 Q_DECLARE_TYPEINFO(QV4::Profiling::MemoryAllocationProperties, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(QV4::Profiling::GarbageCollectionProperties, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(QV4::Profiling::FunctionCallProperties, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(QV4::Profiling::FunctionCall, Q_MOVABLE_TYPE);
 
 QT_END_NAMESPACE
 Q_DECLARE_METATYPE(QVector<QV4::Profiling::FunctionCallProperties>)
 Q_DECLARE_METATYPE(QVector<QV4::Profiling::MemoryAllocationProperties>)
+Q_DECLARE_METATYPE(QVector<QV4::Profiling::GarbageCollectionProperties>)
 
 #endif // QV4PROFILING_H
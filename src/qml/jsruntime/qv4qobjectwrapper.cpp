@@ -1072,6 +1072,11 @@ void QObjectWrapper::destroy(Heap::Base *that)
     if (object->parent() || ddata->indestructible)
         return;
 
+    // With lazy sweeping the object might have been wrapped again since the
+    // collection found this wrapper to be unreachable, so it's still in use.
+    if (ddata->jsEngineId == engine->m_engineId && !ddata->jsWrapper.isUndefined())
+        return;
+
     QObjectDeleter *deleter = new QObjectDeleter(object);
     engine->memoryManager->registerDeletable(deleter);
 }
@@ -34,6 +34,7 @@
 #include "qv4regexp_p.h"
 #include "qv4engine_p.h"
 #include "qv4scopedvalue_p.h"
+#include "qv4perfmap_p.h"
 #include <private/qv4mm_p.h>
 
 using namespace QV4;
@@ -99,6 +100,15 @@ Heap::RegExp::RegExp(ExecutionEngine* engine, const QString &pattern, bool ignor
     if (!yarrPattern.m_containsBackreferences && engine->iselFactory->jitCompileRegexps()) {
         JSC::JSGlobalData dummy(engine->regExpAllocator);
         JSC::Yarr::jitCompile(yarrPattern, JSC::Yarr::Char16, &dummy, jitCode);
+        if (jitCode.has16BitCode() && PerfMap::isEnabled()) {
+            const JSC::MacroAssemblerCodeRef &code = jitCode.get16BitCode();
+            QString name = QLatin1String("RegExp /") + pattern + QLatin1Char('/');
+            if (ignoreCase)
+                name += QLatin1Char('i');
+            if (multiline)
+                name += QLatin1Char('m');
+            PerfMap::recordCode(code.code().executableAddress(), code.size(), name);
+        }
     }
 #endif
 }
@@ -272,6 +272,23 @@ ReturnedValue Runtime::closure(ExecutionEngine *engine, int functionId)
     return FunctionObject::createScriptFunction(ScopedContext(scope, engine->currentContext()), clos)->asReturnedValue();
 }
 
+// Checks that value is a closure of the given function that was created in the context scopeDepth
+// levels up from the current one, so code inlined for it sees the same enclosing variables. The
+// compiled functions are compared rather than the runtime ones, as a tiered unit and its JIT
+// compiled twin have separate runtime functions for the same compiled function.
+ReturnedValue Runtime::isClosure(ExecutionEngine *engine, const Value &value, int functionId, int scopeDepth)
+{
+    const FunctionObject *f = value.as<FunctionObject>();
+    if (!f || !f->function())
+        return Encode(false);
+    Heap::ExecutionContext *ctx = engine->currentContext();
+    if (f->function()->compiledFunction != ctx->compilationUnit->runtimeFunctions[functionId]->compiledFunction)
+        return Encode(false);
+    for (; scopeDepth > 0 && ctx; --scopeDepth)
+        ctx = ctx->outer;
+    return Encode(ctx && f->d()->scope == ctx);
+}
+
 ReturnedValue Runtime::deleteElement(ExecutionEngine *engine, const Value &base, const Value &index)
 {
     Scope scope(engine);
@@ -691,6 +708,28 @@ ReturnedValue Runtime::getActivationProperty(ExecutionEngine *engine, int nameIn
     return ctx->getProperty(name);
 }
 
+#else // V4_BOOTSTRAP
+
+// The host tools never run code, but the interpreter code that qmlcachegen generates refers to the
+// operations that need the engine.
+ReturnedValue Runtime::instanceof(ExecutionEngine *, const Value &, const Value &)
+{
+    Q_UNIMPLEMENTED();
+    return Encode::undefined();
+}
+
+ReturnedValue Runtime::in(ExecutionEngine *, const Value &, const Value &)
+{
+    Q_UNIMPLEMENTED();
+    return Encode::undefined();
+}
+
+ReturnedValue Runtime::add(ExecutionEngine *, const Value &, const Value &)
+{
+    Q_UNIMPLEMENTED();
+    return Encode::undefined();
+}
+
 #endif // V4_BOOTSTRAP
 
 uint RuntimeHelpers::equalHelper(const Value &x, const Value &y)
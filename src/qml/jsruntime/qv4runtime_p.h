@@ -132,6 +132,7 @@ struct Q_QML_PRIVATE_EXPORT Runtime {
 
     // closures
     static ReturnedValue closure(ExecutionEngine *engine, int functionId);
+    static ReturnedValue isClosure(ExecutionEngine *engine, const Value &value, int functionId, int scopeDepth);
 
     // function header
     static void declareVar(ExecutionEngine *engine, bool deletable, int nameIndex);
@@ -466,6 +466,7 @@ struct Q_QML_PRIVATE_EXPORT Primitive : public Value
     static unsigned int toUInt32(double value);
 };
 
+// qmlcachegen writes constants with these encodings for all targets, keep them in sync.
 inline Primitive Primitive::undefinedValue()
 {
     Primitive v;
@@ -345,6 +345,14 @@ Param traceParam(const Param &param)
     if (engine->hasException) \
         goto catchException
 
+// Counts a loop iteration, and continues the loop elsewhere if it is hot and that is possible.
+#define MOTH_BACKWARD_JUMP \
+    if (backwardJumps && ++*backwardJumps >= loopEntryThreshold && loopEntry) { \
+        QV4::ReturnedValue result; \
+        if (loopEntry(loopEntryData, engine, code, &result)) \
+            return result; \
+    }
+
 QV4::ReturnedValue VME::run(ExecutionEngine *engine, const uchar *code
 #ifdef MOTH_THREADED_INTERPRETER
         , void ***storeJumpTable
@@ -682,6 +690,10 @@ QV4::ReturnedValue VME::run(ExecutionEngine *engine, const uchar *code
         CHECK_EXCEPTION;
     MOTH_END_INSTR(CallBuiltinConvertThisToObject)
 
+    MOTH_BEGIN_INSTR(CallBuiltinIsClosure)
+        STOREVALUE(instr.result, Runtime::isClosure(engine, VALUE(instr.value), instr.functionIndex, instr.scopeDepth));
+    MOTH_END_INSTR(CallBuiltinIsClosure)
+
     MOTH_BEGIN_INSTR(CreateValue)
         Q_ASSERT(instr.callData + instr.argc + qOffsetOf(QV4::CallData, args)/sizeof(QV4::Value) <= stackSize);
         QV4::CallData *callData = reinterpret_cast<QV4::CallData *>(stack + instr.callData);
@@ -729,22 +741,52 @@ QV4::ReturnedValue VME::run(ExecutionEngine *engine, const uchar *code
 
     MOTH_BEGIN_INSTR(Jump)
         code = ((uchar *)&instr.offset) + instr.offset;
+        if (instr.offset < 0)
+            MOTH_BACKWARD_JUMP;
     MOTH_END_INSTR(Jump)
 
     MOTH_BEGIN_INSTR(JumpEq)
         bool cond = VALUEPTR(instr.condition)->toBoolean();
         TRACE(condition, "%s", cond ? "TRUE" : "FALSE");
-        if (cond)
+        if (cond) {
             code = ((uchar *)&instr.offset) + instr.offset;
+            if (instr.offset < 0)
+                MOTH_BACKWARD_JUMP;
+        }
     MOTH_END_INSTR(JumpEq)
 
     MOTH_BEGIN_INSTR(JumpNe)
         bool cond = VALUEPTR(instr.condition)->toBoolean();
         TRACE(condition, "%s", cond ? "TRUE" : "FALSE");
-        if (!cond)
+        if (!cond) {
             code = ((uchar *)&instr.offset) + instr.offset;
+            if (instr.offset < 0)
+                MOTH_BACKWARD_JUMP;
+        }
     MOTH_END_INSTR(JumpNe)
 
+    MOTH_BEGIN_INSTR(CompareJumpEq)
+        bool cond = instr.cmp(VALUE(instr.lhs), VALUE(instr.rhs));
+        CHECK_EXCEPTION;
+        TRACE(condition, "%s", cond ? "TRUE" : "FALSE");
+        if (cond) {
+            code = ((uchar *)&instr.offset) + instr.offset;
+            if (instr.offset < 0)
+                MOTH_BACKWARD_JUMP;
+        }
+    MOTH_END_INSTR(CompareJumpEq)
+
+    MOTH_BEGIN_INSTR(CompareJumpNe)
+        bool cond = instr.cmp(VALUE(instr.lhs), VALUE(instr.rhs));
+        CHECK_EXCEPTION;
+        TRACE(condition, "%s", cond ? "TRUE" : "FALSE");
+        if (!cond) {
+            code = ((uchar *)&instr.offset) + instr.offset;
+            if (instr.offset < 0)
+                MOTH_BACKWARD_JUMP;
+        }
+    MOTH_END_INSTR(CompareJumpNe)
+
     MOTH_BEGIN_INSTR(UNot)
         STOREVALUE(instr.result, Runtime::uNot(VALUE(instr.source)));
     MOTH_END_INSTR(UNot)
@@ -918,8 +960,18 @@ void **VME::instructionJumpTable()
 #endif
 
 QV4::ReturnedValue VME::exec(ExecutionEngine *engine, const uchar *code)
+{
+    return exec(engine, code, 0);
+}
+
+QV4::ReturnedValue VME::exec(ExecutionEngine *engine, const uchar *code, int *backwardJumps,
+                             LoopEntry loopEntry, void *loopEntryData, int loopEntryThreshold)
 {
     VME vme;
+    vme.backwardJumps = backwardJumps;
+    vme.loopEntry = loopEntry;
+    vme.loopEntryData = loopEntryData;
+    vme.loopEntryThreshold = loopEntryThreshold;
     QV4::Debugging::Debugger *debugger = engine->debugger;
     if (debugger)
         debugger->enteringFunction();
@@ -45,7 +45,19 @@ namespace Moth {
 class VME
 {
 public:
+    // Asked on backward jumps whether the function can continue somewhere else from the jump
+    // target on. Returns true with the function's result if it did.
+    typedef bool (*LoopEntry)(void *data, QV4::ExecutionEngine *engine, const uchar *target, QV4::ReturnedValue *result);
+
+    VME() : backwardJumps(0), loopEntry(0), loopEntryData(0), loopEntryThreshold(0) {}
+
     static QV4::ReturnedValue exec(QV4::ExecutionEngine *, const uchar *);
+    // Like the above, and adds the number of backward jumps taken, i.e. loop iterations, to
+    // the given counter. Once the counter reaches the threshold, each backward jump asks
+    // loopEntry, if given.
+    static QV4::ReturnedValue exec(QV4::ExecutionEngine *, const uchar *, int *backwardJumps,
+                                   LoopEntry loopEntry = 0, void *loopEntryData = 0,
+                                   int loopEntryThreshold = 0);
 
 #ifdef MOTH_THREADED_INTERPRETER
     static void **instructionJumpTable();
@@ -57,6 +69,11 @@ private:
             , void ***storeJumpTable = 0
 #endif
             );
+
+    int *backwardJumps;
+    LoopEntry loopEntry;
+    void *loopEntryData;
+    int loopEntryThreshold;
 };
 
 } // namespace Moth
@@ -36,18 +36,26 @@
 #include "qv4objectproto_p.h"
 #include "qv4mm_p.h"
 #include "qv4qobjectwrapper_p.h"
+#include <private/qqmlvmemetaobject_p.h>
 #include <qqmlengine.h>
 #include "PageAllocation.h"
 #include "StdLibExtras.h"
 
 #include <QTime>
+#include <QElapsedTimer>
 #include <QVector>
 #include <QVector>
+#include <QPair>
 #include <QMap>
+#include <QMutex>
+#include <QThread>
+#include <QThreadStorage>
+#include <QWaitCondition>
 
 #include <iostream>
 #include <cstdlib>
 #include <algorithm>
+#include <limits>
 #include "qv4alloca_p.h"
 #include "qv4profiling_p.h"
 
@@ -64,12 +72,346 @@
 #include <pthread_np.h>
 #endif
 
+#if OS(UNIX)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if OS(LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace WTF;
 
 QT_BEGIN_NAMESPACE
 
 using namespace QV4;
 
+namespace {
+
+#if OS(LINUX)
+// The soft-dirty bits are per process, so every memory manager needs to know
+// whether another one has reset them since its own last collection.
+static QBasicAtomicInt softDirtyResets = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+// Keeps track of the pages written to since the last garbage collection, using
+// the soft-dirty bits the kernel maintains for every page of the process. This
+// is the write barrier for minor collections: any store into an old object,
+// whether it comes from C++ code or from JIT generated code, dirties its page.
+//
+// The kernel can only reset the bits of the whole process, not of the heap chunks
+// alone. A reset walks the page tables of every mapping, so its cost grows with the
+// resident set of the process rather than with the JS heap, and it clears the bits
+// for anybody else relying on them as well, such as checkpointing tools that do
+// incremental dumps. The time spent in resets is part of the collection statistics,
+// and minor collections are given up on when they get as slow as full ones.
+class SoftDirtyPages
+{
+public:
+    SoftDirtyPages()
+        : pagemapFd(-1)
+        , clearRefsFd(-1)
+    {}
+
+    ~SoftDirtyPages()
+    {
+        close();
+    }
+
+    bool init()
+    {
+        pagemapFd = ::open("/proc/self/pagemap", O_RDONLY);
+        clearRefsFd = ::open("/proc/self/clear_refs", O_WRONLY);
+        if (pagemapFd == -1 || clearRefsFd == -1) {
+            close();
+            return false;
+        }
+
+        // The kernel might not have been built with CONFIG_MEM_SOFT_DIRTY, so check
+        // that writing to a clean page really sets the bit.
+        PageAllocation probe = PageAllocation::allocate(WTF::pageSize(), OSAllocator::JSGCHeapPages);
+        volatile char *page = reinterpret_cast<char *>(probe.base());
+        page[0] = 1;
+        quint64 flags = 0;
+        bool ok = reset() != -1 && readFlags(reinterpret_cast<char *>(probe.base()), 1, &flags) && !isDirty(flags);
+        page[0] = 2;
+        ok = ok && readFlags(reinterpret_cast<char *>(probe.base()), 1, &flags) && isDirty(flags);
+        probe.deallocate();
+
+        if (!ok)
+            close();
+        return ok;
+    }
+
+    // Returns the number of resets so far, or -1 on failure.
+    int reset()
+    {
+        const int resets = softDirtyResets.fetchAndAddOrdered(1) + 1;
+        return ::write(clearRefsFd, "4", 1) == 1 ? resets : -1;
+    }
+
+    static bool isResetSince(int resets)
+    {
+        return softDirtyResets.load() != resets;
+    }
+
+    // begin has to be page aligned. If the flags can't be read all pages are reported as dirty.
+    bool readFlags(const char *begin, size_t nPages, quint64 *flags) const
+    {
+        const size_t pageSize = WTF::pageSize();
+        const off_t offset = off_t(reinterpret_cast<quintptr>(begin) / pageSize * sizeof(quint64));
+        const ssize_t size = ssize_t(nPages * sizeof(quint64));
+        if (::pread(pagemapFd, flags, size, offset) == size)
+            return true;
+        for (size_t i = 0; i < nPages; ++i)
+            flags[i] = SoftDirtyBit;
+        return false;
+    }
+
+    static bool isDirty(quint64 flags)
+    {
+        return flags & SoftDirtyBit;
+    }
+
+private:
+    static const quint64 SoftDirtyBit = Q_UINT64_C(1) << 55;
+
+    void close()
+    {
+        if (pagemapFd != -1)
+            ::close(pagemapFd);
+        if (clearRefsFd != -1)
+            ::close(clearRefsFd);
+        pagemapFd = -1;
+        clearRefsFd = -1;
+    }
+
+    int pagemapFd;
+    int clearRefsFd;
+};
+#endif
+
+// The index, plus one, of the parallel marking worker the current thread acts as.
+Q_GLOBAL_STATIC(QThreadStorage<int>, markWorkerIndex)
+
+// Spreads the transitive closure of the mark phase over several threads. Every worker
+// scans the objects on its own stack. Once it has plenty of them while others are idle,
+// it moves half of them to its shared queue, from which the idle workers steal.
+class ParallelMarker
+{
+public:
+    ParallelMarker(ExecutionEngine *engine, int threadCount);
+    ~ParallelMarker();
+
+    // Marks everything reachable from the grey items in [begin, end) of the JS stack,
+    // using the calling thread as the first worker.
+    void mark(Value *begin, Value *end);
+
+    void push(Heap::Base *m)
+    {
+        m_workers.at(markWorkerIndex()->localData() - 1)->stack.append(m);
+    }
+
+private:
+    enum { ShareThreshold = 64 };
+
+    struct Worker {
+        QVector<Heap::Base *> stack;
+        QMutex sharedLock;
+        QVector<Heap::Base *> shared;
+    };
+
+    class Thread : public QThread
+    {
+    public:
+        Thread(ParallelMarker *marker, int index) : marker(marker), index(index) {}
+        void run() Q_DECL_OVERRIDE;
+
+    private:
+        ParallelMarker *marker;
+        int index;
+    };
+
+    void work(int index);
+    void share(Worker *worker);
+    bool steal(int index);
+    bool waitForWork();
+
+    ExecutionEngine *m_engine;
+    QVector<Worker *> m_workers;
+    QVector<Thread *> m_threads;
+
+    QMutex m_mutex;
+    QWaitCondition m_started;
+    QWaitCondition m_workAvailable;
+    QWaitCondition m_finished;
+    QAtomicInt m_idle;
+    QAtomicInt m_sharedItems;
+    uint m_phase;
+    int m_running;
+    bool m_done;
+    bool m_quit;
+};
+
+ParallelMarker::ParallelMarker(ExecutionEngine *engine, int threadCount)
+    : m_engine(engine)
+    , m_phase(0)
+    , m_running(0)
+    , m_done(false)
+    , m_quit(false)
+{
+    for (int i = 0; i < threadCount; ++i)
+        m_workers.append(new Worker);
+}
+
+ParallelMarker::~ParallelMarker()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_started.wakeAll();
+    }
+    foreach (Thread *thread, m_threads) {
+        thread->wait();
+        delete thread;
+    }
+    qDeleteAll(m_workers);
+}
+
+void ParallelMarker::Thread::run()
+{
+    markWorkerIndex()->setLocalData(index + 1);
+    uint phase = 0;
+    forever {
+        {
+            QMutexLocker locker(&marker->m_mutex);
+            while (marker->m_phase == phase && !marker->m_quit)
+                marker->m_started.wait(&marker->m_mutex);
+            if (marker->m_quit)
+                return;
+            phase = marker->m_phase;
+        }
+
+        marker->work(index);
+
+        QMutexLocker locker(&marker->m_mutex);
+        if (--marker->m_running == 0)
+            marker->m_finished.wakeAll();
+    }
+}
+
+void ParallelMarker::mark(Value *begin, Value *end)
+{
+    if (m_threads.isEmpty()) {
+        for (int i = 1; i < m_workers.size(); ++i) {
+            m_threads.append(new Thread(this, i));
+            m_threads.last()->start();
+        }
+    }
+
+    Worker *first = m_workers.at(0);
+    for (Value *v = begin; v < end; ++v)
+        first->stack.append(v->heapObject());
+
+    m_engine->markingInParallel = true;
+    markWorkerIndex()->setLocalData(1);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_done = false;
+        m_idle.store(0);
+        m_running = m_threads.size();
+        ++m_phase;
+        m_started.wakeAll();
+    }
+
+    work(0);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_running)
+            m_finished.wait(&m_mutex);
+    }
+    markWorkerIndex()->setLocalData(0);
+    m_engine->markingInParallel = false;
+}
+
+void ParallelMarker::work(int index)
+{
+    Worker *worker = m_workers.at(index);
+    forever {
+        while (!worker->stack.isEmpty()) {
+            Heap::Base *h = worker->stack.last();
+            worker->stack.removeLast();
+            Q_ASSERT(h->gcGetVtable()->markObjects);
+            h->gcGetVtable()->markObjects(h, m_engine);
+            if (worker->stack.size() > ShareThreshold && m_idle.load() && !m_sharedItems.load())
+                share(worker);
+        }
+        if (!steal(index) && !waitForWork())
+            return;
+    }
+}
+
+void ParallelMarker::share(Worker *worker)
+{
+    // The items at the bottom of the stack tend to lead to the largest parts of the heap.
+    const int n = worker->stack.size() / 2;
+    {
+        QMutexLocker locker(&worker->sharedLock);
+        worker->shared += worker->stack.mid(0, n);
+        m_sharedItems.fetchAndAddRelaxed(n);
+    }
+    worker->stack.remove(0, n);
+
+    QMutexLocker locker(&m_mutex);
+    m_workAvailable.wakeAll();
+}
+
+bool ParallelMarker::steal(int index)
+{
+    if (!m_sharedItems.load())
+        return false;
+
+    Worker *thief = m_workers.at(index);
+    for (int i = 0; i < m_workers.size(); ++i) {
+        Worker *victim = m_workers.at((index + i) % m_workers.size());
+        QMutexLocker locker(&victim->sharedLock);
+        const int size = victim->shared.size();
+        if (!size)
+            continue;
+        const int n = (size + 1) / 2;
+        thief->stack += victim->shared.mid(size - n);
+        victim->shared.resize(size - n);
+        m_sharedItems.fetchAndAddRelaxed(-n);
+        return true;
+    }
+    return false;
+}
+
+bool ParallelMarker::waitForWork()
+{
+    QMutexLocker locker(&m_mutex);
+    m_idle.ref();
+    forever {
+        if (m_done)
+            return false;
+        if (m_sharedItems.load()) {
+            m_idle.deref();
+            return true;
+        }
+        // nobody is scanning anything anymore, and nothing is left to steal
+        if (m_idle.load() == m_workers.size()) {
+            m_done = true;
+            m_workAvailable.wakeAll();
+            return false;
+        }
+        m_workAvailable.wait(&m_mutex);
+    }
+}
+
+} // namespace
+
 struct MemoryManager::Data
 {
     struct ChunkHeader {
@@ -78,15 +420,70 @@ struct MemoryManager::Data
         char *itemStart;
         char *itemEnd;
         int itemSize;
+        // set when items were allocated from this chunk since the last collection
+        bool hasNurseryItems;
+        ChunkHeader *nextUnswept;
     };
 
     bool gcBlocked;
     bool aggressiveGC;
     bool gcStats;
+    // In generational mode mark bits are sticky: everything that survived a collection
+    // stays marked and forms the old generation, which is only collected again in a
+    // full collection. Minor collections only sweep chunks holding nursery items.
+    bool generational;
+    uint minorCollections;
+    uint maxMinorCollections;
+    // Incremental marking keeps the grey objects (marked, but not scanned yet) in greyItems
+    // between steps. Black objects (marked and scanned) that get written to by the mutator
+    // in the meantime are found through the dirty pages and scanned again in the final pause.
+    bool incremental;
+    bool markingInProgress;
+    QVector<Heap::Base *> greyItems;
+    // With lazy sweeping the chunks are swept by allocData() when it runs out of free items of
+    // their size, so that the mutator can continue right after marking. Whatever is left unswept
+    // is taken care of before the next collection.
+    bool lazySweep;
+    // Percentage of free items in the chunks above which a full collection compacts the heap,
+    // 0 to only compact on explicit collections (QV4_MM_COMPACT_THRESHOLD).
+    int compactThreshold;
+    // The number of threads marking in parallel (QV4_MM_MARK_THREADS, 0 for one per core).
+    int markThreads;
+    ParallelMarker *parallelMarker;
+    // With a heap growth factor set (QV4_MM_HEAP_GROWTH), a collection is due once the bytes
+    // allocated since the last one exceed allocationBudget. The budget follows the live heap
+    // size and survival rate measured by full collections, and the share of the run time
+    // spent in collection pauses (QV4_MM_PAUSE_BUDGET, in percent), see updateAllocationBudget().
+    bool adaptiveTrigger;
+    double heapGrowth;
+    int pauseBudget;
+    double growthScale;
+    size_t minAllocationBudget;
+    size_t maxHeapSize;
+    size_t allocationBudget;
+    bool measuringSurvival;
+    size_t sweptLiveBytes;
+    size_t sweptFreedBytes;
+    QElapsedTimer budgetTimer;
+    qint64 budgetPause;
     ExecutionEngine *engine;
 
     enum { MaxItemSize = 512 };
     ChunkHeader *nonFullChunks[MaxItemSize/16];
+    ChunkHeader *unsweptChunks[MaxItemSize/16];
+    // The engine is only used from one thread, so these are effectively thread local.
+    char *bumpTop[MaxItemSize/16];
+    char *bumpLimit[MaxItemSize/16];
+    ChunkHeader *bumpChunk[MaxItemSize/16];
+    // Runs of items that are all zero, either because the bump allocator didn't get to them
+    // yet or because compact() gave their pages back to the OS. They are not part of the free
+    // list of their chunk, sweeping leaves them alone and allocData() bump allocates from them.
+    struct ItemRange {
+        ChunkHeader *header;
+        char *begin;
+        char *end;
+    };
+    QVector<ItemRange> zeroedItems[MaxItemSize/16];
     uint nChunks[MaxItemSize/16];
     uint availableItems[MaxItemSize/16];
     uint allocCount[MaxItemSize/16];
@@ -96,9 +493,20 @@ struct MemoryManager::Data
     std::size_t maxChunkSize;
     QVector<PageAllocation> heapChunks;
 
+    uint collections;
+    qint64 maxPause;
+    qint64 totalPause;
+    qint64 markTime;
+    quint64 allocatedBytes;
+    enum { MaxRecentCollections = 32 };
+    QVector<MemoryManager::CollectionStatistics> recentCollections;
+
     struct LargeItem {
         LargeItem *next;
         size_t size;
+        // the size of the item's own page mapping, 0 if it comes from malloc
+        size_t mappedSize;
+        size_t padding;
         void *data;
 
         Heap::Base *heapObject() {
@@ -106,11 +514,31 @@ struct MemoryManager::Data
         }
     };
 
+    // Items spanning several pages get mappings of their own, so that they can be given
+    // back to the OS right away instead of fragmenting the C heap. The mappings of the
+    // last few that got collected are kept around, with their pages released, for reuse.
+    enum { LargeItemMappingPages = 4, MaxUnusedLargeItemMappings = 8 };
     LargeItem *largeItems;
     std::size_t totalLargeItemsAllocated;
+    std::size_t largeItemsMem;
+    std::size_t largeItemsMappedMem;
+    uint largeItemCount;
+    QVector<LargeItem *> unusedLargeItemMappings;
 
     GCDeletable *deletable;
 
+#if OS(LINUX)
+    SoftDirtyPages dirtyPages;
+    int dirtyPagesResets;
+    QVector<quint64> pageFlags;
+#endif
+    // The pause of the last full collection that wasn't forced, without resetting the
+    // dirty pages, or -1 if there was none yet. Once MaxSlowMinorCollections minor
+    // collections in a row take at least as long, only full collections are run.
+    enum { MaxSlowMinorCollections = 3 };
+    qint64 fullCollectionPause;
+    uint slowMinorCollections;
+
     // statistics:
 #ifdef DETAILED_MM_STATS
     QVector<unsigned> allocSizeCounters;
@@ -118,21 +546,56 @@ struct MemoryManager::Data
 
     Data()
         : gcBlocked(false)
+        , generational(false)
+        , minorCollections(0)
+        , maxMinorCollections(8)
+        , incremental(false)
+        , markingInProgress(false)
+        , lazySweep(false)
+        , compactThreshold(0)
+        , markThreads(1)
+        , parallelMarker(0)
+        , adaptiveTrigger(false)
+        , heapGrowth(2)
+        , pauseBudget(5)
+        , growthScale(1)
+        , minAllocationBudget(0)
+        , maxHeapSize(0)
+        , allocationBudget(0)
+        , measuringSurvival(false)
+        , sweptLiveBytes(0)
+        , sweptFreedBytes(0)
+        , budgetPause(0)
         , engine(0)
         , totalItems(0)
         , totalAlloc(0)
         , maxShift(6)
         , maxChunkSize(32*1024)
+        , collections(0)
+        , maxPause(0)
+        , totalPause(0)
+        , markTime(0)
+        , allocatedBytes(0)
         , largeItems(0)
         , totalLargeItemsAllocated(0)
+        , largeItemsMem(0)
+        , largeItemsMappedMem(0)
+        , largeItemCount(0)
         , deletable(0)
+        , fullCollectionPause(-1)
+        , slowMinorCollections(0)
     {
         memset(nonFullChunks, 0, sizeof(nonFullChunks));
+        memset(unsweptChunks, 0, sizeof(unsweptChunks));
+        memset(bumpTop, 0, sizeof(bumpTop));
+        memset(bumpLimit, 0, sizeof(bumpLimit));
+        memset(bumpChunk, 0, sizeof(bumpChunk));
         memset(nChunks, 0, sizeof(nChunks));
         memset(availableItems, 0, sizeof(availableItems));
         memset(allocCount, 0, sizeof(allocCount));
         aggressiveGC = !qgetenv("QV4_MM_AGGRESSIVE_GC").isEmpty();
         gcStats = !qgetenv("QV4_MM_STATS").isEmpty();
+        lazySweep = !qgetenv("QV4_MM_LAZY_SWEEP").isEmpty();
 
         QByteArray overrideMaxShift = qgetenv("QV4_MM_MAXBLOCK_SHIFT");
         bool ok;
@@ -144,10 +607,66 @@ struct MemoryManager::Data
         std::size_t tmpMaxChunkSize = maxChunkString.toUInt(&ok);
         if (ok)
             maxChunkSize = tmpMaxChunkSize;
+
+#if OS(LINUX)
+        dirtyPagesResets = -1;
+        generational = !qgetenv("QV4_MM_GENERATIONAL").isEmpty();
+        incremental = !qgetenv("QV4_MM_INCREMENTAL").isEmpty();
+        if ((generational || incremental) && !dirtyPages.init()) {
+            generational = false;
+            incremental = false;
+        }
+#endif
+
+        QByteArray compactThresholdString = qgetenv("QV4_MM_COMPACT_THRESHOLD");
+        int tmpCompactThreshold = compactThresholdString.toInt(&ok);
+        if (ok && tmpCompactThreshold > 0 && tmpCompactThreshold < 100)
+            compactThreshold = tmpCompactThreshold;
+
+        QByteArray markThreadsString = qgetenv("QV4_MM_MARK_THREADS");
+        int tmpMarkThreads = markThreadsString.toInt(&ok);
+        if (ok && tmpMarkThreads == 0)
+            tmpMarkThreads = QThread::idealThreadCount();
+        if (ok && tmpMarkThreads > 0)
+            markThreads = tmpMarkThreads;
+
+        QByteArray heapGrowthString = qgetenv("QV4_MM_HEAP_GROWTH");
+        double tmpHeapGrowth = heapGrowthString.toDouble(&ok);
+        if (ok && tmpHeapGrowth > 1) {
+            adaptiveTrigger = true;
+            heapGrowth = tmpHeapGrowth;
+        }
+
+        QByteArray pauseBudgetString = qgetenv("QV4_MM_PAUSE_BUDGET");
+        int tmpPauseBudget = pauseBudgetString.toInt(&ok);
+        if (ok && tmpPauseBudget > 0 && tmpPauseBudget < 100)
+            pauseBudget = tmpPauseBudget;
+
+        // Scale the limits of the budget with the device, a small heap shouldn't be collected
+        // all the time on a workstation, and a large one shouldn't take all of a small device.
+        quint64 physicalMemory = quint64(1) << 30;
+#if OS(UNIX) && defined(_SC_PHYS_PAGES)
+        const long physicalPages = sysconf(_SC_PHYS_PAGES);
+        if (physicalPages > 0)
+            physicalMemory = quint64(physicalPages) * quint64(sysconf(_SC_PAGESIZE));
+#endif
+        minAllocationBudget = size_t(qBound(quint64(1) << 20, physicalMemory / 256, quint64(64) << 20));
+        maxHeapSize = size_t(qMin(physicalMemory / 2, quint64(std::numeric_limits<size_t>::max() / 2)));
+        allocationBudget = minAllocationBudget;
+        if (adaptiveTrigger)
+            budgetTimer.start();
+
+        QByteArray maxMinorString = qgetenv("QV4_MM_MAX_MINOR_COLLECTIONS");
+        uint tmpMaxMinor = maxMinorString.toUInt(&ok);
+        if (ok)
+            maxMinorCollections = tmpMaxMinor;
     }
 
     ~Data()
     {
+        delete parallelMarker;
+        for (int i = 0; i < unusedLargeItemMappings.size(); ++i)
+            OSAllocator::decommitAndRelease(unusedLargeItemMappings.at(i), unusedLargeItemMappings.at(i)->mappedSize);
         for (QVector<PageAllocation>::iterator i = heapChunks.begin(), ei = heapChunks.end(); i != ei; ++i) {
             Q_V4_PROFILE_DEALLOC(engine, 0, i->size(), Profiling::HeapPage);
             i->deallocate();
@@ -157,10 +676,11 @@ struct MemoryManager::Data
 
 namespace {
 
-bool sweepChunk(MemoryManager::Data::ChunkHeader *header, uint *itemsInUse, ExecutionEngine *engine)
+bool sweepChunk(MemoryManager::Data *d, MemoryManager::Data::ChunkHeader *header, uint *itemsInUse)
 {
     bool isEmpty = true;
     Heap::Base *tail = &header->freeItems;
+    header->hasNurseryItems = false;
 //    qDebug("chunkStart @ %p, size=%x, pos=%x", header->itemStart, header->itemSize, header->itemSize>>4);
 #ifdef V4_USE_VALGRIND
     VALGRIND_DISABLE_ERROR_REPORTING;
@@ -172,11 +692,18 @@ bool sweepChunk(MemoryManager::Data::ChunkHeader *header, uint *itemsInUse, Exec
 
         Q_ASSERT((qintptr) item % 16 == 0);
 
+        if (!m->mm_data) {
+            // zeroed item, see MemoryManager::Data::zeroedItems
+            continue;
+        }
+
         if (m->isMarked()) {
             Q_ASSERT(m->inUse());
-            m->clearMarkBit();
+            if (!d->generational)
+                m->clearMarkBit();
             isEmpty = false;
             ++(*itemsInUse);
+            d->sweptLiveBytes += header->itemSize;
         } else {
             if (m->inUse()) {
 //                qDebug() << "-- collecting it." << m << tail << m->nextFree();
@@ -189,10 +716,11 @@ bool sweepChunk(MemoryManager::Data::ChunkHeader *header, uint *itemsInUse, Exec
                 memset(m, 0, header->itemSize);
 #ifdef V4_USE_VALGRIND
                 VALGRIND_DISABLE_ERROR_REPORTING;
-                VALGRIND_MEMPOOL_FREE(engine->memoryManager, m);
+                VALGRIND_MEMPOOL_FREE(d->engine->memoryManager, m);
 #endif
-                Q_V4_PROFILE_DEALLOC(engine, m, header->itemSize, Profiling::SmallItem);
+                Q_V4_PROFILE_DEALLOC(d->engine, m, header->itemSize, Profiling::SmallItem);
                 ++(*itemsInUse);
+                d->sweptFreedBytes += header->itemSize;
             }
             // Relink all free blocks to rewrite references to any released chunk.
             tail->setNextFree(m);
@@ -206,6 +734,109 @@ bool sweepChunk(MemoryManager::Data::ChunkHeader *header, uint *itemsInUse, Exec
     return isEmpty;
 }
 
+QVector<PageAllocation>::iterator releaseChunk(MemoryManager::Data *d, QVector<PageAllocation>::iterator chunk)
+{
+    MemoryManager::Data::ChunkHeader *header = reinterpret_cast<MemoryManager::Data::ChunkHeader *>(chunk->base());
+    const size_t pos = header->itemSize >> 4;
+    const size_t decrease = (header->itemEnd - header->itemStart) / header->itemSize;
+
+    QVector<MemoryManager::Data::ItemRange> &zeroedItems = d->zeroedItems[pos];
+    for (int i = zeroedItems.size() - 1; i >= 0; --i) {
+        if (zeroedItems.at(i).header == header)
+            zeroedItems.remove(i);
+    }
+
+    Q_V4_PROFILE_DEALLOC(d->engine, 0, chunk->size(), Profiling::HeapPage);
+#ifdef V4_USE_VALGRIND
+    VALGRIND_MEMPOOL_FREE(d->engine->memoryManager, header);
+#endif
+    --d->nChunks[pos];
+    d->availableItems[pos] -= uint(decrease);
+    d->totalItems -= int(decrease);
+    chunk->deallocate();
+    return d->heapChunks.erase(chunk);
+}
+
+MemoryManager::Data::LargeItem *allocateLargeItem(MemoryManager::Data *d, size_t size)
+{
+    typedef MemoryManager::Data::LargeItem LargeItem;
+    const size_t pageSize = WTF::pageSize();
+    const size_t totalSize = size + sizeof(LargeItem);
+    LargeItem *item = 0;
+
+    if (totalSize < MemoryManager::Data::LargeItemMappingPages * pageSize) {
+        item = static_cast<LargeItem *>(malloc(totalSize));
+        memset(item, 0, totalSize);
+        item->mappedSize = 0;
+    } else {
+        // take the smallest unused mapping that fits without wasting more than half of it
+        const size_t mappedSize = roundUpToMultipleOf(pageSize, totalSize);
+        int best = -1;
+        for (int i = 0; i < d->unusedLargeItemMappings.size(); ++i) {
+            const size_t unusedSize = d->unusedLargeItemMappings.at(i)->mappedSize;
+            if (unusedSize >= mappedSize && unusedSize / 2 < mappedSize
+                    && (best == -1 || unusedSize < d->unusedLargeItemMappings.at(best)->mappedSize)) {
+                best = i;
+            }
+        }
+
+        if (best != -1) {
+            item = d->unusedLargeItemMappings.at(best);
+            d->unusedLargeItemMappings.remove(best);
+#if !OS(LINUX)
+            // only Linux guarantees released pages to read back as zero
+            const size_t itemMappedSize = item->mappedSize;
+            memset(item, 0, totalSize);
+            item->mappedSize = itemMappedSize;
+#endif
+        } else {
+            // fresh pages are zero already, sparing the memset of the whole item
+            item = static_cast<LargeItem *>(OSAllocator::reserveAndCommit(mappedSize, OSAllocator::JSGCHeapPages));
+            item->mappedSize = mappedSize;
+            d->largeItemsMappedMem += mappedSize;
+        }
+    }
+
+    item->size = size;
+    d->largeItemsMem += size;
+    ++d->largeItemCount;
+    return item;
+}
+
+void freeLargeItem(MemoryManager::Data *d, MemoryManager::Data::LargeItem *item)
+{
+    d->largeItemsMem -= item->size;
+    --d->largeItemCount;
+
+    if (!item->mappedSize) {
+        free(item);
+        return;
+    }
+
+    if (d->unusedLargeItemMappings.size() < MemoryManager::Data::MaxUnusedLargeItemMappings) {
+        const size_t mappedSize = item->mappedSize;
+#if OS(UNIX)
+        madvise(item, mappedSize, MADV_DONTNEED);
+#endif
+        item->mappedSize = mappedSize;
+        d->unusedLargeItemMappings.append(item);
+        return;
+    }
+
+    d->largeItemsMappedMem -= item->mappedSize;
+    OSAllocator::decommitAndRelease(item, item->mappedSize);
+}
+
+void releaseUnusedLargeItemMappings(MemoryManager::Data *d)
+{
+    for (int i = 0; i < d->unusedLargeItemMappings.size(); ++i) {
+        MemoryManager::Data::LargeItem *item = d->unusedLargeItemMappings.at(i);
+        d->largeItemsMappedMem -= item->mappedSize;
+        OSAllocator::decommitAndRelease(item, item->mappedSize);
+    }
+    d->unusedLargeItemMappings.clear();
+}
+
 } // namespace
 
 MemoryManager::MemoryManager(ExecutionEngine *engine)
@@ -217,6 +848,8 @@ MemoryManager::MemoryManager(ExecutionEngine *engine)
     VALGRIND_CREATE_MEMPOOL(this, 0, true);
 #endif
     m_d->engine = engine;
+    if (m_d->markThreads > 1)
+        m_d->parallelMarker = new ParallelMarker(engine, m_d->markThreads);
 }
 
 Heap::Base *MemoryManager::allocData(std::size_t size)
@@ -234,31 +867,45 @@ Heap::Base *MemoryManager::allocData(std::size_t size)
 
     // doesn't fit into a small bucket
     if (size >= MemoryManager::Data::MaxItemSize) {
-        if (m_d->totalLargeItemsAllocated > 8 * 1024 * 1024)
+        if (m_d->adaptiveTrigger ? m_d->allocatedBytes > m_d->allocationBudget
+                                 : m_d->totalLargeItemsAllocated > 8 * 1024 * 1024)
             runGC();
 
-        // we use malloc for this
-        MemoryManager::Data::LargeItem *item = static_cast<MemoryManager::Data::LargeItem *>(
-                malloc(Q_V4_PROFILE_ALLOC(m_d->engine, size + sizeof(MemoryManager::Data::LargeItem),
-                                          Profiling::LargeItem)));
-        memset(item, 0, size + sizeof(MemoryManager::Data::LargeItem));
+        (void)Q_V4_PROFILE_ALLOC(m_d->engine, size + sizeof(Data::LargeItem), Profiling::LargeItem);
+        Data::LargeItem *item = allocateLargeItem(m_d.data(), size);
         item->next = m_d->largeItems;
-        item->size = size;
         m_d->largeItems = item;
         m_d->totalLargeItemsAllocated += size;
+        m_d->allocatedBytes += size;
         return item->heapObject();
     }
 
     Heap::Base *m = 0;
-    Data::ChunkHeader *header = m_d->nonFullChunks[pos];
+    Data::ChunkHeader *header = 0;
+
+    // Fresh chunks are handed out front to back, sparing the allocation the dependent load
+    // of the next free item. Their free lists only come into play once they got swept.
+    if (m_d->bumpTop[pos] < m_d->bumpLimit[pos]) {
+        m = reinterpret_cast<Heap::Base *>(m_d->bumpTop[pos]);
+        m_d->bumpTop[pos] += size;
+        goto bumped;
+    }
+
+    if (!m_d->nonFullChunks[pos] && m_d->unsweptChunks[pos])
+        sweepLazily(pos);
+    header = m_d->nonFullChunks[pos];
     if (header) {
         m = header->freeItems.nextFree();
         goto found;
     }
 
     // try to free up space, otherwise allocate
-    if (m_d->allocCount[pos] > (m_d->availableItems[pos] >> 1) && m_d->totalAlloc > (m_d->totalItems >> 1) && !m_d->aggressiveGC) {
+    if ((m_d->adaptiveTrigger ? m_d->allocatedBytes > m_d->allocationBudget
+                              : m_d->allocCount[pos] > (m_d->availableItems[pos] >> 1) && m_d->totalAlloc > (m_d->totalItems >> 1))
+            && !m_d->aggressiveGC) {
         runGC();
+        if (!m_d->nonFullChunks[pos] && m_d->unsweptChunks[pos])
+            sweepLazily(pos);
         header = m_d->nonFullChunks[pos];
         if (header) {
             m = header->freeItems.nextFree();
@@ -266,7 +913,21 @@ Heap::Base *MemoryManager::allocData(std::size_t size)
         }
     }
 
-    // no free item available, allocate a new chunk
+    // Bump allocate from zeroed items before asking the OS for more memory. Their chunk is
+    // swept already, as sweeping would take the new items for garbage.
+    Q_ASSERT(!m_d->unsweptChunks[pos]);
+    if (!m_d->zeroedItems[pos].isEmpty()) {
+        const Data::ItemRange range = m_d->zeroedItems[pos].takeLast();
+        header = range.header;
+        header->hasNurseryItems = true;
+        m = reinterpret_cast<Heap::Base *>(range.begin);
+        m_d->bumpTop[pos] = range.begin + size;
+        m_d->bumpLimit[pos] = range.end;
+        m_d->bumpChunk[pos] = header;
+        goto bumped;
+    }
+
+    // no free item available, allocate a new chunk and bump allocate from it
     {
         // allocate larger chunks at a time to avoid excessive GC, but cap at maximum chunk size (2MB by default)
         uint shift = ++m_d->nChunks[pos];
@@ -284,19 +945,14 @@ Heap::Base *MemoryManager::allocData(std::size_t size)
         header->itemSize = int(size);
         header->itemStart = reinterpret_cast<char *>(allocation.base()) + roundUpToMultipleOf(16, sizeof(Data::ChunkHeader));
         header->itemEnd = reinterpret_cast<char *>(allocation.base()) + allocation.size() - header->itemSize;
+        header->hasNurseryItems = true;
 
-        header->nextNonFull = m_d->nonFullChunks[pos];
-        m_d->nonFullChunks[pos] = header;
-
-        Heap::Base *last = &header->freeItems;
-        for (char *item = header->itemStart; item <= header->itemEnd; item += header->itemSize) {
-            Heap::Base *o = reinterpret_cast<Heap::Base *>(item);
-            last->setNextFree(o);
-            last = o;
+        // The pages are zeroed, so the items don't need any initialization, see zeroedItems.
+        m = reinterpret_cast<Heap::Base *>(header->itemStart);
+        m_d->bumpTop[pos] = header->itemStart + size;
+        m_d->bumpLimit[pos] = header->itemEnd + 1;
+        m_d->bumpChunk[pos] = header;
 
-        }
-        last->setNextFree(0);
-        m = header->freeItems.nextFree();
         const size_t increase = (header->itemEnd - header->itemStart) / header->itemSize;
         m_d->availableItems[pos] += uint(increase);
         m_d->totalItems += int(increase);
@@ -304,6 +960,7 @@ Heap::Base *MemoryManager::allocData(std::size_t size)
         VALGRIND_MAKE_MEM_NOACCESS(allocation.base(), allocSize);
         VALGRIND_MEMPOOL_ALLOC(this, header, sizeof(Data::ChunkHeader));
 #endif
+        goto bumped;
     }
 
   found:
@@ -314,10 +971,41 @@ Heap::Base *MemoryManager::allocData(std::size_t size)
 
     ++m_d->allocCount[pos];
     ++m_d->totalAlloc;
+    m_d->allocatedBytes += size;
+    header->hasNurseryItems = true;
     header->freeItems.setNextFree(m->nextFree());
     if (!header->freeItems.nextFree())
         m_d->nonFullChunks[pos] = header->nextNonFull;
     return m;
+
+  bumped:
+#ifdef V4_USE_VALGRIND
+    VALGRIND_MEMPOOL_ALLOC(this, m, size);
+#endif
+    Q_V4_PROFILE_ALLOC(m_d->engine, size, Profiling::SmallItem);
+
+    ++m_d->allocCount[pos];
+    ++m_d->totalAlloc;
+    m_d->allocatedBytes += size;
+    return m;
+}
+
+void MemoryManager::endBumpAllocation(std::size_t pos)
+{
+    // Keep the items that were not handed out yet for later instead of touching their pages.
+    if (m_d->bumpTop[pos] < m_d->bumpLimit[pos]) {
+        const Data::ItemRange range = { m_d->bumpChunk[pos], m_d->bumpTop[pos], m_d->bumpLimit[pos] };
+        m_d->zeroedItems[pos].append(range);
+    }
+    m_d->bumpTop[pos] = 0;
+    m_d->bumpLimit[pos] = 0;
+    m_d->bumpChunk[pos] = 0;
+}
+
+void MemoryManager::endBumpAllocation()
+{
+    for (std::size_t pos = 0; pos < Data::MaxItemSize/16; ++pos)
+        endBumpAllocation(pos);
 }
 
 static void drainMarkStack(QV4::ExecutionEngine *engine, Value *markBase)
@@ -329,8 +1017,419 @@ static void drainMarkStack(QV4::ExecutionEngine *engine, Value *markBase)
     }
 }
 
+static inline void markOldObject(QV4::ExecutionEngine *engine, Heap::Base *m, Value *markBase)
+{
+    // Only old objects need to be looked at, young ones are found by the regular
+    // traversal if they are reachable at all.
+    if (!m->inUse() || !m->isMarked())
+        return;
+    if (m->gcGetVtable()->markObjects)
+        m->gcGetVtable()->markObjects(m, engine);
+    if (engine->jsStackTop >= engine->jsStackLimit)
+        drainMarkStack(engine, markBase);
+}
+
+bool MemoryManager::collectFromDirtyPages()
+{
+#if OS(LINUX)
+    // Old objects can only point to young ones if they have been written to after the
+    // last collection, so the old objects on the pages that are dirty since then act
+    // as additional roots of a minor collection.
+    if (m_d->dirtyPagesResets == -1 || SoftDirtyPages::isResetSince(m_d->dirtyPagesResets))
+        return false;
+
+    ExecutionEngine *engine = m_d->engine;
+    Value *markBase = engine->jsStackTop;
+    const size_t pageSize = WTF::pageSize();
+    QVector<quint64> &flags = m_d->pageFlags;
+
+    for (QVector<PageAllocation>::const_iterator i = m_d->heapChunks.cbegin(), ei = m_d->heapChunks.cend(); i != ei; ++i) {
+        Data::ChunkHeader *header = reinterpret_cast<Data::ChunkHeader *>(i->base());
+        char *chunkBase = reinterpret_cast<char *>(i->base());
+        const size_t nPages = i->size() / pageSize;
+        flags.resize(int(nPages));
+        m_d->dirtyPages.readFlags(chunkBase, nPages, flags.data());
+
+        char *nextItem = header->itemStart;
+        for (size_t page = 0; page < nPages; ++page) {
+            if (!SoftDirtyPages::isDirty(flags.at(int(page))))
+                continue;
+            char *pageStart = chunkBase + page*pageSize;
+            char *pageEnd = pageStart + pageSize;
+            // start with the item overlapping the beginning of the page, unless it has already been scanned
+            char *item = header->itemStart;
+            if (pageStart > item)
+                item += (pageStart - item) / header->itemSize * header->itemSize;
+            if (item < nextItem)
+                item = nextItem;
+            for (; item < pageEnd && item <= header->itemEnd; item += header->itemSize)
+                markOldObject(engine, reinterpret_cast<Heap::Base *>(item), markBase);
+            nextItem = item;
+        }
+    }
+
+    for (Data::LargeItem *item = m_d->largeItems; item; item = item->next) {
+        Heap::Base *m = item->heapObject();
+        if (!m->isMarked())
+            continue;
+        char *begin = reinterpret_cast<char *>(quintptr(item) & ~quintptr(pageSize - 1));
+        char *end = reinterpret_cast<char *>(m) + item->size;
+        const size_t nPages = (end - begin + pageSize - 1) / pageSize;
+        flags.resize(int(nPages));
+        m_d->dirtyPages.readFlags(begin, nPages, flags.data());
+        for (size_t page = 0; page < nPages; ++page) {
+            if (SoftDirtyPages::isDirty(flags.at(int(page)))) {
+                markOldObject(engine, m, markBase);
+                break;
+            }
+        }
+    }
+
+    drainMarkStack(engine, markBase);
+
+    // the flags read above are only meaningful if nobody reset them in the meantime
+    return !SoftDirtyPages::isResetSince(m_d->dirtyPagesResets);
+#else
+    return false;
+#endif
+}
+
+// QObjectWrappers also reach other objects through memory that is not part of the heap: the
+// QObject and var properties of the QQmlVMEMetaObject, and the wrappers of the children of a
+// QObject without a parent. Writing to that memory doesn't dirty any heap page, so the old
+// (or, during incremental marking, already scanned) wrappers that can have such references
+// are scanned again whenever marking relies on the dirty pages.
+void MemoryManager::collectFromQObjectWrappers()
+{
+    ExecutionEngine *engine = m_d->engine;
+    Value *markBase = engine->jsStackTop;
+    for (PersistentValueStorage::Iterator it = m_weakValues->begin(); it != m_weakValues->end(); ++it) {
+        if (!(*it).isManaged())
+            continue;
+        Heap::Base *h = (*it).managed()->d();
+        if (h->gcGetVtable() != QObjectWrapper::staticVTable())
+            continue;
+        QObject *qobject = static_cast<Heap::QObjectWrapper *>(h)->object.data();
+        if (!qobject)
+            continue;
+        if (QQmlVMEMetaObject::get(qobject) || (!qobject->parent() && !qobject->children().isEmpty()))
+            markOldObject(engine, h, markBase);
+    }
+    drainMarkStack(engine, markBase);
+}
+
+// Returns the time the reset took in nanoseconds.
+qint64 MemoryManager::resetDirtyPages()
+{
+#if OS(LINUX)
+    QElapsedTimer timer;
+    timer.start();
+    m_d->dirtyPagesResets = m_d->dirtyPages.reset();
+    return timer.nsecsElapsed();
+#else
+    return 0;
+#endif
+}
+
+void MemoryManager::clearMarkBits()
+{
+    for (QVector<PageAllocation>::const_iterator i = m_d->heapChunks.cbegin(), ei = m_d->heapChunks.cend(); i != ei; ++i) {
+        Data::ChunkHeader *header = reinterpret_cast<Data::ChunkHeader *>(i->base());
+        for (char *item = header->itemStart; item <= header->itemEnd; item += header->itemSize) {
+            Heap::Base *m = reinterpret_cast<Heap::Base *>(item);
+            if (m->isMarked())
+                m->clearMarkBit();
+        }
+    }
+
+    for (Data::LargeItem *i = m_d->largeItems; i != 0; i = i->next)
+        i->heapObject()->clearMarkBit();
+}
+
+void MemoryManager::sweepLazily(std::size_t pos)
+{
+    uint itemsInUse = 0;
+    while (Data::ChunkHeader *header = m_d->unsweptChunks[pos]) {
+        m_d->unsweptChunks[pos] = header->nextUnswept;
+        sweepChunk(m_d.data(), header, &itemsInUse);
+        if (header->freeItems.nextFree()) {
+            header->nextNonFull = m_d->nonFullChunks[pos];
+            m_d->nonFullChunks[pos] = header;
+            return;
+        }
+    }
+}
+
+void MemoryManager::finishSweeping()
+{
+    QVector<Data::ChunkHeader *> emptyChunks;
+    uint itemsInUse = 0;
+    for (std::size_t pos = 0; pos < Data::MaxItemSize/16; ++pos) {
+        while (Data::ChunkHeader *header = m_d->unsweptChunks[pos]) {
+            m_d->unsweptChunks[pos] = header->nextUnswept;
+            if (sweepChunk(m_d.data(), header, &itemsInUse)) {
+                // The allocator got along without this chunk since the last collection.
+                emptyChunks.append(header);
+            } else if (header->freeItems.nextFree()) {
+                header->nextNonFull = m_d->nonFullChunks[pos];
+                m_d->nonFullChunks[pos] = header;
+            }
+        }
+    }
+
+    if (m_d->measuringSurvival)
+        updateAllocationBudget();
+
+    if (emptyChunks.isEmpty())
+        return;
+
+    std::sort(emptyChunks.begin(), emptyChunks.end());
+    QVector<PageAllocation>::iterator chunkIter = m_d->heapChunks.begin();
+    while (chunkIter != m_d->heapChunks.end()) {
+        Data::ChunkHeader *header = reinterpret_cast<Data::ChunkHeader *>(chunkIter->base());
+        if (std::binary_search(emptyChunks.constBegin(), emptyChunks.constEnd(), header))
+            chunkIter = releaseChunk(m_d.data(), chunkIter);
+        else
+            ++chunkIter;
+    }
+}
+
+void MemoryManager::compact()
+{
+    // Objects can't be moved, the engine holds on to heap pointers in too many places the
+    // collector doesn't know about. Instead, the chunks with the most items in use get filled
+    // up first, so that the sparsely populated ones can drain and be released later on, and
+    // the pages that only hold free items are given back to the OS.
+    const size_t pageSize = WTF::pageSize();
+    QVector<QPair<uint, Data::ChunkHeader *> > chunksByUse;
+    releaseUnusedLargeItemMappings(m_d.data());
+    for (std::size_t pos = 0; pos < Data::MaxItemSize/16; ++pos) {
+        Q_ASSERT(!m_d->bumpTop[pos] && !m_d->unsweptChunks[pos]);
+        m_d->zeroedItems[pos].clear();
+    }
+    memset(m_d->nonFullChunks, 0, sizeof(m_d->nonFullChunks));
+
+    QVector<PageAllocation>::iterator chunkIter = m_d->heapChunks.begin();
+    while (chunkIter != m_d->heapChunks.end()) {
+        Data::ChunkHeader *header = reinterpret_cast<Data::ChunkHeader *>(chunkIter->base());
+        const size_t pos = header->itemSize >> 4;
+        QVector<Data::ItemRange> &zeroedItems = m_d->zeroedItems[pos];
+        const int firstRange = zeroedItems.size();
+        uint itemsInUse = 0;
+
+        char *runStart = 0;
+        for (char *item = header->itemStart; ; item += header->itemSize) {
+            Heap::Base *m = reinterpret_cast<Heap::Base *>(item);
+            if (item <= header->itemEnd && !(m->inUse() && m->gcGetVtable())) {
+                if (!runStart)
+                    runStart = item;
+                continue;
+            }
+
+            if (runStart) {
+                char *discardBegin = reinterpret_cast<char *>(roundUpToMultipleOf(pageSize, quintptr(runStart)));
+                char *discardEnd = reinterpret_cast<char *>(quintptr(item) & ~quintptr(pageSize - 1));
+                if (discardEnd > discardBegin) {
+                    const Data::ItemRange range = {
+                        header,
+                        runStart + (discardBegin - runStart) / header->itemSize * header->itemSize,
+                        runStart + (discardEnd - runStart + header->itemSize - 1) / header->itemSize * header->itemSize
+                    };
+                    // Free items are zeroed by sweepChunk() except for the link to the next one.
+                    for (char *i = range.begin; i < range.end; i += header->itemSize) {
+                        if (reinterpret_cast<Heap::Base *>(i)->mm_data)
+                            reinterpret_cast<Heap::Base *>(i)->mm_data = 0;
+                    }
+#if OS(UNIX)
+                    madvise(discardBegin, discardEnd - discardBegin, MADV_DONTNEED);
+#endif
+                    zeroedItems.append(range);
+                }
+                runStart = 0;
+            }
+
+            if (item > header->itemEnd)
+                break;
+            ++itemsInUse;
+        }
+
+        if (!itemsInUse) {
+            chunkIter = releaseChunk(m_d.data(), chunkIter);
+            continue;
+        }
+
+        // relink the free items that are left
+        Heap::Base *tail = &header->freeItems;
+        int range = firstRange;
+        for (char *item = header->itemStart; item <= header->itemEnd; item += header->itemSize) {
+            if (range < zeroedItems.size() && item >= zeroedItems.at(range).begin) {
+                item = zeroedItems.at(range).end - header->itemSize;
+                ++range;
+                continue;
+            }
+            Heap::Base *m = reinterpret_cast<Heap::Base *>(item);
+            if (m->inUse() && m->gcGetVtable())
+                continue;
+            tail->setNextFree(m);
+            tail = m;
+        }
+        tail->setNextFree(0);
+
+        if (header->freeItems.nextFree())
+            chunksByUse.append(qMakePair(itemsInUse, header));
+        ++chunkIter;
+    }
+
+    // link the fullest chunks in last, so that they come first
+    std::sort(chunksByUse.begin(), chunksByUse.end());
+    for (int i = 0; i < chunksByUse.size(); ++i) {
+        Data::ChunkHeader *header = chunksByUse.at(i).second;
+        const size_t pos = header->itemSize >> 4;
+        header->nextNonFull = m_d->nonFullChunks[pos];
+        m_d->nonFullChunks[pos] = header;
+    }
+}
+
+void MemoryManager::updateAllocationBudget()
+{
+    m_d->measuringSurvival = false;
+    const size_t liveBytes = m_d->sweptLiveBytes + getLargeItemsMem();
+    const size_t sweptBytes = m_d->sweptLiveBytes + m_d->sweptFreedBytes;
+    const double survivalRate = sweptBytes ? double(m_d->sweptLiveBytes) / sweptBytes : 1;
+
+    // Let the heap grow faster while collecting takes more of the time than the pause budget
+    // allows, and return to the configured growth once it takes a lot less.
+    const qint64 elapsed = m_d->budgetTimer.restart() * 1000000;
+    const qint64 pause = m_d->totalPause - m_d->budgetPause;
+    m_d->budgetPause = m_d->totalPause;
+    if (pause * 100 > elapsed * m_d->pauseBudget)
+        m_d->growthScale = qMin(m_d->growthScale * 2, 8.0);
+    else if (pause * 200 < elapsed * m_d->pauseBudget)
+        m_d->growthScale = qMax(m_d->growthScale / 2, 1.0);
+
+    double budget = liveBytes * (m_d->heapGrowth * m_d->growthScale - 1);
+    // Collections that find little garbage are put off further.
+    budget /= qMax(1 - survivalRate, 0.25);
+
+    const size_t headroom = m_d->maxHeapSize > liveBytes ? m_d->maxHeapSize - liveBytes : 0;
+    m_d->allocationBudget = size_t(qBound(double(m_d->minAllocationBudget), budget,
+                                          double(qMax(m_d->minAllocationBudget, headroom))));
+}
+
+bool MemoryManager::isFragmented() const
+{
+    if (!m_d->compactThreshold)
+        return false;
+    const size_t allocatedMem = getAllocatedMem();
+    return allocatedMem && (allocatedMem - getUsedMem()) * 100 > allocatedMem * size_t(m_d->compactThreshold);
+}
+
+void MemoryManager::startIncrementalMarking()
+{
+    Q_ASSERT(!m_d->markingInProgress);
+    endBumpAllocation();
+    finishSweeping();
+    m_d->markingInProgress = true;
+    if (m_d->generational)
+        clearMarkBits();
+    resetDirtyPages();
+
+    // Contexts may live on the C++ stack and be gone by the time they would get scanned,
+    // so the current ones, like the rest of the JS stack, are left to the final pause.
+    Value *markBase = m_d->engine->jsStackTop;
+    m_d->engine->markObjects(/*markCurrentContexts*/false);
+    m_persistentValues->mark(m_d->engine);
+    saveGreyItems(markBase);
+}
+
+void MemoryManager::saveGreyItems(Value *markBase)
+{
+    ExecutionEngine *engine = m_d->engine;
+    for (Value *v = markBase; v < engine->jsStackTop; ++v)
+        m_d->greyItems.append(v->heapObject());
+    engine->jsStackTop = markBase;
+}
+
+bool MemoryManager::incrementalGCStep(int budgetUsecs)
+{
+    if (!m_d->incremental || m_d->gcBlocked)
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 budget = qint64(budgetUsecs) * 1000;
+
+    if (!m_d->markingInProgress) {
+        // Idle time is also good for sweeping what the allocator hasn't needed so far.
+        for (std::size_t pos = 0; pos < Data::MaxItemSize/16; ++pos) {
+            while (m_d->unsweptChunks[pos]) {
+                if (timer.nsecsElapsed() >= budget)
+                    return false;
+                Data::ChunkHeader *header = m_d->unsweptChunks[pos];
+                m_d->unsweptChunks[pos] = header->nextUnswept;
+                uint itemsInUse = 0;
+                sweepChunk(m_d.data(), header, &itemsInUse);
+                if (header->freeItems.nextFree()) {
+                    header->nextNonFull = m_d->nonFullChunks[pos];
+                    m_d->nonFullChunks[pos] = header;
+                }
+            }
+        }
+
+        // Start once half of the allocations that trigger a collection in allocData() have happened.
+        if (m_d->adaptiveTrigger ? m_d->allocatedBytes <= m_d->allocationBudget / 2
+                                 : m_d->totalAlloc <= (m_d->totalItems >> 2) && m_d->totalLargeItemsAllocated <= 4 * 1024 * 1024)
+            return false;
+        startIncrementalMarking();
+    }
+
+    ExecutionEngine *engine = m_d->engine;
+    Value *markBase = engine->jsStackTop;
+    QVector<Heap::Base *> &greyItems = m_d->greyItems;
+    while (!greyItems.isEmpty()) {
+        if (timer.nsecsElapsed() >= budget)
+            return true;
+        for (int i = 0; i < 64 && !greyItems.isEmpty(); ++i) {
+            Heap::Base *h = greyItems.takeLast();
+            Q_ASSERT(h->gcGetVtable()->markObjects);
+            h->gcGetVtable()->markObjects(h, engine);
+            saveGreyItems(markBase);
+        }
+    }
+
+    if (timer.nsecsElapsed() >= budget)
+        return true;
+
+    // Everything reachable from the heap roots is black now, finish with the atomic pause.
+    runGC();
+    return false;
+}
+
+bool MemoryManager::finishIncrementalMarking()
+{
+    Q_ASSERT(m_d->markingInProgress);
+    m_d->markingInProgress = false;
+
+    ExecutionEngine *engine = m_d->engine;
+    Value *markBase = engine->jsStackTop;
+    while (!m_d->greyItems.isEmpty()) {
+        Heap::Base *h = m_d->greyItems.takeLast();
+        h->gcGetVtable()->markObjects(h, engine);
+        if (engine->jsStackTop >= engine->jsStackLimit)
+            drainMarkStack(engine, markBase);
+    }
+    drainMarkStack(engine, markBase);
+    m_d->greyItems.squeeze();
+
+    // Stores into QML properties and QObject parents between the steps don't dirty any page.
+    collectFromQObjectWrappers();
+    return collectFromDirtyPages();
+}
+
 void MemoryManager::mark()
 {
+    QElapsedTimer markTimer;
+    markTimer.start();
     Value *markBase = m_d->engine->jsStackTop;
 
     m_d->engine->markObjects();
@@ -374,10 +1473,25 @@ void MemoryManager::mark()
             drainMarkStack(m_d->engine, markBase);
     }
 
-    drainMarkStack(m_d->engine, markBase);
+    if (m_d->parallelMarker) {
+        m_d->parallelMarker->mark(markBase, m_d->engine->jsStackTop);
+        m_d->engine->jsStackTop = markBase;
+    } else {
+        drainMarkStack(m_d->engine, markBase);
+    }
+    m_d->markTime = markTimer.nsecsElapsed();
+}
+
+void MemoryManager::markInParallel(Heap::Base *m)
+{
+    // Of the threads finding the object unmarked, only the one setting the mark bit scans it.
+    QBasicAtomicInteger<quintptr> *mmData = reinterpret_cast<QBasicAtomicInteger<quintptr> *>(&m->mm_data);
+    if (mmData->fetchAndOrRelaxed(Heap::Base::MarkBit) & Heap::Base::MarkBit)
+        return;
+    m_d->parallelMarker->push(m);
 }
 
-void MemoryManager::sweep(bool lastSweep)
+void MemoryManager::sweep(bool lastSweep, bool minorCollection, bool lazySweep)
 {
     if (m_weakValues) {
         for (PersistentValueStorage::Iterator it = m_weakValues->begin(); it != m_weakValues->end(); ++it) {
@@ -397,34 +1511,50 @@ void MemoryManager::sweep(bool lastSweep)
         }
     }
 
+    memset(m_d->nonFullChunks, 0, sizeof(m_d->nonFullChunks));
+    memset(m_d->unsweptChunks, 0, sizeof(m_d->unsweptChunks));
+
+    if (lazySweep) {
+        for (int i = 0; i < m_d->heapChunks.size(); ++i) {
+            Data::ChunkHeader *header = reinterpret_cast<Data::ChunkHeader *>(m_d->heapChunks[i].base());
+            const size_t pos = header->itemSize >> 4;
+            if (minorCollection && !header->hasNurseryItems) {
+                if (header->freeItems.nextFree()) {
+                    header->nextNonFull = m_d->nonFullChunks[pos];
+                    m_d->nonFullChunks[pos] = header;
+                }
+                continue;
+            }
+            header->nextUnswept = m_d->unsweptChunks[pos];
+            m_d->unsweptChunks[pos] = header;
+        }
+    }
+
     bool *chunkIsEmpty = (bool *)alloca(m_d->heapChunks.size() * sizeof(bool));
     uint itemsInUse[MemoryManager::Data::MaxItemSize/16];
     memset(itemsInUse, 0, sizeof(itemsInUse));
-    memset(m_d->nonFullChunks, 0, sizeof(m_d->nonFullChunks));
 
-    for (int i = 0; i < m_d->heapChunks.size(); ++i) {
+    for (int i = 0; i < m_d->heapChunks.size() && !lazySweep; ++i) {
         Data::ChunkHeader *header = reinterpret_cast<Data::ChunkHeader *>(m_d->heapChunks[i].base());
-        chunkIsEmpty[i] = sweepChunk(header, &itemsInUse[header->itemSize >> 4], m_d->engine);
+        if (minorCollection && !header->hasNurseryItems) {
+            // only old objects in here, nothing to collect
+            chunkIsEmpty[i] = false;
+            continue;
+        }
+        chunkIsEmpty[i] = sweepChunk(m_d.data(), header, &itemsInUse[header->itemSize >> 4]);
     }
 
     QVector<PageAllocation>::iterator chunkIter = m_d->heapChunks.begin();
-    for (int i = 0; i < m_d->heapChunks.size(); ++i) {
+    for (int i = 0; i < m_d->heapChunks.size() && !lazySweep; ++i) {
         Q_ASSERT(chunkIter != m_d->heapChunks.end());
         Data::ChunkHeader *header = reinterpret_cast<Data::ChunkHeader *>(chunkIter->base());
         const size_t pos = header->itemSize >> 4;
         const size_t decrease = (header->itemEnd - header->itemStart) / header->itemSize;
 
         // Release that chunk if it could have been spared since the last GC run without any difference.
-        if (chunkIsEmpty[i] && m_d->availableItems[pos] - decrease >= itemsInUse[pos]) {
-            Q_V4_PROFILE_DEALLOC(m_d->engine, 0, chunkIter->size(), Profiling::HeapPage);
-#ifdef V4_USE_VALGRIND
-            VALGRIND_MEMPOOL_FREE(this, header);
-#endif
-            --m_d->nChunks[pos];
-            m_d->availableItems[pos] -= uint(decrease);
-            m_d->totalItems -= int(decrease);
-            chunkIter->deallocate();
-            chunkIter = m_d->heapChunks.erase(chunkIter);
+        // itemsInUse only covers the swept chunks in a minor collection, so leave that to full ones.
+        if (!minorCollection && chunkIsEmpty[i] && m_d->availableItems[pos] - decrease >= itemsInUse[pos]) {
+            chunkIter = releaseChunk(m_d.data(), chunkIter);
             continue;
         } else if (header->freeItems.nextFree()) {
             header->nextNonFull = m_d->nonFullChunks[pos];
@@ -439,7 +1569,8 @@ void MemoryManager::sweep(bool lastSweep)
         Heap::Base *m = i->heapObject();
         Q_ASSERT(m->inUse());
         if (m->isMarked()) {
-            m->clearMarkBit();
+            if (!m_d->generational)
+                m->clearMarkBit();
             last = &i->next;
             i = i->next;
             continue;
@@ -448,8 +1579,8 @@ void MemoryManager::sweep(bool lastSweep)
             m->gcGetVtable()->destroy(m);
 
         *last = i->next;
-        free(Q_V4_PROFILE_DEALLOC(m_d->engine, i, i->size + sizeof(Data::LargeItem),
-                                  Profiling::LargeItem));
+        (void)Q_V4_PROFILE_DEALLOC(m_d->engine, i, i->size + sizeof(Data::LargeItem), Profiling::LargeItem);
+        freeLargeItem(m_d.data(), i);
         i = *last;
     }
 
@@ -463,7 +1594,8 @@ void MemoryManager::sweep(bool lastSweep)
     }
 
     // some execution contexts are allocated on the stack, make sure we clear their markBit as well
-    if (!lastSweep) {
+    // (with sticky mark bits ExecutionEngine::markObjects() revisits the current contexts instead)
+    if (!lastSweep && !m_d->generational) {
         Heap::ExecutionContext *ctx = engine()->current;
         while (ctx) {
             ctx->clearMarkBit();
@@ -482,31 +1614,89 @@ void MemoryManager::setGCBlocked(bool blockGC)
     m_d->gcBlocked = blockGC;
 }
 
-void MemoryManager::runGC()
+void MemoryManager::runGC(bool forceFullCollection)
 {
     if (m_d->gcBlocked) {
 //        qDebug() << "Not running GC.";
         return;
     }
 
+    QElapsedTimer pauseTimer;
+    pauseTimer.start();
+
+    // all items need to be either in use or free, and mark bits up to date before marking again
+    endBumpAllocation();
+    finishSweeping();
+
+    bool minorCollection = m_d->generational && !forceFullCollection && !m_d->markingInProgress
+            && m_d->minorCollections < m_d->maxMinorCollections;
+    const bool lazySweep = m_d->lazySweep && !forceFullCollection;
+    bool clearMarks = m_d->generational && !minorCollection;
+
+    QTime t;
+    if (m_d->gcStats)
+        t.start();
+
+    if (m_d->markingInProgress) {
+        // Keep what incremental marking found, unless the written to objects are unknown.
+        clearMarks = !finishIncrementalMarking();
+    } else if (minorCollection && !collectFromDirtyPages()) {
+        // fall back to a full collection if the dirty pages are unknown
+        minorCollection = false;
+        clearMarks = true;
+    } else if (minorCollection) {
+        collectFromQObjectWrappers();
+    }
+
+    if (minorCollection)
+        ++m_d->minorCollections;
+    else if (m_d->generational)
+        m_d->minorCollections = 0;
+    if (clearMarks)
+        clearMarkBits();
+
+    m_d->sweptLiveBytes = 0;
+    m_d->sweptFreedBytes = 0;
+    m_d->measuringSurvival = m_d->adaptiveTrigger && !minorCollection;
+
+    // Explicit collections are a good opportunity to give memory back, otherwise only
+    // do so once the heap got too fragmented (QV4_MM_COMPACT_THRESHOLD).
+    const bool mayCompact = !minorCollection && !lazySweep;
+
     if (!m_d->gcStats) {
         mark();
-        sweep();
+        sweep(/*lastSweep*/false, minorCollection, lazySweep);
+        if (m_d->measuringSurvival && !lazySweep)
+            updateAllocationBudget();
+        if (mayCompact && (forceFullCollection || isFragmented()))
+            compact();
     } else {
         const size_t totalMem = getAllocatedMem();
 
-        QTime t;
-        t.start();
         mark();
         int markTime = t.elapsed();
         t.restart();
         const size_t usedBefore = getUsedMem();
         int chunksBefore = m_d->heapChunks.size();
-        sweep();
+        sweep(/*lastSweep*/false, minorCollection, lazySweep);
+        if (m_d->measuringSurvival && !lazySweep)
+            updateAllocationBudget();
         const size_t usedAfter = getUsedMem();
         int sweepTime = t.elapsed();
+        const bool compacted = mayCompact && (forceFullCollection || isFragmented());
+        int chunksBeforeCompaction = m_d->heapChunks.size();
+        t.restart();
+        if (compacted)
+            compact();
+        int compactTime = t.elapsed();
 
         qDebug() << "========== GC ==========";
+        if (m_d->generational)
+            qDebug() << (minorCollection ? "Minor collection." : "Full collection.");
+        if (lazySweep)
+            qDebug() << "Chunks are swept lazily, freed up bytes are not known yet.";
+        if (m_d->adaptiveTrigger)
+            qDebug() << "Allocation budget until the next collection:" << m_d->allocationBudget << "bytes.";
         qDebug() << "Marked object in" << markTime << "ms.";
         qDebug() << "Sweeped object in" << sweepTime << "ms.";
         qDebug() << "Allocated" << totalMem << "bytes in" << m_d->heapChunks.size() << "chunks.";
@@ -514,9 +1704,48 @@ void MemoryManager::runGC()
         qDebug() << "Used memory after GC:" << usedAfter;
         qDebug() << "Freed up bytes:" << (usedBefore - usedAfter);
         qDebug() << "Released chunks:" << (chunksBefore - m_d->heapChunks.size());
+        if (compacted) {
+            qDebug() << "Compacted heap in" << compactTime << "ms.";
+            qDebug() << "Chunks released by compaction:" << (chunksBeforeCompaction - m_d->heapChunks.size());
+        }
         qDebug() << "======== End GC ========";
     }
 
+    // The reset when incremental marking started is not part of this pause, so it isn't counted.
+    qint64 resetTime = 0;
+    if (m_d->generational && m_d->maxMinorCollections)
+        resetTime = resetDirtyPages();
+
+    const CollectionStatistics collection = { pauseTimer.nsecsElapsed(), m_d->markTime, m_d->allocatedBytes,
+                                              minorCollection, resetTime };
+    if (m_d->generational && m_d->maxMinorCollections) {
+        if (!minorCollection) {
+            if (!forceFullCollection)
+                m_d->fullCollectionPause = collection.pause - collection.dirtyPagesResetTime;
+        } else if (m_d->fullCollectionPause < 0 || collection.pause < m_d->fullCollectionPause) {
+            m_d->slowMinorCollections = 0;
+        } else if (++m_d->slowMinorCollections == Data::MaxSlowMinorCollections) {
+            // The resets cost more than the minor collections save.
+            m_d->maxMinorCollections = 0;
+            if (m_d->gcStats)
+                qDebug() << "Minor collections are as slow as full ones, only running full collections from now on.";
+        }
+    }
+    ++m_d->collections;
+    m_d->totalPause += collection.pause;
+    m_d->maxPause = qMax(m_d->maxPause, collection.pause);
+    if (m_d->recentCollections.size() == Data::MaxRecentCollections)
+        m_d->recentCollections.remove(0);
+    m_d->recentCollections.append(collection);
+    m_d->allocatedBytes = 0;
+
+    ExecutionEngine *engine = m_d->engine;
+    if (engine->profiler && (engine->profiler->featuresEnabled & (1 << Profiling::FeatureMemoryAllocation))) {
+        // with lazy sweeping the used memory includes the garbage that wasn't swept yet
+        engine->profiler->trackGarbageCollection(collection.pause, collection.allocatedBytes,
+                                                 getAllocatedMem(), getUsedMem(), getLargeItemsMem());
+    }
+
     memset(m_d->allocCount, 0, sizeof(m_d->allocCount));
     m_d->totalAlloc = 0;
     m_d->totalLargeItemsAllocated = 0;
@@ -530,13 +1759,55 @@ size_t MemoryManager::getUsedMem() const
         for (char *item = header->itemStart; item <= header->itemEnd; item += header->itemSize) {
             Heap::Base *m = reinterpret_cast<Heap::Base *>(item);
             Q_ASSERT((qintptr) item % 16 == 0);
-            if (m->inUse())
+            // items not handed out by the bump allocator yet are still zeroed
+            if (m->inUse() && m->gcGetVtable())
                 usedMem += header->itemSize;
         }
     }
     return usedMem;
 }
 
+MemoryManager::HeapStatistics MemoryManager::statistics() const
+{
+    HeapStatistics stats;
+    stats.sizeClasses.resize(Data::MaxItemSize/16 - 1);
+    for (int i = 0; i < stats.sizeClasses.size(); ++i) {
+        SizeClassStatistics &sizeClass = stats.sizeClasses[i];
+        sizeClass.itemSize = uint(i + 1) << 4;
+        sizeClass.chunks = 0;
+        sizeClass.items = 0;
+        sizeClass.usedItems = 0;
+    }
+
+    stats.allocatedMem = 0;
+    stats.usedMem = 0;
+    for (QVector<PageAllocation>::const_iterator i = m_d->heapChunks.cbegin(), ei = m_d->heapChunks.cend(); i != ei; ++i) {
+        Data::ChunkHeader *header = reinterpret_cast<Data::ChunkHeader *>(i->base());
+        SizeClassStatistics &sizeClass = stats.sizeClasses[(header->itemSize >> 4) - 1];
+        ++sizeClass.chunks;
+        stats.allocatedMem += i->size();
+        for (char *item = header->itemStart; item <= header->itemEnd; item += header->itemSize) {
+            Heap::Base *m = reinterpret_cast<Heap::Base *>(item);
+            ++sizeClass.items;
+            if (m->inUse() && m->gcGetVtable()) {
+                ++sizeClass.usedItems;
+                stats.usedMem += header->itemSize;
+            }
+        }
+    }
+
+    stats.largeItemsMem = m_d->largeItemsMem;
+    stats.largeItemsMappedMem = m_d->largeItemsMappedMem;
+    stats.largeItems = m_d->largeItemCount;
+
+    stats.collections = m_d->collections;
+    stats.maxPause = m_d->maxPause;
+    stats.totalPause = m_d->totalPause;
+    stats.allocatedBytes = m_d->allocatedBytes;
+    stats.recentCollections = m_d->recentCollections;
+    return stats;
+}
+
 size_t MemoryManager::getAllocatedMem() const
 {
     size_t total = 0;
@@ -547,10 +1818,7 @@ size_t MemoryManager::getAllocatedMem() const
 
 size_t MemoryManager::getLargeItemsMem() const
 {
-    size_t total = 0;
-    for (const Data::LargeItem *i = m_d->largeItems; i != 0; i = i->next)
-        total += i->size;
-    return total;
+    return m_d->largeItemsMem;
 }
 
 MemoryManager::~MemoryManager()
@@ -559,6 +1827,9 @@ MemoryManager::~MemoryManager()
     delete m_weakValues;
     m_weakValues = 0;
 
+    endBumpAllocation();
+    if (m_d->generational || m_d->markingInProgress)
+        clearMarkBits();
     sweep(/*lastSweep*/true);
 #ifdef V4_USE_VALGRIND
     VALGRIND_DESTROY_MEMPOOL(this);
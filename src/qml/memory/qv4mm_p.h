@@ -38,6 +38,8 @@
 #include <private/qv4value_p.h>
 #include <private/qv4scopedvalue_p.h>
 
+#include <QtCore/qvector.h>
+
 //#define DETAILED_MM_STATS
 
 QT_BEGIN_NAMESPACE
@@ -147,10 +149,23 @@ public:
 
     bool isGCBlocked() const;
     void setGCBlocked(bool blockGC);
-    void runGC();
+    // Runs a minor collection if generational collection is enabled (QV4_MM_GENERATIONAL)
+    // and a full collection isn't due yet. Unless forced to do a full collection, sweeping
+    // is left to the allocator if lazy sweeping is enabled (QV4_MM_LAZY_SWEEP). Forced
+    // collections also compact the heap, releasing as much memory to the OS as possible.
+    void runGC(bool forceFullCollection = false);
+
+    // Spends at most budgetUsecs on incremental marking if it is enabled (QV4_MM_INCREMENTAL),
+    // starting a new marking phase when an allocation triggered collection comes close, and
+    // finishing the collection once everything is marked. Meant to be called in idle time.
+    // Returns whether a marking phase is still in progress.
+    bool incrementalGCStep(int budgetUsecs);
 
     ExecutionEngine *engine() const;
 
+    // Called by Heap::Base::mark() while marking in parallel (QV4_MM_MARK_THREADS).
+    void markInParallel(Heap::Base *m);
+
     void dumpStats() const;
 
     void registerDeletable(GCDeletable *d);
@@ -159,6 +174,38 @@ public:
     size_t getAllocatedMem() const;
     size_t getLargeItemsMem() const;
 
+    struct SizeClassStatistics {
+        uint itemSize;
+        uint chunks;
+        uint items;
+        uint usedItems;
+    };
+
+    struct CollectionStatistics {
+        qint64 pause; // in nanoseconds
+        qint64 markTime; // in nanoseconds, the final marking only
+        quint64 allocatedBytes; // since the collection before
+        bool minorCollection;
+        qint64 dirtyPagesResetTime; // in nanoseconds, the part of the pause spent resetting the dirty pages
+    };
+
+    struct HeapStatistics {
+        QVector<SizeClassStatistics> sizeClasses;
+        size_t allocatedMem;
+        size_t usedMem;
+        size_t largeItemsMem;
+        size_t largeItemsMappedMem; // including the mappings kept for reuse
+        uint largeItems;
+        uint collections;
+        qint64 maxPause;
+        qint64 totalPause;
+        quint64 allocatedBytes; // since the last collection
+        QVector<CollectionStatistics> recentCollections; // oldest first
+    };
+
+    // Walks the whole heap, so this is meant for introspection rather than for regular use.
+    HeapStatistics statistics() const;
+
 protected:
     /// expects size to be aligned
     // TODO: try to inline
@@ -170,8 +217,22 @@ protected:
 
 private:
     void collectFromJSStack() const;
+    bool collectFromDirtyPages();
+    void collectFromQObjectWrappers();
+    qint64 resetDirtyPages();
+    void clearMarkBits();
+    void startIncrementalMarking();
+    void saveGreyItems(Value *markBase);
+    bool finishIncrementalMarking();
+    void endBumpAllocation(std::size_t pos);
+    void endBumpAllocation();
+    void sweepLazily(std::size_t pos);
+    void finishSweeping();
+    void compact();
+    bool isFragmented() const;
+    void updateAllocationBudget();
     void mark();
-    void sweep(bool lastSweep = false);
+    void sweep(bool lastSweep = false, bool minorCollection = false, bool lazySweep = false);
 
 protected:
     QScopedPointer<Data> m_d;
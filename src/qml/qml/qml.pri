@@ -18,6 +18,9 @@ SOURCES += \
     $$PWD/qqmlstringconverters.cpp \
     $$PWD/qqmlparserstatus.cpp \
     $$PWD/qqmltypeloader.cpp \
+    $$PWD/qqmldiskcache.cpp \
+    $$PWD/qqmlparallelcompiler.cpp \
+    $$PWD/qqmlstartupmanifest.cpp \
     $$PWD/qqmlinfo.cpp \
     $$PWD/qqmlerror.cpp \
     $$PWD/qqmlvaluetype.cpp \
@@ -84,6 +87,9 @@ HEADERS += \
     $$PWD/qqmlproperty_p.h \
     $$PWD/qqmlcontext_p.h \
     $$PWD/qqmltypeloader_p.h \
+    $$PWD/qqmldiskcache_p.h \
+    $$PWD/qqmlparallelcompiler_p.h \
+    $$PWD/qqmlstartupmanifest_p.h \
     $$PWD/qqmllist.h \
     $$PWD/qqmllist_p.h \
     $$PWD/qqmldata_p.h \
@@ -126,5 +132,7 @@ HEADERS += \
     $$PWD/qqmlobjectcreator_p.h \
     $$PWD/qqmldirparser_p.h
 
+unix: LIBS_PRIVATE += $$QMAKE_LIBS_DYNLOAD
+
 include(ftw/ftw.pri)
 include(v8/v8.pri)
@@ -0,0 +1,253 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qqmldiskcache_p.h"
+
+#include <private/qv4engine_p.h>
+#include <private/qv4isel_p.h>
+
+#include <QtCore/qcryptographichash.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qstandardpaths.h>
+#include <QtQml/qqmlfile.h>
+
+#if defined(Q_OS_WIN) && !defined(Q_OS_WINRT)
+#  include <qt_windows.h>
+#elif defined(Q_OS_UNIX)
+#  include <dlfcn.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+static const char cacheMagic[] = "qmlcache";
+
+struct CacheFileHeader
+{
+    char magic[8];
+    quint32 qtVersion;
+    char imageKey[20]; // of the QtQml binary that wrote the file
+    qint64 sourceTimeStamp;
+    char sourceHash[20]; // SHA-1
+    quint32 unitSize;
+    quint32 codeSize;
+    // Followed by the unit data and the code.
+};
+
+qint64 sourceTimeStamp(const QUrl &url)
+{
+    const QString fileName = QQmlFile::urlToLocalFileOrQrc(url);
+    if (fileName.isEmpty())
+        return 0;
+    const QDateTime lastModified = QFileInfo(fileName).lastModified();
+    return lastModified.isValid() ? lastModified.toMSecsSinceEpoch() : 0;
+}
+
+void imageAnchor()
+{
+}
+
+bool initializeHeader(CacheFileHeader *header, const QUrl &url, const QByteArray &source)
+{
+    static const QByteArray key = QQmlDiskCache::imageKey();
+    if (key.size() != sizeof(header->imageKey))
+        return false;
+
+    memset(header, 0, sizeof(CacheFileHeader));
+    memcpy(header->magic, cacheMagic, sizeof(header->magic));
+    header->qtVersion = QT_VERSION;
+    memcpy(header->imageKey, key.constData(), sizeof(header->imageKey));
+    header->sourceTimeStamp = sourceTimeStamp(url);
+    const QByteArray hash = QCryptographicHash::hash(source, QCryptographicHash::Sha1);
+    Q_ASSERT(hash.size() == sizeof(header->sourceHash));
+    memcpy(header->sourceHash, hash.constData(), sizeof(header->sourceHash));
+    return true;
+}
+
+} // anonymous namespace
+
+// The engine's data structures, bytecode and machine code can change between builds of the same
+// Qt version, so the binary is identified by its path, size and modification time. Returns an
+// empty key if it cannot be found.
+QByteArray QQmlDiskCache::imageKey()
+{
+    QString fileName;
+#if defined(Q_OS_WIN) && !defined(Q_OS_WINRT)
+    HMODULE module = 0;
+    if (GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           reinterpret_cast<LPCWSTR>(&imageAnchor), &module)) {
+        wchar_t buffer[MAX_PATH];
+        const DWORD size = GetModuleFileNameW(module, buffer, MAX_PATH);
+        if (size > 0 && size < MAX_PATH)
+            fileName = QString::fromWCharArray(buffer, size);
+    }
+#elif defined(Q_OS_UNIX)
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&imageAnchor), &info) && info.dli_fname)
+        fileName = QFile::decodeName(info.dli_fname);
+#endif
+    const QFileInfo image(fileName);
+    if (fileName.isEmpty() || !image.exists())
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QFile::encodeName(image.canonicalFilePath()));
+    hash.addData(QByteArray::number(image.size()));
+    hash.addData(QByteArray::number(image.lastModified().toMSecsSinceEpoch()));
+    return hash.result();
+}
+
+QQmlDiskCache *QQmlDiskCache::create()
+{
+    if (!qgetenv("QML_DISABLE_DISK_CACHE").isEmpty())
+        return 0;
+
+    QString directory = QFile::decodeName(qgetenv("QML_DISK_CACHE_PATH"));
+    if (directory.isEmpty()) {
+        directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        if (directory.isEmpty())
+            return 0;
+        directory += QLatin1String("/qmlcache");
+    }
+    if (!QDir().mkpath(directory))
+        return 0;
+    return new QQmlDiskCache(directory, !qgetenv("QML_DISK_CACHE_QML_DOCUMENTS").isEmpty());
+}
+
+QQmlDiskCache::QQmlDiskCache(const QString &directory, bool cachesDocuments)
+    : m_directory(directory), m_cachesDocuments(cachesDocuments)
+{
+    m_writer.setMaxThreadCount(1);
+}
+
+QString QQmlDiskCache::cacheFilePath(const QUrl &url) const
+{
+    const QByteArray name = QCryptographicHash::hash(url.toString().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(name) + QLatin1String(".qmlc");
+}
+
+QQmlRefPointer<QV4::CompiledData::CompilationUnit> QQmlDiskCache::load(const QUrl &url, const QByteArray &source, QV4::ExecutionEngine *engine) const
+{
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> result;
+
+    QFile file(cacheFilePath(url));
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(CacheFileHeader)))
+        return result;
+    const uchar *contents = file.map(0, file.size());
+    if (!contents)
+        return result;
+
+    CacheFileHeader expected;
+    if (!initializeHeader(&expected, url, source))
+        return result;
+    CacheFileHeader header;
+    memcpy(&header, contents, sizeof(header));
+    if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0
+            || header.qtVersion != expected.qtVersion
+            || memcmp(header.imageKey, expected.imageKey, sizeof(header.imageKey)) != 0
+            || header.sourceTimeStamp != expected.sourceTimeStamp
+            || memcmp(header.sourceHash, expected.sourceHash, sizeof(header.sourceHash)) != 0
+            || file.size() != qint64(sizeof(header)) + header.unitSize + header.codeSize
+            || header.unitSize < sizeof(QV4::CompiledData::Unit)) {
+        return result;
+    }
+
+    const char *unitData = reinterpret_cast<const char *>(contents) + sizeof(header);
+    const QV4::CompiledData::Unit *unit = reinterpret_cast<const QV4::CompiledData::Unit *>(unitData);
+    if (memcmp(unit->magic, QV4::CompiledData::magic_str, sizeof(unit->magic)) != 0
+            || unit->version != QV4_DATA_STRUCTURE_VERSION
+            || unit->unitSize != header.unitSize
+            || (unit->flags & QV4::CompiledData::Unit::StaticData)) {
+        return result;
+    }
+
+    QV4::CompiledData::CompilationUnit *compilationUnit = engine->iselFactory->createUnitForLoading();
+    if (!compilationUnit)
+        return result;
+    result.adopt(compilationUnit);
+
+    // The unit owns its data, and the backend relocates its copy of the code, so neither can stay
+    // in the mapping.
+    compilationUnit->data = static_cast<QV4::CompiledData::Unit *>(malloc(header.unitSize));
+    memcpy(compilationUnit->data, unitData, header.unitSize);
+    const QByteArray code = QByteArray::fromRawData(unitData + header.unitSize, header.codeSize);
+    if (!compilationUnit->loadCodeFromDisk(engine, code))
+        result = QQmlRefPointer<QV4::CompiledData::CompilationUnit>();
+    return result;
+}
+
+void QQmlDiskCache::save(const QUrl &url, const QByteArray &source, const QV4::CompiledData::CompilationUnit *unit)
+{
+    QByteArray code;
+    if (!unit->data || !unit->saveCodeToDisk(&code))
+        return;
+
+    CacheFileHeader header;
+    if (!initializeHeader(&header, url, source))
+        return;
+    header.unitSize = unit->data->unitSize;
+    header.codeSize = code.size();
+
+    // Other processes may be reading the old file, so it is replaced rather than overwritten.
+    QSaveFile file(cacheFilePath(url));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(unit->data), header.unitSize);
+    file.write(code);
+    file.commit();
+}
+
+/*!
+Runs \a job, which saves a unit, on the writer thread and deletes it afterwards.
+*/
+void QQmlDiskCache::saveLater(QRunnable *job)
+{
+    m_writer.start(job);
+}
+
+/*!
+Waits until the jobs passed to saveLater() are done. They use the engine they compile for, so
+this has to happen before it goes away.
+*/
+void QQmlDiskCache::waitForPendingSaves()
+{
+    m_writer.waitForDone();
+}
+
+QT_END_NAMESPACE
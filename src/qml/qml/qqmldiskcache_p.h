@@ -0,0 +1,101 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QQMLDISKCACHE_P_H
+#define QQMLDISKCACHE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qstring.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qurl.h>
+
+#include <private/qqmlrefcount_p.h>
+#include <private/qv4compileddata_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// Keeps compiled scripts and QML documents across runs, so they don't get parsed and compiled on
+// every start.
+//
+// There is one cache file per source URL, in QML_DISK_CACHE_PATH or the application's cache
+// location. A cache file is only used if the source still has the modification time and the
+// contents it had when the file was written, and if it was written by the very same build of
+// QtQml (see imageKey()). It contains the unit data followed by the code of the backend, so only the backends
+// that can store their code are cached (see EvalISelFactory::createUnitForLoading): the
+// interpreter stores its bytecode in the portable form that qmlcachegen uses as well, the JIT its
+// machine code with relocations for the addresses it embeds. Setting QML_DISABLE_DISK_CACHE turns
+// the cache off.
+//
+// QML documents are only cached when QML_DISK_CACHE_QML_DOCUMENTS is set. They are stored
+// without the types they import resolved (see QQmlTypeData::saveToDiskCache()), so their bindings
+// look up every name at run-time and a warm start trades binding speed for the parsing and
+// compilation it saves. QmlIR::IRLoader restores their QmlIR::Document, and the type compiler runs
+// on it as usual, except that it keeps the code from the cache. Documents are compiled for the
+// cache on a writer thread, after the type loader got the code it runs.
+class QQmlDiskCache
+{
+public:
+    static QQmlDiskCache *create();
+
+    bool cachesDocuments() const { return m_cachesDocuments; }
+
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> load(const QUrl &url, const QByteArray &source, QV4::ExecutionEngine *engine) const;
+    void save(const QUrl &url, const QByteArray &source, const QV4::CompiledData::CompilationUnit *unit);
+    void saveLater(QRunnable *job);
+    void waitForPendingSaves();
+
+    QString cacheFilePath(const QUrl &url) const;
+
+    static QByteArray imageKey();
+
+private:
+    QQmlDiskCache(const QString &directory, bool cachesDocuments);
+
+    QString m_directory;
+    bool m_cachesDocuments;
+    QThreadPool m_writer;
+};
+
+QT_END_NAMESPACE
+
+#endif // QQMLDISKCACHE_P_H
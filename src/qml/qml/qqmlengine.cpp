@@ -62,6 +62,7 @@
 #include "qqmlincubator.h"
 #include "qqmlabstracturlinterceptor.h"
 #include <private/qqmlboundsignal_p.h>
+#include <private/qqmlstartupmanifest_p.h>
 
 #include <QtCore/qstandardpaths.h>
 #include <QtCore/qsettings.h>
@@ -871,6 +872,12 @@ void QQmlEnginePrivate::init()
         QQmlEngineControlService::instance();
         QQmlDebugServer::instance()->addEngine(q);
     }
+
+    // Documents parsed ahead of time have no debug information
+    if (!isDebugging) {
+        if (QQmlStartupManifest *manifest = typeLoader.startupManifest())
+            manifest->prefetch(&typeLoader);
+    }
 }
 
 QQuickWorkerScriptEngine *QQmlEnginePrivate::getWorkerScriptEngine()
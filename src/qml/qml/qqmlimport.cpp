@@ -46,6 +46,7 @@
 #include <private/qqmlglobal_p.h>
 #include <private/qqmltypenamecache_p.h>
 #include <private/qqmlengine_p.h>
+#include <private/qqmlstartupmanifest_p.h>
 #include <private/qfieldlist_p.h>
 #include <QtCore/qjsonobject.h>
 #include <QtCore/qjsonarray.h>
@@ -929,6 +930,8 @@ bool QQmlImportsPrivate::importExtension(const QString &qmldirFilePath,
             QString resolvedFilePath = database->resolvePlugin(typeLoader, qmldirPath, plugin.path, plugin.name);
             if (!resolvedFilePath.isEmpty()) {
                 dynamicPluginsFound++;
+                if (QQmlStartupManifest *manifest = typeLoader->startupManifest())
+                    manifest->record(QQmlStartupManifest::PluginFile, resolvedFilePath);
                 if (!database->importDynamicPlugin(resolvedFilePath, uri, typeNamespace, vmaj, errors)) {
                     if (errors) {
                         // XXX TODO: should we leave the import plugin error alone?
@@ -0,0 +1,232 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qqmlparallelcompiler_p.h"
+
+#include <QtCore/qfile.h>
+#include <QtCore/qthread.h>
+#include <QtQml/qqmlfile.h>
+
+QT_BEGIN_NAMESPACE
+
+class QQmlParallelCompiler::Job : public QRunnable
+{
+public:
+    enum State {
+        Queued,
+        Running,
+        Done,
+        Cancelled // Taken before it started; run() deletes it
+    };
+
+    Job(QQmlParallelCompiler *compiler, const QUrl &url, QQmlDataBlob::Type type)
+        : compiler(compiler), url(url), type(type), state(Queued), isRead(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() Q_DECL_OVERRIDE;
+
+    QQmlParallelCompiler *compiler;
+    QUrl url;
+    QQmlDataBlob::Type type;
+    State state;
+
+    bool isRead;
+    QByteArray source;
+    QScopedPointer<QmlIR::Document> document;
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit;
+    QList<QQmlError> errors;
+};
+
+void QQmlParallelCompiler::Job::run()
+{
+    {
+        QMutexLocker locker(&compiler->m_mutex);
+        if (state == Cancelled) {
+            locker.unlock();
+            delete this;
+            return;
+        }
+        state = Running;
+    }
+
+    // Errors reading the file are left to the loader, which reads it again anyway.
+    QFile file(QQmlFile::urlToLocalFileOrQrc(url));
+    if (file.open(QFile::ReadOnly)) {
+        source = file.readAll();
+        isRead = true;
+        if (type == QQmlDataBlob::QmlFile)
+            document.reset(QQmlTypeData::parse(compiler->m_loader, url, source, &errors));
+        else
+            unit = QQmlScriptBlob::compile(compiler->m_loader, url, source, &errors);
+    }
+
+    QMutexLocker locker(&compiler->m_mutex);
+    state = Done;
+    compiler->m_jobDone.wakeAll();
+}
+
+namespace {
+
+class FileReader : public QRunnable
+{
+public:
+    FileReader(const QString &filePath) : filePath(filePath) {}
+
+    void run() Q_DECL_OVERRIDE
+    {
+        QFile file(filePath);
+        if (!file.open(QFile::ReadOnly))
+            return;
+        char buffer[64 * 1024];
+        while (file.read(buffer, sizeof(buffer)) > 0) {}
+    }
+
+    QString filePath;
+};
+
+}
+
+QQmlParallelCompiler::QQmlParallelCompiler(QQmlTypeLoader *loader, int threadCount)
+    : m_loader(loader)
+{
+    m_pool.setMaxThreadCount(threadCount);
+}
+
+QQmlParallelCompiler *QQmlParallelCompiler::create(QQmlTypeLoader *loader)
+{
+    if (!qgetenv("QML_DISABLE_PARALLEL_COMPILE").isEmpty())
+        return 0;
+
+    // The loader thread compiles too, so the pool gets the remaining cores.
+    const int threadCount = QThread::idealThreadCount() - 1;
+    if (threadCount < 1)
+        return 0;
+    return new QQmlParallelCompiler(loader, threadCount);
+}
+
+QQmlParallelCompiler::~QQmlParallelCompiler()
+{
+    clear();
+}
+
+void QQmlParallelCompiler::prefetch(const QUrl &url, QQmlDataBlob::Type type)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_jobs.contains(url))
+        return;
+
+    Job *job = new Job(this, url, type);
+    m_jobs.insert(url, job);
+    m_pool.start(job);
+}
+
+/*!
+Reads the file at \a filePath and drops its contents, so that the loader finds it in the file
+system cache.
+*/
+void QQmlParallelCompiler::readAhead(const QString &filePath)
+{
+    m_pool.start(new FileReader(filePath));
+}
+
+QQmlParallelCompiler::Job *QQmlParallelCompiler::take(const QUrl &url, const QByteArray &source, QQmlDataBlob::Type type)
+{
+    QMutexLocker locker(&m_mutex);
+    Job *job = m_jobs.take(url);
+    if (!job)
+        return 0;
+
+    if (job->state == Job::Queued) {
+        // All pool threads are busy, so the loader is better off compiling it itself.
+        job->state = Job::Cancelled;
+        return 0;
+    }
+
+    while (job->state != Job::Done)
+        m_jobDone.wait(&m_mutex);
+    locker.unlock();
+
+    // The file may have changed since the job read it.
+    if (job->type != type || !job->isRead || job->source != source) {
+        delete job;
+        return 0;
+    }
+    return job;
+}
+
+bool QQmlParallelCompiler::takeDocument(const QUrl &url, const QByteArray &source, QScopedPointer<QmlIR::Document> *document, QList<QQmlError> *errors)
+{
+    QScopedPointer<Job> job(take(url, source, QQmlDataBlob::QmlFile));
+    if (!job)
+        return false;
+
+    document->reset(job->document.take());
+    *errors = job->errors;
+    return true;
+}
+
+bool QQmlParallelCompiler::takeScript(const QUrl &url, const QByteArray &source, QQmlRefPointer<QV4::CompiledData::CompilationUnit> *unit, QList<QQmlError> *errors)
+{
+    QScopedPointer<Job> job(take(url, source, QQmlDataBlob::JavaScriptFile));
+    if (!job)
+        return false;
+
+    *unit = job->unit;
+    *errors = job->errors;
+    return true;
+}
+
+/*!
+Drops the results nobody has taken, waiting for the jobs that are still running.
+*/
+void QQmlParallelCompiler::clear()
+{
+    QList<Job *> jobs;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (QHash<QUrl, Job *>::ConstIterator it = m_jobs.constBegin(), end = m_jobs.constEnd(); it != end; ++it) {
+            if ((*it)->state == Job::Queued)
+                (*it)->state = Job::Cancelled;
+            else
+                jobs.append(*it);
+        }
+        m_jobs.clear();
+    }
+
+    m_pool.waitForDone();
+    qDeleteAll(jobs);
+}
+
+QT_END_NAMESPACE
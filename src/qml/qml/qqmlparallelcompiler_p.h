@@ -0,0 +1,102 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QQMLDISKCACHE_P_H
+#ifndef QQMLPARALLELCOMPILER_P_H
+#define QQMLPARALLELCOMPILER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qurl.h>
+#include <QtCore/qwaitcondition.h>
+
+#include <private/qqmltypeloader_p.h>
+
+QT_BEGIN_NAMESPACE
+
+// Parses QML documents and compiles scripts on a thread pool ahead of the type loader.
+//
+// The type loader thread still drives every blob through its states in the usual order, so
+// dependency waits and synchronous loads are unchanged. When a document has resolved its
+// imports, the local files it depends on are handed to prefetch(); the pool reads them and runs
+// the part of dataReceived() that doesn't touch the engine: QmlIR::IRBuilder for documents, and
+// the parse, code generation and instruction selection for scripts. When the loader gets to the
+// blob, take() hands over the result, waiting for it if the job is still running, or returns
+// false if the job never started, in which case the loader compiles the blob itself.
+//
+// The QQmlTypeCompiler pass of QML documents always runs on the loader thread, since it resolves
+// types and property caches in the engine. Setting QML_DISABLE_PARALLEL_COMPILE turns this off.
+class QQmlParallelCompiler
+{
+public:
+    static QQmlParallelCompiler *create(QQmlTypeLoader *loader);
+    ~QQmlParallelCompiler();
+
+    void prefetch(const QUrl &url, QQmlDataBlob::Type type);
+    void readAhead(const QString &filePath);
+
+    bool takeDocument(const QUrl &url, const QByteArray &source, QScopedPointer<QmlIR::Document> *document, QList<QQmlError> *errors);
+    bool takeScript(const QUrl &url, const QByteArray &source, QQmlRefPointer<QV4::CompiledData::CompilationUnit> *unit, QList<QQmlError> *errors);
+
+    void clear();
+
+private:
+    class Job;
+    friend class Job;
+
+    QQmlParallelCompiler(QQmlTypeLoader *loader, int threadCount);
+
+    Job *take(const QUrl &url, const QByteArray &source, QQmlDataBlob::Type type);
+
+    QQmlTypeLoader *m_loader;
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QWaitCondition m_jobDone;
+    QHash<QUrl, Job *> m_jobs;
+};
+
+QT_END_NAMESPACE
+
+#endif // QQMLPARALLELCOMPILER_P_H
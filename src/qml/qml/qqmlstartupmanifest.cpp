@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qqmlstartupmanifest_p.h"
+
+#include <private/qqmltypeloader_p.h>
+#include <private/qqmlparallelcompiler_p.h>
+
+#include <QtCore/qfile.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qurl.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// One "<type> <location>" line per file
+static const char * const fileTypeNames[] = { "qml", "js", "qmldir", "plugin" };
+static const int fileTypeCount = sizeof(fileTypeNames) / sizeof(fileTypeNames[0]);
+
+}
+
+QQmlStartupManifest::QQmlStartupManifest(const QString &filePath)
+    : m_filePath(filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return;
+
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        const int space = line.indexOf(' ');
+        if (space <= 0)
+            continue;
+        const QByteArray typeName = line.left(space);
+        for (int type = 0; type < fileTypeCount; ++type) {
+            if (typeName == fileTypeNames[type]) {
+                m_previousRun.append(Entry(FileType(type), QString::fromUtf8(line.mid(space + 1))));
+                break;
+            }
+        }
+    }
+}
+
+QQmlStartupManifest *QQmlStartupManifest::create()
+{
+    const QString filePath = QFile::decodeName(qgetenv("QML_STARTUP_MANIFEST"));
+    if (filePath.isEmpty())
+        return 0;
+    return new QQmlStartupManifest(filePath);
+}
+
+/*!
+Starts reading the files of the previous run on the parallel compiler of \a loader.
+*/
+void QQmlStartupManifest::prefetch(QQmlTypeLoader *loader) const
+{
+    QQmlParallelCompiler *parallelCompiler = loader->parallelCompiler();
+    if (!parallelCompiler)
+        return;
+
+    foreach (const Entry &entry, m_previousRun) {
+        switch (entry.type) {
+        case QmlFile:
+            loader->prefetch(QUrl(entry.location), QQmlDataBlob::QmlFile);
+            break;
+        case JavaScriptFile:
+            loader->prefetch(QUrl(entry.location), QQmlDataBlob::JavaScriptFile);
+            break;
+        case QmldirFile:
+        case PluginFile:
+            parallelCompiler->readAhead(entry.location);
+            break;
+        }
+    }
+}
+
+/*!
+Adds the file at \a location to the manifest of this run. Documents and scripts are recorded by
+URL, qmldir files and plugins by path.
+*/
+void QQmlStartupManifest::record(FileType type, const QString &location)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_recordedLocations.contains(location))
+        return;
+    m_recordedLocations.insert(location);
+    m_recorded.append(Entry(type, location));
+}
+
+/*!
+Writes the files recorded in this run, unless they are the ones the manifest already lists.
+*/
+bool QQmlStartupManifest::save() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_recorded.isEmpty() || m_recorded == m_previousRun)
+        return true;
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    foreach (const Entry &entry, m_recorded) {
+        file.write(fileTypeNames[entry.type]);
+        file.write(" ");
+        file.write(entry.location.toUtf8());
+        file.write("\n");
+    }
+    return file.commit();
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,107 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtQml module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QQMLDISKCACHE_P_H
+#ifndef QQMLSTARTUPMANIFEST_P_H
+#define QQMLSTARTUPMANIFEST_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qmutex.h>
+#include <QtCore/qset.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qvector.h>
+
+QT_BEGIN_NAMESPACE
+
+class QQmlTypeLoader;
+
+// Records the local files the type loader reads during a run, so that the next run can read
+// them before it gets to the imports that need them.
+//
+// Imports are only discovered when the document that contains them is parsed, which makes
+// loading a chain of dependent file reads. When QML_STARTUP_MANIFEST names a file, the
+// documents, scripts, qmldir files and plugins of the previous run are listed in it, in the
+// order they were loaded. At engine start, the documents and scripts are handed to the parallel
+// compiler, and the qmldir files and plugins are read ahead to bring them into the file system
+// cache. The manifest is rewritten when the engine is destroyed if the set of files changed.
+class QQmlStartupManifest
+{
+public:
+    enum FileType {
+        QmlFile,
+        JavaScriptFile,
+        QmldirFile,
+        PluginFile
+    };
+
+    static QQmlStartupManifest *create();
+
+    void prefetch(QQmlTypeLoader *loader) const;
+    void record(FileType type, const QString &location);
+    bool save() const;
+
+private:
+    struct Entry
+    {
+        Entry() : type(QmlFile) {}
+        Entry(FileType type, const QString &location) : type(type), location(location) {}
+
+        bool operator==(const Entry &other) const { return type == other.type && location == other.location; }
+
+        FileType type;
+        QString location;
+    };
+
+    QQmlStartupManifest(const QString &filePath);
+
+    QString m_filePath;
+    QVector<Entry> m_previousRun;
+
+    mutable QMutex m_mutex;
+    QVector<Entry> m_recorded;
+    QSet<QString> m_recordedLocations;
+};
+
+QT_END_NAMESPACE
+
+#endif // QQMLSTARTUPMANIFEST_P_H
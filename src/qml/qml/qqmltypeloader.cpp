@@ -44,6 +44,10 @@
 #include <private/qqmlprofiler_p.h>
 #include <private/qqmlmemoryprofiler_p.h>
 #include <private/qqmltypecompiler_p.h>
+#include <private/qqmldiskcache_p.h>
+#include <private/qv4isel_p.h>
+#include <private/qqmlparallelcompiler_p.h>
+#include <private/qqmlstartupmanifest_p.h>
 
 #include <QtCore/qdir.h>
 #include <QtCore/qfile.h>
@@ -1062,6 +1066,12 @@ void QQmlTypeLoader::loadThread(QQmlDataBlob *blob)
             return;
         }
 
+        if (m_startupManifest && blob->type() != QQmlDataBlob::QmldirFile) {
+            const QQmlStartupManifest::FileType type = blob->type() == QQmlDataBlob::QmlFile
+                    ? QQmlStartupManifest::QmlFile : QQmlStartupManifest::JavaScriptFile;
+            m_startupManifest->record(type, blob->m_url.toString());
+        }
+
         blob->m_data.setProgress(0xFF);
         if (blob->m_data.isAsync())
             m_thread->callDownloadProgressChanged(blob, 1.);
@@ -1300,6 +1310,15 @@ bool QQmlTypeLoader::Blob::updateQmldir(QQmlQmldirData *data, const QV4::Compile
     return true;
 }
 
+/*!
+Lets the parallel compiler start on a script \a import before addImport() loads it.
+*/
+void QQmlTypeLoader::Blob::prefetchImport(const QV4::CompiledData::Import *import)
+{
+    if (import->type == QV4::CompiledData::Import::ImportScript)
+        typeLoader()->prefetch(finalUrl().resolved(QUrl(stringAt(import->uriIndex))), JavaScriptFile);
+}
+
 bool QQmlTypeLoader::Blob::addImport(const QV4::CompiledData::Import *import, QList<QQmlError> *errors)
 {
     Q_ASSERT(errors);
@@ -1567,7 +1586,8 @@ bool QQmlTypeLoader::QmldirContent::designerSupported() const
 Constructs a new type loader that uses the given \a engine.
 */
 QQmlTypeLoader::QQmlTypeLoader(QQmlEngine *engine)
-    : m_engine(engine), m_thread(new QQmlTypeLoaderThread(this))
+    : m_engine(engine), m_thread(new QQmlTypeLoaderThread(this)), m_diskCache(QQmlDiskCache::create()),
+      m_parallelCompiler(QQmlParallelCompiler::create(this)), m_startupManifest(QQmlStartupManifest::create())
 {
 }
 
@@ -1580,6 +1600,15 @@ QQmlTypeLoader::~QQmlTypeLoader()
     // Stop the loader thread before releasing resources
     shutdownThread();
 
+    if (m_startupManifest && !m_startupManifest->save())
+        qWarning("QQmlTypeLoader: cannot write the startup manifest");
+
+    // The compile jobs use the engine, and so do the jobs that write documents to the disk cache,
+    // which the compile jobs can start.
+    m_parallelCompiler.reset();
+    if (m_diskCache)
+        m_diskCache->waitForPendingSaves();
+
     clearCache();
 
     invalidate();
@@ -1676,6 +1705,28 @@ QQmlScriptBlob *QQmlTypeLoader::getScript(const QUrl &url)
     return scriptBlob;
 }
 
+/*!
+Starts compiling the local file at \a url on the parallel compiler, so that it is ready by the
+time getType() or getScript() loads it.
+*/
+void QQmlTypeLoader::prefetch(const QUrl &url, QQmlDataBlob::Type type)
+{
+    // An interceptor may redirect the blob to a different file.
+    if (!m_parallelCompiler || m_engine->urlInterceptor())
+        return;
+    if (QQmlFile::urlToLocalFileOrQrc(url).isEmpty())
+        return;
+
+    LockHolder<QQmlTypeLoader> holder(this);
+
+    if (type == QQmlDataBlob::QmlFile ? m_typeCache.contains(url) : m_scriptCache.contains(url))
+        return;
+    if (QQmlMetaType::findCachedCompilationUnit(url))
+        return;
+
+    m_parallelCompiler->prefetch(url, type);
+}
+
 /*!
 Returns a QQmlQmldirData for \a url.  The QQmlQmldirData may be cached.
 */
@@ -1862,6 +1913,8 @@ const QQmlTypeLoader::QmldirContent *QQmlTypeLoader::qmldirContent(const QString
         } else if (file.open(QFile::ReadOnly)) {
             QByteArray data = file.readAll();
             qmldir->setContent(filePath, QString::fromUtf8(data));
+            if (m_startupManifest)
+                m_startupManifest->record(QQmlStartupManifest::QmldirFile, filePath);
         } else {
             ERROR(NOT_READABLE_ERROR.arg(filePath));
         }
@@ -1912,6 +1965,9 @@ void QQmlTypeLoader::clearCache()
     m_qmldirCache.clear();
     m_importDirCache.clear();
     m_importQmlDirCache.clear();
+
+    if (m_parallelCompiler)
+        m_parallelCompiler->clear();
 }
 
 void QQmlTypeLoader::trimCache()
@@ -2122,26 +2178,123 @@ bool QQmlTypeData::loadImplicitImport()
 
 void QQmlTypeData::dataReceived(const Data &data)
 {
-    QString code = QString::fromUtf8(data.data(), data.size());
-    QQmlEngine *qmlEngine = typeLoader()->engine();
-    m_document.reset(new QmlIR::Document(QV8Engine::getV4(qmlEngine)->debugger != 0));
-    QmlIR::IRBuilder compiler(QV8Engine::get(qmlEngine)->illegalNames());
-    if (!compiler.generateFromQml(code, finalUrlString(), m_document.data())) {
-        QList<QQmlError> errors;
-        errors.reserve(compiler.errors.count());
+    const QByteArray source = data.asByteArray();
+    QList<QQmlError> errors;
+    QQmlParallelCompiler *parallelCompiler = typeLoader()->parallelCompiler();
+    if (!parallelCompiler || !parallelCompiler->takeDocument(finalUrl(), source, &m_document, &errors))
+        m_document.reset(parse(typeLoader(), finalUrl(), source, &errors));
+    if (!m_document) {
+        setError(errors);
+        return;
+    }
+
+    continueLoadFromIR();
+}
+
+class QQmlTypeData::DiskCacheJob : public QRunnable
+{
+public:
+    DiskCacheJob(QQmlTypeLoader *loader, QQmlDiskCache *diskCache, const QUrl &url, const QByteArray &data)
+        : loader(loader), diskCache(diskCache), url(url), data(data)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        QQmlTypeData::saveToDiskCache(loader, diskCache, url, data);
+    }
+
+    QQmlTypeLoader *loader;
+    QQmlDiskCache *diskCache;
+    QUrl url;
+    QByteArray data;
+};
+
+/*!
+Parses the QML \a data of the document at \a url, or loads it from the disk cache. Returns 0 and
+fills in \a errors if it doesn't parse.
+
+This only reads from the engine, so the parallel compiler can run it on its own threads.
+*/
+QmlIR::Document *QQmlTypeData::parse(QQmlTypeLoader *loader, const QUrl &url, const QByteArray &data, QList<QQmlError> *errors)
+{
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(loader->engine());
+    // Only scripts are cached by default, see QQmlDiskCache.
+    QQmlDiskCache *diskCache = loader->diskCache();
+    if (v4->debugger || (diskCache && !diskCache->cachesDocuments()))
+        diskCache = 0;
+    if (diskCache) {
+        QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit = diskCache->load(url, data, v4);
+        if (unit && (unit->data->flags & QV4::CompiledData::Unit::IsQml) && unit->data->nObjects > 0) {
+            QmlIR::Document *document = new QmlIR::Document(/*debugMode*/false);
+            QmlIR::IRLoader irLoader(unit->data, document);
+            irLoader.load();
+            // The type compiler only resolves types then, and keeps the code.
+            document->javaScriptCompilationUnit = unit;
+            return document;
+        }
+    }
+
+    QString code = QString::fromUtf8(data.constData(), data.size());
+    QScopedPointer<QmlIR::Document> document(new QmlIR::Document(v4->debugger != 0));
+    QmlIR::IRBuilder compiler(QV8Engine::get(loader->engine())->illegalNames());
+    if (!compiler.generateFromQml(code, url.toString(), document.data())) {
+        errors->reserve(compiler.errors.count());
         foreach (const QQmlJS::DiagnosticMessage &msg, compiler.errors) {
             QQmlError e;
-            e.setUrl(finalUrl());
+            e.setUrl(url);
             e.setLine(msg.loc.startLine);
             e.setColumn(msg.loc.startColumn);
             e.setDescription(msg.message);
-            errors << e;
+            *errors << e;
         }
-        setError(errors);
-        return;
+        return 0;
     }
 
-    continueLoadFromIR();
+    // The cache gets a compilation of its own, which shouldn't delay this one.
+    if (diskCache)
+        diskCache->saveLater(new DiskCacheJob(loader, diskCache, url, data));
+
+    return document.take();
+}
+
+/*!
+Compiles the document at \a url for the disk cache.
+
+The type compiler compiles bindings and functions against the types that the document imports,
+and that code would be wrong when a later run resolves different types, for example after an
+imported document changed. The disk cache only depends on the source of the document, so this
+compiles the document again without type information: all names are looked up at run-time, like
+in script strings. That makes the bindings of a document loaded from the cache slower than the
+ones the type compiler generates, which is why documents are only cached on request (see
+QQmlDiskCache::cachesDocuments()). It runs on the writer thread of the disk cache. The document is stored as it comes out of QmlIR::IRBuilder, so that the type
+compiler can run on it again after QmlIR::IRLoader restored it.
+*/
+void QQmlTypeData::saveToDiskCache(QQmlTypeLoader *loader, QQmlDiskCache *diskCache, const QUrl &url, const QByteArray &data)
+{
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(loader->engine());
+    const QString fileName = url.toString();
+
+    QmlIR::Document document(/*debugMode*/false);
+    QmlIR::IRBuilder builder(QV8Engine::get(loader->engine())->illegalNames());
+    if (!builder.generateFromQml(QString::fromUtf8(data.constData(), data.size()), fileName, &document))
+        return;
+    document.registerScriptBindingSources();
+
+    QmlIR::JSCodeGen codeGen(fileName, document.code, &document.jsModule, &document.jsParserEngine, document.program, /*imports*/0, &document.jsGenerator.stringTable);
+    if (!codeGen.generateCodeWithoutTypes(document.objects))
+        return;
+
+    QScopedPointer<QV4::EvalInstructionSelection> isel(v4->iselFactory->create(QQmlEnginePrivate::get(v4), v4->executableAllocator, &document.jsModule, &document.jsGenerator));
+    isel->setUseFastLookups(false);
+    isel->setUseTypeInference(true);
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit = isel->compile(/*generate unit data*/false);
+    document.javaScriptCompilationUnit = unit;
+
+    QmlIR::QmlUnitGenerator qmlGenerator;
+    unit->data = qmlGenerator.generate(document);
+
+    diskCache->save(url, data, unit);
 }
 
 void QQmlTypeData::initializeFromCachedUnit(const QQmlPrivate::CachedQmlUnit *unit)
@@ -2183,6 +2336,9 @@ void QQmlTypeData::continueLoadFromIR()
 
     QList<QQmlError> errors;
 
+    foreach (const QV4::CompiledData::Import *import, m_document->imports)
+        prefetchImport(import);
+
     foreach (const QV4::CompiledData::Import *import, m_document->imports) {
         if (!addImport(import, &errors)) {
             Q_ASSERT(errors.size());
@@ -2265,6 +2421,9 @@ void QQmlTypeData::compile()
 
 void QQmlTypeData::resolveTypes()
 {
+    foreach (const QQmlImports::ScriptReference &script, m_importCache.resolvedScripts())
+        typeLoader()->prefetch(script.location, JavaScriptFile);
+
     // Add any imported scripts to our resolved set
     foreach (const QQmlImports::ScriptReference &script, m_importCache.resolvedScripts())
     {
@@ -2312,6 +2471,10 @@ void QQmlTypeData::resolveTypes()
         }
     }
 
+    // Composite types are only loaded once all references are resolved, so that the
+    // parallel compiler can work on all of them while the first ones load.
+    QList<int> compositeTypeRefs;
+
     for (QV4::CompiledData::TypeReferenceMap::ConstIterator unresolvedRef = m_document->typeReferences.constBegin(), end = m_document->typeReferences.constEnd();
          unresolvedRef != end; ++unresolvedRef) {
 
@@ -2367,8 +2530,8 @@ void QQmlTypeData::resolveTypes()
         }
 
         if (ref.type && ref.type->isComposite()) {
-            ref.typeData = typeLoader()->getType(ref.type->sourceUrl());
-            addDependency(ref.typeData);
+            typeLoader()->prefetch(ref.type->sourceUrl(), QmlFile);
+            compositeTypeRefs << unresolvedRef.key();
         }
         ref.majorVersion = majorVersion;
         ref.minorVersion = minorVersion;
@@ -2380,6 +2543,12 @@ void QQmlTypeData::resolveTypes()
 
         m_resolvedTypes.insert(unresolvedRef.key(), ref);
     }
+
+    foreach (int key, compositeTypeRefs) {
+        TypeReference &ref = m_resolvedTypes[key];
+        ref.typeData = typeLoader()->getType(ref.type->sourceUrl());
+        addDependency(ref.typeData);
+    }
 }
 
 bool QQmlTypeData::resolveType(const QString &typeName, int &majorVersion, int &minorVersion, TypeReference &ref)
@@ -2594,20 +2763,47 @@ struct EmptyCompilationUnit : public QV4::CompiledData::CompilationUnit
 
 void QQmlScriptBlob::dataReceived(const Data &data)
 {
-    QString source = QString::fromUtf8(data.data(), data.size());
+    const QByteArray source = data.asByteArray();
+    QList<QQmlError> errors;
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit;
+    QQmlParallelCompiler *parallelCompiler = m_typeLoader->parallelCompiler();
+    if (!parallelCompiler || !parallelCompiler->takeScript(finalUrl(), source, &unit, &errors))
+        unit = compile(m_typeLoader, finalUrl(), source, &errors);
+    if (!errors.isEmpty()) {
+        setError(errors);
+        return;
+    }
+
+    initializeFromCompilationUnit(unit);
+}
+
+/*!
+Compiles the script \a data of \a url, or loads it from the disk cache. Returns a null pointer
+and fills in \a errors if it doesn't compile.
+
+This doesn't change the state of the engine, so the parallel compiler can run it on its own
+threads.
+*/
+QQmlRefPointer<QV4::CompiledData::CompilationUnit> QQmlScriptBlob::compile(QQmlTypeLoader *loader, const QUrl &url, const QByteArray &data, QList<QQmlError> *errors)
+{
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(loader->engine());
+    QQmlDiskCache *diskCache = v4->debugger ? 0 : loader->diskCache();
+    if (diskCache) {
+        QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit = diskCache->load(url, data, v4);
+        if (unit)
+            return unit;
+    }
+
+    QString source = QString::fromUtf8(data.constData(), data.size());
 
-    QV4::ExecutionEngine *v4 = QV8Engine::getV4(m_typeLoader->engine());
     QmlIR::Document irUnit(v4->debugger != 0);
     QmlIR::ScriptDirectivesCollector collector(&irUnit.jsParserEngine, &irUnit.jsGenerator);
 
-    QList<QQmlError> errors;
-    QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit = QV4::Script::precompile(&irUnit.jsModule, &irUnit.jsGenerator, v4, finalUrl(), source, &errors, &collector);
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit = QV4::Script::precompile(&irUnit.jsModule, &irUnit.jsGenerator, v4, url, source, errors, &collector);
     // No need to addref on unit, it's initial refcount is 1
     source.clear();
-    if (!errors.isEmpty()) {
-        setError(errors);
-        return;
-    }
+    if (!errors->isEmpty())
+        return QQmlRefPointer<QV4::CompiledData::CompilationUnit>();
     if (!unit) {
         unit.adopt(new EmptyCompilationUnit);
     }
@@ -2622,7 +2818,10 @@ void QQmlScriptBlob::dataReceived(const Data &data)
     // The js unit owns the data and will free the qml unit.
     unit->data = unitData;
 
-    initializeFromCompilationUnit(unit);
+    if (diskCache)
+        diskCache->save(url, data, unit);
+
+    return unit;
 }
 
 void QQmlScriptBlob::initializeFromCachedUnit(const QQmlPrivate::CachedQmlUnit *unit)
@@ -2701,6 +2900,9 @@ void QQmlScriptBlob::initializeFromCompilationUnit(QV4::CompiledData::Compilatio
     Q_ASSERT(m_scriptData->m_precompiledScript->data->flags & QV4::CompiledData::Unit::IsQml);
     const QV4::CompiledData::Unit *qmlUnit = m_scriptData->m_precompiledScript->data;
 
+    for (quint32 i = 0; i < qmlUnit->nImports; ++i)
+        prefetchImport(qmlUnit->importAt(i));
+
     QList<QQmlError> errors;
     for (quint32 i = 0; i < qmlUnit->nImports; ++i) {
         const QV4::CompiledData::Import *import = qmlUnit->importAt(i);
@@ -74,6 +74,9 @@ class QQmlComponentPrivate;
 class QQmlTypeData;
 class QQmlTypeLoader;
 class QQmlExtensionInterface;
+class QQmlDiskCache;
+class QQmlParallelCompiler;
+class QQmlStartupManifest;
 
 namespace QmlIR {
 struct Document;
@@ -227,6 +230,7 @@ public:
 
     protected:
         bool addImport(const QV4::CompiledData::Import *import, QList<QQmlError> *errors);
+        void prefetchImport(const QV4::CompiledData::Import *import);
         bool addPragma(const QmlIR::Pragma &pragma, QList<QQmlError> *errors);
 
         bool fetchQmldir(const QUrl &url, const QV4::CompiledData::Import *import, int priority, QList<QQmlError> *errors);
@@ -311,6 +315,11 @@ public:
     void initializeEngine(QQmlExtensionInterface *, const char *);
     void invalidate();
 
+    QQmlDiskCache *diskCache() const { return m_diskCache.data(); }
+    QQmlParallelCompiler *parallelCompiler() const { return m_parallelCompiler.data(); }
+    QQmlStartupManifest *startupManifest() const { return m_startupManifest.data(); }
+    void prefetch(const QUrl &url, QQmlDataBlob::Type type);
+
 private:
     friend class QQmlDataBlob;
     friend class QQmlTypeLoaderThread;
@@ -362,6 +371,9 @@ private:
     QmldirCache m_qmldirCache;
     ImportDirCache m_importDirCache;
     ImportQmlDirCache m_importQmlDirCache;
+    QScopedPointer<QQmlDiskCache> m_diskCache;
+    QScopedPointer<QQmlParallelCompiler> m_parallelCompiler;
+    QScopedPointer<QQmlStartupManifest> m_startupManifest;
 };
 
 class Q_AUTOTEST_EXPORT QQmlTypeData : public QQmlTypeLoader::Blob
@@ -414,6 +426,8 @@ public:
     void registerCallback(TypeDataCallback *);
     void unregisterCallback(TypeDataCallback *);
 
+    static QmlIR::Document *parse(QQmlTypeLoader *loader, const QUrl &url, const QByteArray &data, QList<QQmlError> *errors);
+
 protected:
     virtual void done();
     virtual void completed();
@@ -425,6 +439,10 @@ protected:
     virtual QString stringAt(int index) const;
 
 private:
+    class DiskCacheJob;
+    friend class DiskCacheJob;
+    static void saveToDiskCache(QQmlTypeLoader *loader, QQmlDiskCache *diskCache, const QUrl &url, const QByteArray &data);
+
     void continueLoadFromIR();
     void resolveTypes();
     void compile();
@@ -512,6 +530,8 @@ public:
 
     QQmlScriptData *scriptData() const;
 
+    static QQmlRefPointer<QV4::CompiledData::CompilationUnit> compile(QQmlTypeLoader *loader, const QUrl &url, const QByteArray &data, QList<QQmlError> *errors);
+
 protected:
     virtual void dataReceived(const Data &);
     virtual void initializeFromCachedUnit(const QQmlPrivate::CachedQmlUnit *unit);
@@ -1870,7 +1870,7 @@ ReturnedValue GlobalExtensions::method_qsTrIdNoOp(CallContext *ctx)
 
 QV4::ReturnedValue GlobalExtensions::method_gc(CallContext *ctx)
 {
-    ctx->d()->engine->memoryManager->runGC();
+    ctx->d()->engine->memoryManager->runGC(/*forceFullCollection*/true);
 
     return QV4::Encode::undefined();
 }
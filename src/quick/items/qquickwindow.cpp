@@ -66,6 +66,8 @@
 
 #include <private/qqmlprofilerservice_p.h>
 #include <private/qqmlmemoryprofiler_p.h>
+#include <private/qqmlengine_p.h>
+#include <private/qv4mm_p.h>
 
 #include <private/qopenglvertexarrayobject_p.h>
 
@@ -138,6 +140,9 @@ public slots:
                 if (incubatingObjectCount())
                     incubateAgain();
             }
+        } else if (QQmlEngine *e = engine()) {
+            // Nothing to incubate, spend the time on incremental garbage collection instead.
+            QQmlEnginePrivate::getV4Engine(e)->memoryManager->incrementalGCStep(m_incubation_time * 1000);
         }
     }
 
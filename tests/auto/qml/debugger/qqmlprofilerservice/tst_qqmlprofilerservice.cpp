@@ -76,6 +76,7 @@ public:
         PixmapCacheEvent,
         SceneGraphFrame,
         MemoryAllocation,
+        GarbageCollection,
 
         MaximumMessage
     };
@@ -144,6 +145,7 @@ public:
     QList<QQmlProfilerData> jsHeapMessages;
     QList<QQmlProfilerData> asynchronousMessages;
     QList<QQmlProfilerData> pixmapMessages;
+    QList<QQmlProfilerData> garbageCollectionMessages;
 
     void setTraceState(bool enabled) {
         QByteArray message;
@@ -335,6 +337,14 @@ void QQmlProfilerClient::messageReceived(const QByteArray &message)
         stream >> data.amount;
         break;
     }
+    case QQmlProfilerClient::GarbageCollection: {
+        qint64 allocatedBytes, heapSize, usedMemory, largeItemsMemory;
+        stream >> data.amount >> allocatedBytes >> heapSize >> usedMemory >> largeItemsMemory;
+        QVERIFY(data.amount >= 0);
+        QVERIFY(allocatedBytes >= 0);
+        QVERIFY(usedMemory <= heapSize);
+        break;
+    }
     default:
         QString failMsg = QString("Unknown message type:") + data.messageType;
         QFAIL(qPrintable(failMsg));
@@ -348,6 +358,8 @@ void QQmlProfilerClient::messageReceived(const QByteArray &message)
         asynchronousMessages.append(data);
     else if (data.messageType == QQmlProfilerClient::MemoryAllocation)
         jsHeapMessages.append(data);
+    else if (data.messageType == QQmlProfilerClient::GarbageCollection)
+        garbageCollectionMessages.append(data);
     else if (data.detailType == QQmlProfilerClient::Javascript)
         javascriptMessages.append(data);
     else
@@ -43,6 +43,8 @@
 #include <qqmlcomponent.h>
 #include <stdlib.h>
 #include <private/qv4alloca_p.h>
+#include <private/qv4mm_p.h>
+#include <private/qv8engine_p.h>
 
 #ifdef Q_CC_MSVC
 #define NO_INLINE __declspec(noinline)
@@ -97,6 +99,23 @@ private slots:
     void castWithMultipleInheritance();
     void collectGarbage();
     void gcWithNestedDataStructure();
+    void generationalGC_data();
+    void generationalGC();
+    void incrementalGC();
+    void lazySweep();
+    void compaction();
+    void heapStatistics();
+    void adaptiveTrigger();
+    void parallelMarking();
+    void largeItems();
+    void polymorphicPropertyLookups();
+    void tieredCompilation();
+    void onStackReplacement();
+    void typeFeedback();
+    void loopInvariantCodeMotion();
+    void functionInlining();
+    void integerRangeAnalysis();
+    void scalarReplacement();
     void stacktrace();
     void numberParsing_data();
     void numberParsing();
@@ -1508,6 +1527,684 @@ void tst_QJSEngine::gcWithNestedDataStructure()
     }
 }
 
+void tst_QJSEngine::generationalGC_data()
+{
+    QTest::addColumn<bool>("incremental");
+    QTest::newRow("generational") << false;
+    QTest::newRow("generational and incremental") << true;
+}
+
+void tst_QJSEngine::generationalGC()
+{
+    QFETCH(bool, incremental);
+
+    // Minor collections must find the young objects that are only referenced
+    // from old ones. Without soft-dirty page tracking they fall back to full ones.
+    qputenv("QV4_MM_GENERATIONAL", "1");
+    if (incremental)
+        qputenv("QV4_MM_INCREMENTAL", "1");
+    QJSEngine eng;
+    qunsetenv("QV4_MM_GENERATIONAL");
+    qunsetenv("QV4_MM_INCREMENTAL");
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&eng);
+
+    QJSValue holder = eng.evaluate("var holder = { items: [] }; holder");
+    QVERIFY(!holder.isError());
+    eng.collectGarbage();
+
+    const int count = 20;
+    for (int i = 0; i < count; ++i) {
+        QJSValue ret = eng.evaluate(QString::fromLatin1(
+            "for (var j = 0; j < 1000; ++j) holder.tmp = { value: j };"
+            "holder.items.push({ value: %1 + '' });"
+            "holder.last = { value: %1 + '' };").arg(i));
+        QVERIFY(!ret.isError());
+        // Incremental marking resets the dirty pages when it starts, outside of the pause.
+        if (incremental)
+            v4->memoryManager->incrementalGCStep(50);
+        v4->memoryManager->runGC();
+    }
+
+    QJSValue items = holder.property("items");
+    for (int i = 0; i < count; ++i)
+        QCOMPARE(items.property(i).property("value").toString(), QString::number(i));
+    QCOMPARE(holder.property("last").property("value").toString(), QString::number(count - 1));
+
+    // Only the resets of the dirty pages during the pauses are counted.
+    foreach (const QVariant &collection, eng.heapStatistics().value("recentCollections").toList()) {
+        const QVariantMap map = collection.toMap();
+        QVERIFY(map.value("dirtyPagesResetNsecs").toLongLong() >= 0);
+        QVERIFY(map.value("dirtyPagesResetNsecs").toLongLong() <= map.value("pauseNsecs").toLongLong());
+    }
+}
+
+void tst_QJSEngine::incrementalGC()
+{
+    // Objects stored into already scanned ones between marking steps must survive.
+    qputenv("QV4_MM_INCREMENTAL", "1");
+    QJSEngine eng;
+    qunsetenv("QV4_MM_INCREMENTAL");
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+
+    QJSValue ret = eng.evaluate(
+        "var holder = { items: [] };"
+        "function churn(n) {"
+        "  var o;"
+        "  for (var i = 0; i < n; ++i)"
+        "    o = { value: i };"
+        "  return o;"
+        "}");
+    QVERIFY(!ret.isError());
+
+    const int count = 200;
+    for (int i = 0; i < count; ++i) {
+        ret = eng.evaluate(QString::fromLatin1("churn(100); holder.items.push({ value: %1 + '' });").arg(i));
+        QVERIFY(!ret.isError());
+        mm->incrementalGCStep(50);
+    }
+    while (mm->incrementalGCStep(1000)) {}
+
+    QJSValue items = eng.globalObject().property("holder").property("items");
+    for (int i = 0; i < count; ++i)
+        QCOMPARE(items.property(i).property("value").toString(), QString::number(i));
+}
+
+void tst_QJSEngine::lazySweep()
+{
+    qputenv("QV4_MM_LAZY_SWEEP", "1");
+    QJSEngine eng;
+    qunsetenv("QV4_MM_LAZY_SWEEP");
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+
+    QJSValue ret = eng.evaluate("var holder = { items: [] }");
+    QVERIFY(!ret.isError());
+
+    const int count = 50;
+    for (int i = 0; i < count; ++i) {
+        ret = eng.evaluate(QString::fromLatin1(
+            "for (var j = 0; j < 100; ++j) holder.tmp = { value: j };"
+            "holder.items.push({ value: %1 + '' });").arg(i));
+        QVERIFY(!ret.isError());
+        mm->runGC();
+    }
+
+    QJSValue items = eng.globalObject().property("holder").property("items");
+    for (int i = 0; i < count; ++i)
+        QCOMPARE(items.property(i).property("value").toString(), QString::number(i));
+
+    // Explicit collections still sweep right away.
+    QPointer<QObject> ptr = new QObject();
+    (void)eng.newQObject(ptr);
+    eng.collectGarbage();
+    if (ptr)
+        QGuiApplication::sendPostedEvents(ptr, QEvent::DeferredDelete);
+    QVERIFY(ptr.isNull());
+}
+
+void tst_QJSEngine::compaction()
+{
+    QJSEngine eng;
+    QV4::MemoryManager *mm = QV8Engine::getV4(&eng)->memoryManager;
+
+    // Keep every tenth object alive, leaving the chunks sparsely populated.
+    QJSValue ret = eng.evaluate(
+        "var kept = [];"
+        "for (var i = 0; i < 100000; ++i) {"
+        "  var o = { value: i + '' };"
+        "  if (i % 10 == 0)"
+        "    kept.push(o);"
+        "}");
+    QVERIFY(!ret.isError());
+    mm->runGC();
+    const size_t usedBefore = mm->getUsedMem();
+
+    eng.collectGarbage();
+    QVERIFY(mm->getUsedMem() <= usedBefore);
+
+    // Items on released pages must be usable again.
+    ret = eng.evaluate(
+        "var more = [];"
+        "for (var i = 0; i < 100000; ++i)"
+        "  more.push({ value: i + '' });");
+    QVERIFY(!ret.isError());
+    eng.collectGarbage();
+
+    QJSValue kept = eng.globalObject().property("kept");
+    QJSValue more = eng.globalObject().property("more");
+    for (int i = 0; i < 10000; i += 97) {
+        QCOMPARE(kept.property(i).property("value").toString(), QString::number(i * 10));
+        QCOMPARE(more.property(i).property("value").toString(), QString::number(i));
+    }
+}
+
+void tst_QJSEngine::heapStatistics()
+{
+    QJSEngine eng;
+    QJSValue ret = eng.evaluate(
+        "var kept = [];"
+        "for (var i = 0; i < 1000; ++i)"
+        "  kept.push({ value: i + '' });");
+    QVERIFY(!ret.isError());
+
+    QVariantMap stats = eng.heapStatistics();
+    QVERIFY(stats.value("allocatedMemory").toULongLong() > 0);
+    QVERIFY(stats.value("allocatedBytes").toULongLong() > 0);
+    QVERIFY(stats.value("usedMemory").toULongLong() <= stats.value("allocatedMemory").toULongLong());
+
+    quint64 usedMemory = 0;
+    foreach (const QVariant &sizeClass, stats.value("sizeClasses").toList()) {
+        const QVariantMap map = sizeClass.toMap();
+        QVERIFY(map.value("usedItems").toUInt() <= map.value("items").toUInt());
+        usedMemory += map.value("usedItems").toULongLong() * map.value("itemSize").toULongLong();
+    }
+    QCOMPARE(usedMemory, stats.value("usedMemory").toULongLong());
+
+    const uint collections = stats.value("collections").toUInt();
+    eng.collectGarbage();
+    stats = eng.heapStatistics();
+    QCOMPARE(stats.value("collections").toUInt(), collections + 1);
+    QCOMPARE(stats.value("allocatedBytes").toULongLong(), Q_UINT64_C(0));
+    const QVariantList recent = stats.value("recentCollections").toList();
+    QVERIFY(!recent.isEmpty());
+    QVERIFY(recent.last().toMap().value("allocatedBytes").toULongLong() > 0);
+    QVERIFY(stats.value("maxPauseNsecs").toLongLong() >= recent.last().toMap().value("pauseNsecs").toLongLong());
+    // Only generational and incremental collection track the dirty pages.
+    QCOMPARE(recent.last().toMap().value("dirtyPagesResetNsecs").toLongLong(), Q_INT64_C(0));
+}
+
+void tst_QJSEngine::adaptiveTrigger()
+{
+    qputenv("QV4_MM_HEAP_GROWTH", "1.5");
+    QJSEngine eng;
+    qunsetenv("QV4_MM_HEAP_GROWTH");
+
+    // Garbage gets collected without any explicit collection, while the live objects stay.
+    QJSValue ret = eng.evaluate(
+        "var kept = [];"
+        "for (var i = 0; i < 200000; ++i) {"
+        "  var o = { value: i + '' };"
+        "  if (i % 100 == 0)"
+        "    kept.push(o);"
+        "}");
+    QVERIFY(!ret.isError());
+    QVERIFY(eng.heapStatistics().value("collections").toUInt() > 0);
+
+    QJSValue kept = eng.globalObject().property("kept");
+    QCOMPARE(kept.property("length").toInt(), 2000);
+    for (int i = 0; i < 2000; i += 37)
+        QCOMPARE(kept.property(i).property("value").toString(), QString::number(i * 100));
+}
+
+void tst_QJSEngine::parallelMarking()
+{
+    qputenv("QV4_MM_MARK_THREADS", "4");
+    QJSEngine eng;
+    qunsetenv("QV4_MM_MARK_THREADS");
+
+    QJSValue ret = eng.evaluate(
+        "var lists = [];"
+        "for (var i = 0; i < 100; ++i) {"
+        "  var list = null;"
+        "  for (var j = 0; j < 1000; ++j)"
+        "    list = { value: i + ':' + j, next: list };"
+        "  lists.push(list);"
+        "}");
+    QVERIFY(!ret.isError());
+    eng.collectGarbage();
+    eng.collectGarbage();
+
+    QJSValue lists = eng.globalObject().property("lists");
+    for (int i = 0; i < 100; i += 7) {
+        QJSValue list = lists.property(i);
+        for (int j = 999; j >= 0; --j) {
+            QCOMPARE(list.property("value").toString(), QString::fromLatin1("%1:%2").arg(i).arg(j));
+            list = list.property("next");
+        }
+        QVERIFY(list.isNull());
+    }
+}
+
+void tst_QJSEngine::largeItems()
+{
+    QJSEngine eng;
+
+    // Array data of this size spans many pages and gets mappings of its own.
+    QJSValue ret = eng.evaluate(
+        "var kept = [];"
+        "for (var i = 0; i < 50; ++i) {"
+        "  var a = new Array(20000);"
+        "  for (var j = 0; j < a.length; ++j)"
+        "    a[j] = i * j;"
+        "  if (i % 5 == 0)"
+        "    kept.push(a);"
+        "}");
+    QVERIFY(!ret.isError());
+    QVariantMap stats = eng.heapStatistics();
+    QVERIFY(stats.value("largeItemsMappedMemory").toULongLong() > 0);
+    const quint64 largeItemsMemory = stats.value("largeItemsMemory").toULongLong();
+    const uint largeItems = stats.value("largeItems").toUInt();
+
+    ret = eng.evaluate("kept.length = 5; kept = kept.slice(0);");
+    QVERIFY(!ret.isError());
+    eng.collectGarbage();
+    stats = eng.heapStatistics();
+    QVERIFY(stats.value("largeItemsMemory").toULongLong() < largeItemsMemory);
+    QVERIFY(stats.value("largeItems").toUInt() < largeItems);
+
+    // The mappings kept for reuse get handed out again.
+    ret = eng.evaluate(
+        "var fresh = [];"
+        "for (var i = 0; i < 5; ++i) {"
+        "  var a = new Array(20000);"
+        "  for (var j = 0; j < a.length; ++j)"
+        "    a[j] = -j;"
+        "  fresh.push(a);"
+        "}");
+    QVERIFY(!ret.isError());
+    eng.collectGarbage();
+
+    QJSValue kept = eng.globalObject().property("kept");
+    QJSValue fresh = eng.globalObject().property("fresh");
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 20000; j += 997) {
+            QCOMPARE(kept.property(i).property(j).toInt(), i * 5 * j);
+            QCOMPARE(fresh.property(i).property(j).toInt(), -j);
+        }
+    }
+}
+
+void tst_QJSEngine::polymorphicPropertyLookups()
+{
+    QJSEngine eng;
+
+    // Cycles the same property lookups through more shapes than any lookup caches inline,
+    // some of them with the property on the prototype, as an accessor or not at all.
+    QJSValue ret = eng.evaluate(
+        "function getX(o) { return o.x; }"
+        "var shapes = [];"
+        "for (var i = 0; i < 20; ++i) {"
+        "  var o = {};"
+        "  for (var j = 0; j < i; ++j)"
+        "    o['p' + j] = j;"
+        "  if (i % 5 == 1)"
+        "    o = Object.create({ x: -i });"
+        "  else if (i % 5 == 2)"
+        "    Object.defineProperty(o, 'x', { get: function() { return -1000; } });"
+        "  else if (i % 5 != 3)"
+        "    o.x = i;"
+        "  shapes.push(o);"
+        "}"
+        "var results = [];"
+        "for (var round = 0; round < 3; ++round) {"
+        "  for (var i = 0; i < shapes.length; ++i)"
+        "    results.push(getX(shapes[i]));"
+        "}"
+        "results.push(getX('string'));"
+        "results;");
+    QVERIFY(!ret.isError());
+
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 20; ++i) {
+            QJSValue result = ret.property(round * 20 + i);
+            if (i % 5 == 1)
+                QCOMPARE(result.toInt(), -i);
+            else if (i % 5 == 2)
+                QCOMPARE(result.toInt(), -1000);
+            else if (i % 5 == 3)
+                QVERIFY(result.isUndefined());
+            else
+                QCOMPARE(result.toInt(), i);
+        }
+    }
+    QVERIFY(ret.property(60).isUndefined());
+}
+
+void tst_QJSEngine::tieredCompilation()
+{
+    qputenv("QV4_JIT_THRESHOLD", "5");
+    QJSEngine eng;
+    qunsetenv("QV4_JIT_THRESHOLD");
+
+    // The functions switch from the interpreter to compiled code halfway through, so the
+    // results have to come out the same either way.
+    QJSValue ret = eng.evaluate(
+        "function sum(n) { var s = 0; for (var i = 0; i < n; ++i) s += i; return s; }"
+        "function makeCounter(start) { var c = start; return function() { return c++; }; }"
+        "function safeDivide(a, b) {"
+        "  try { if (b === 0) throw new Error('zero'); return a / b; }"
+        "  catch (e) { return e.message; }"
+        "}"
+        "function describe(o) { return o.name + ':' + o.value; }"
+        "var results = [];"
+        "for (var round = 0; round < 20; ++round) {"
+        "  results.push(sum(round));"
+        "  var counter = makeCounter(round);"
+        "  counter();"
+        "  results.push(counter());"
+        "  results.push(safeDivide(round, round % 3));"
+        "  results.push(describe({ name: 'r' + round, value: round * 2 }));"
+        "}"
+        "results;");
+    QVERIFY(!ret.isError());
+
+    for (int round = 0; round < 20; ++round) {
+        QCOMPARE(ret.property(round * 4).toInt(), round * (round - 1) / 2);
+        QCOMPARE(ret.property(round * 4 + 1).toInt(), round + 1);
+        if (round % 3 == 0)
+            QCOMPARE(ret.property(round * 4 + 2).toString(), QStringLiteral("zero"));
+        else
+            QCOMPARE(ret.property(round * 4 + 2).toNumber(), double(round) / (round % 3));
+        QCOMPARE(ret.property(round * 4 + 3).toString(), QString::fromLatin1("r%1:%2").arg(round).arg(round * 2));
+    }
+
+    // A single call with a hot loop gets the function compiled for the next call.
+    ret = eng.evaluate(
+        "function loop(n) { var s = ''; for (var i = 0; i < n; ++i) s = String(i % 10); return s + n; }"
+        "[loop(100), loop(3)];");
+    QVERIFY(!ret.isError());
+    QCOMPARE(ret.property(0).toString(), QStringLiteral("9100"));
+    QCOMPARE(ret.property(1).toString(), QStringLiteral("23"));
+
+    // The code is compiled in the background, so it only gets used after some more calls.
+    ret = eng.evaluate(
+        "var total = 0;"
+        "for (var i = 0; i < 2000; ++i)"
+        "  total += sum(i % 10) + makeCounter(i)();"
+        "total;");
+    QVERIFY(!ret.isError());
+    QCOMPARE(ret.toInt(), 200 * 120 + 1999 * 1000);
+
+    // Compilations still pending when the engine goes away get cancelled.
+    qputenv("QV4_JIT_THRESHOLD", "1");
+    {
+        QJSEngine shortLived;
+        QJSValue result = shortLived.evaluate(
+            "function f(x) { return x * 2; }"
+            "function g(x) { return f(x) + 1; }"
+            "g(1) + g(2);");
+        QCOMPARE(result.toInt(), 8);
+    }
+    qunsetenv("QV4_JIT_THRESHOLD");
+}
+
+void tst_QJSEngine::onStackReplacement()
+{
+    qputenv("QV4_JIT_THRESHOLD", "10");
+    QJSEngine eng;
+    qunsetenv("QV4_JIT_THRESHOLD");
+
+    // Each function is called once, so its loops move over to the compiled code while they
+    // run, whenever that is ready. The variables have to carry over unchanged.
+    QJSValue ret = eng.evaluate(
+        "function sum(n) { var s = 0; for (var i = 0; i < n; ++i) s += i; return s; }"
+        "function formals(a, b) { while (a < 100000) { a += b; b = b % 7 + 1; } return a * 10 + b; }"
+        "function nested(n) {"
+        "  var count = 0, text = '';"
+        "  for (var i = 0; i < n; ++i) {"
+        "    for (var j = 0; j < 100; ++j) {"
+        "      if (j % 10 == 3) continue;"
+        "      if (i == j) break;"
+        "      ++count;"
+        "    }"
+        "    if (i % 250 == 0) text += i;"
+        "  }"
+        "  return text + ':' + count;"
+        "}"
+        "function usesArguments(n) { var s = 0; for (var i = 0; i < n; ++i) s += arguments.length + arguments[0]; return s; }"
+        "function forIn(o) { var keys = 0; for (var k in o) for (var i = 0; i < 1000; ++i) keys += k.length; return keys; }"
+        "function throws(n) { for (var i = 0; i < n; ++i) if (i == n - 1) throw new Error('at ' + i); }"
+        "var caught = '';"
+        "try { throws(50000); } catch (e) { caught = e.message; }"
+        "[sum(100000), formals(1, 1), nested(1000), usesArguments(20000), forIn({ a: 1, bb: 2 }), caught];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toNumber(), 4999950000.0);
+
+    int a = 1, b = 1;
+    while (a < 100000) { a += b; b = b % 7 + 1; }
+    QCOMPARE(ret.property(1).toInt(), a * 10 + b);
+
+    int count = 0;
+    QString text;
+    for (int i = 0; i < 1000; ++i) {
+        for (int j = 0; j < 100; ++j) {
+            if (j % 10 == 3)
+                continue;
+            if (i == j)
+                break;
+            ++count;
+        }
+        if (i % 250 == 0)
+            text += QString::number(i);
+    }
+    QCOMPARE(ret.property(2).toString(), text + QLatin1Char(':') + QString::number(count));
+
+    QCOMPARE(ret.property(3).toInt(), 20000 * (1 + 20000));
+    QCOMPARE(ret.property(4).toInt(), 3000);
+    QCOMPARE(ret.property(5).toString(), QStringLiteral("at 49999"));
+}
+
+void tst_QJSEngine::typeFeedback()
+{
+    qputenv("QV4_JIT_THRESHOLD", "5");
+    QJSEngine eng;
+    qunsetenv("QV4_JIT_THRESHOLD");
+
+    // The functions get compiled for the argument types they were called with so far. Calls with
+    // other types have to give the same results, from the interpreter.
+    QJSValue ret = eng.evaluate(
+        "function add(a, b) { return a + b; }"
+        "function scale(x, f) { var s = 0; for (var i = 0; i < 10; ++i) s += x * f; return s; }"
+        "var total = 0;"
+        "for (var i = 0; i < 3000; ++i)"
+        "  total += add(i, 1) + scale(i, 0.5);"
+        "[total, add('a', 'b'), add(2147483647, 1), add(1.5, 2), scale(2, 3), scale('4', 0.5), add(3, 4), add(5)];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toNumber(), 3000.0 * 2999 / 2 * 6 + 3000);
+    QCOMPARE(ret.property(1).toString(), QStringLiteral("ab"));
+    QCOMPARE(ret.property(2).toNumber(), 2147483648.0);
+    QCOMPARE(ret.property(3).toNumber(), 3.5);
+    QCOMPARE(ret.property(4).toInt(), 60);
+    QCOMPARE(ret.property(5).toInt(), 20);
+    QCOMPARE(ret.property(6).toInt(), 7);
+    QVERIFY(qIsNaN(ret.property(7).toNumber()));
+
+    // Most of the closures are created by the compiled makeAdder, they have to be checked as well.
+    ret = eng.evaluate(
+        "function makeAdder(k) { return function(x) { return x + k; }; }"
+        "var adders = [];"
+        "for (var i = 0; i < 100; ++i)"
+        "  adders.push(makeAdder(i));"
+        "var sum = 0;"
+        "for (var j = 0; j < 100; ++j)"
+        "  sum += adders[j](j);"
+        "[sum, adders[99]('x'), adders[98](0.5), adders[97](), adders[96](4)];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toInt(), 9900);
+    QCOMPARE(ret.property(1).toString(), QStringLiteral("x99"));
+    QCOMPARE(ret.property(2).toNumber(), 98.5);
+    QVERIFY(qIsNaN(ret.property(3).toNumber()));
+    QCOMPARE(ret.property(4).toInt(), 100);
+
+    // Values that don't come from the arguments are not speculated on, so functions without any,
+    // like bindings, have to cope with whatever types they read.
+    ret = eng.evaluate(
+        "var source = { value: 1 };"
+        "function binding() { return source.value * 2 + 1; }"
+        "var ints = 0;"
+        "for (var k = 0; k < 100; ++k) { source.value = k; ints += binding(); }"
+        "source.value = 0.25; var fraction = binding();"
+        "source.value = 'a'; var text = binding();"
+        "source.value = 1073741824; var large = binding();"
+        "[ints, fraction, text, large];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toInt(), 10000);
+    QCOMPARE(ret.property(1).toNumber(), 1.5);
+    QVERIFY(qIsNaN(ret.property(2).toNumber()));
+    QCOMPARE(ret.property(3).toNumber(), 2147483649.0);
+}
+
+void tst_QJSEngine::loopInvariantCodeMotion()
+{
+    QJSEngine eng;
+
+    // Only values that really can't change in a loop may be computed once, and moving them out
+    // of the loop must not run anything that wouldn't have run before.
+    QJSValue ret = eng.evaluate(
+        "function pure(a, b, n) { var s = 0; for (var i = 0; i < n; ++i) s += a * b + i; return s; }"
+        "function constant(n) { var s = 0; for (var i = 0; i < n; ++i) s += Math.PI; return s; }"
+        "function bump(o) { o.x++; }"
+        "function changedByCall(o, n) { var s = 0; for (var i = 0; i < n; ++i) { s += o.x; bump(o); } return s; }"
+        "function changedByStore(o) { var i = 0; while (i < o.n) { ++i; if (i == 2) o.n = 5; } return i; }"
+        "function notEntered(o, n) { var s = 0; for (var i = 0; i < n; ++i) s += o.x; return s; }"
+        "function reload(o) { var a = o.x; var b = o.x; o.x = a + b; return a * 10 + o.x * 100 + b; }"
+        "[pure(3, 4, 10), pure(3, 4, 0), constant(3) === 0 + Math.PI + Math.PI + Math.PI,"
+        " changedByCall({ x: 1 }, 3), changedByStore({ n: 3 }), notEntered(null, 0),"
+        " notEntered({ x: 2 }, 5), reload({ x: 1 })];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toInt(), 165);
+    QCOMPARE(ret.property(1).toInt(), 0);
+    QVERIFY(ret.property(2).toBool());
+    QCOMPARE(ret.property(3).toInt(), 6);
+    QCOMPARE(ret.property(4).toInt(), 5);
+    QCOMPARE(ret.property(5).toInt(), 0);
+    QCOMPARE(ret.property(6).toInt(), 10);
+    QCOMPARE(ret.property(7).toInt(), 211);
+
+    // Property, element and global reads can run getters, so they must neither be merged nor
+    // moved out of loops.
+    ret = eng.evaluate(
+        "function readTwice(o) { var a = o.x; var b = o.x; return a * 10 + b; }"
+        "function readInLoop(o, n) { var s = 0; for (var i = 0; i < n; ++i) s += o.x; return s; }"
+        "function readElement(a, n) { var s = 0; for (var i = 0; i < n; ++i) s += a[0]; return s; }"
+        "function readGlobal(n) { var s = 0; for (var i = 0; i < n; ++i) s += ticks; return s; }"
+        "var elementReads = 0; var globalReads = 0;"
+        "var array = []; Object.defineProperty(array, 0, { get: function() { return ++elementReads; } });"
+        "Object.defineProperty(this, 'ticks', { get: function() { return ++globalReads; } });"
+        "[readTwice({ n: 0, get x() { return ++this.n; } }),"
+        " readInLoop({ n: 0, get x() { return ++this.n; } }, 3),"
+        " readElement(array, 3), readGlobal(3)];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toInt(), 12);
+    QCOMPARE(ret.property(1).toInt(), 6);
+    QCOMPARE(ret.property(2).toInt(), 6);
+    QCOMPARE(ret.property(3).toInt(), 6);
+}
+
+void tst_QJSEngine::functionInlining()
+{
+    QJSEngine eng;
+
+    // Inlined calls have to behave exactly like real ones, also when the function they were
+    // inlined for gets replaced, or when called with too few or too many arguments.
+    QJSValue ret = eng.evaluate(
+        "function square(x) { return x * x; }"
+        "function sum(n) { var s = 0; for (var i = 0; i < n; ++i) s += square(i); return s; }"
+        "function outer(n) {"
+        "    var scale = 3;"
+        "    function scaled(x, y) { var r = x * scale; return y === undefined ? r : r + y; }"
+        "    function setScale(s) { scale = s; }"
+        "    var a = scaled(n); setScale(10); var b = scaled(n, 1, 2);"
+        "    return a + ',' + b + ',' + scaled();"
+        "}"
+        "function replaced() { var first = square(4); square = function(x) { return -x; }; return first + square(4); }"
+        "function increment(x) { return x + 1; }"
+        "function callIncrement() { return increment(1); }"
+        "function notAFunction() { var r = callIncrement(); increment = 5;"
+        "    try { callIncrement(); } catch (e) { return e instanceof TypeError ? r : -1; } return -2; }"
+        "function deepZ(o) { return o.y.z; }"
+        "function getZ(o) { return deepZ(o); }"
+        "function throwing() { try { getZ(1); } catch (e) { return e instanceof TypeError; } return false; }"
+        "[sum(10), outer(2), replaced(), square(3), notAFunction(), throwing(), getZ({ y: { z: 7 } })];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toInt(), 285);
+    QCOMPARE(ret.property(1).toString(), QStringLiteral("6,21,NaN"));
+    QCOMPARE(ret.property(2).toInt(), 12);
+    QCOMPARE(ret.property(3).toInt(), -3);
+    QCOMPARE(ret.property(4).toInt(), 2);
+    QVERIFY(ret.property(5).toBool());
+    QCOMPARE(ret.property(6).toInt(), 7);
+
+    // A closure of the same function from another activation sees other variables, so it must
+    // not run the inlined copy.
+    ret = eng.evaluate(
+        "function make(v) {"
+        "    function get() { return v; }"
+        "    function read() { return get(); }"
+        "    function take(other) { get = other.get; }"
+        "    return { get: get, read: read, take: take };"
+        "}"
+        "var a = make(1), b = make(2);"
+        "var before = a.read(); a.take(b);"
+        "[before, a.read(), b.read()];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toInt(), 1);
+    QCOMPARE(ret.property(1).toInt(), 2);
+    QCOMPARE(ret.property(2).toInt(), 2);
+}
+
+void tst_QJSEngine::integerRangeAnalysis()
+{
+    QJSEngine eng;
+
+    // Arithmetic may only be done in 32 bits when it provably cannot overflow or produce -0.
+    QJSValue ret = eng.evaluate(
+        "function count(n) { n = n | 0; var s = 0; for (var i = 0; i < n; ++i) s += i; return s; }"
+        "function upToMax() { var i = 2147483640; while (i < 2147483647) ++i; return i; }"
+        "function pastMax() { var i = 2147483640; for (var k = 0; k < 10; ++k) i = i + 1; return i; }"
+        "function down() { var s = 0; for (var i = 10; i > 0; --i) s += i; return s; }"
+        "function negativeZero() { var x = 1; for (var i = 0; i < 1; ++i) x = i * -3; return 1 / x; }"
+        "function pixels() {"
+        "    var data = [];"
+        "    for (var i = 0; i < 16; ++i) data[i] = (i * 37) & 255;"
+        "    var sum = 0;"
+        "    for (var j = 0; j < 16; j += 4) sum += data[j] + (data[j + 1] >> 1);"
+        "    return sum;"
+        "}"
+        "[count(100), upToMax(), pastMax(), down(), negativeZero(), pixels()];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toInt(), 4950);
+    QCOMPARE(ret.property(1).toNumber(), 2147483647.0);
+    QCOMPARE(ret.property(2).toNumber(), 2147483650.0);
+    QCOMPARE(ret.property(3).toInt(), 55);
+    QVERIFY(qIsInf(ret.property(4).toNumber()) && ret.property(4).toNumber() < 0);
+    QCOMPARE(ret.property(5).toInt(), 636);
+}
+
+void tst_QJSEngine::scalarReplacement()
+{
+    QJSEngine eng;
+
+    // Literals that are only read from are replaced by their values; everything else has to keep
+    // seeing a real object.
+    QJSValue ret = eng.evaluate(
+        "function length(a, b) { var p = { x: a, y: b }; var q = p; return Math.sqrt(q.x * q.x + p.y * p.y); }"
+        "function inherited(a) { var o = { a: a }; return o.toString === Object.prototype.toString; }"
+        "function captured(a) { var o = { a: a }; var f = function() { return o.a; }; o.a = a + 1; return f(); }"
+        "function stored(a) { var o = { a: a }; o.a = a * 2; return o.a; }"
+        "function getter() { var o = { get a() { return 7; } }; return o.a; }"
+        "function elements() { var a = [10, 20, , 40]; return a[0] + a[3] + a.length + (a[2] === undefined ? 1 : 0); }"
+        "function outOfRange() { var a = [1, 2]; return a[2]; }"
+        "[length(3, 4), inherited(1), captured(1), stored(2), getter(), elements(), outOfRange()];");
+    QVERIFY(!ret.isError());
+
+    QCOMPARE(ret.property(0).toInt(), 5);
+    QCOMPARE(ret.property(1).toBool(), true);
+    QCOMPARE(ret.property(2).toInt(), 2);
+    QCOMPARE(ret.property(3).toInt(), 4);
+    QCOMPARE(ret.property(4).toInt(), 7);
+    QCOMPARE(ret.property(5).toInt(), 55);
+    QVERIFY(ret.property(6).isUndefined());
+}
+
 void tst_QJSEngine::stacktrace()
 {
     QString script = QString::fromLatin1(
@@ -61,7 +61,8 @@ PRIVATETESTS += \
     v4misc \
     qqmltranslation \
     qqmlimport \
-    qqmlobjectmodel
+    qqmlobjectmodel \
+    qmlcachegen
 
 qtHaveModule(widgets) {
     PUBLICTESTS += \
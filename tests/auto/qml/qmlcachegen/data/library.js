@@ -0,0 +1,5 @@
+.pragma library
+
+function add(a, b) {
+    return a + b;
+}
@@ -0,0 +1,8 @@
+.import "library.js" as Library
+
+function sum(n) {
+    var result = 0;
+    for (var i = 1; i <= n; ++i)
+        result = Library.add(result, i);
+    return result;
+}
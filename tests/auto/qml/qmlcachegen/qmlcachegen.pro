@@ -0,0 +1,24 @@
+CONFIG += testcase
+TARGET = tst_qmlcachegen
+QT += qml qml-private testlib
+macx:CONFIG -= app_bundle
+
+SOURCES += tst_qmlcachegen.cpp
+RESOURCES = qmlcachegen.qrc
+
+# The scripts are not in the resources, they can only be loaded from the generated units.
+CACHED_FILES = data/script.js data/library.js data/main.qml
+
+qtPrepareTool(QMLCACHEGEN, qmlcachegen)
+qmlcachegen.input = CACHED_FILES
+qmlcachegen.output = qmlcache_loader.cpp
+qmlcachegen.commands = $$QMLCACHEGEN --root $$PWD -o ${QMAKE_FILE_OUT} ${QMAKE_FILE_IN}
+qmlcachegen.depends = $$QMLCACHEGEN_EXE
+qmlcachegen.CONFIG += combine
+qmlcachegen.variable_out = SOURCES
+QMAKE_EXTRA_COMPILERS += qmlcachegen
+
+DEFINES += SRCDIR=\\\"$$PWD\\\"
+
+CONFIG += parallel_test
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,114 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <qtest.h>
+#include <QDir>
+#include <QLibraryInfo>
+#include <QProcess>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <private/qqmlmetatype_p.h>
+
+class tst_qmlcachegen : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void loadGeneratedUnits();
+    void errors_data();
+    void errors();
+
+private:
+    QString qmlcachegenPath;
+};
+
+void tst_qmlcachegen::initTestCase()
+{
+    qmlcachegenPath = QLibraryInfo::location(QLibraryInfo::BinariesPath);
+
+#if defined(Q_OS_WIN)
+    qmlcachegenPath += QLatin1String("/qmlcachegen.exe");
+#else
+    qmlcachegenPath += QLatin1String("/qmlcachegen");
+#endif
+
+    if (!QFileInfo(qmlcachegenPath).exists()) {
+        QString message = QString::fromLatin1("qmlcachegen executable not found (looked for %0)")
+                .arg(qmlcachegenPath);
+        QFAIL(qPrintable(message));
+    }
+}
+
+void tst_qmlcachegen::loadGeneratedUnits()
+{
+    QVERIFY(QQmlMetaType::findCachedCompilationUnit(QUrl("qrc:/data/script.js")));
+    QVERIFY(QQmlMetaType::findCachedCompilationUnit(QUrl("qrc:///data/library.js")));
+    const QQmlPrivate::CachedQmlUnit *document = QQmlMetaType::findCachedCompilationUnit(QUrl("qrc:/data/main.qml"));
+    QVERIFY(document);
+    QVERIFY(document->loadIR);
+
+    // The scripts are not in the resources, so they must come from the generated units.
+    QQmlEngine engine;
+    QQmlComponent component(&engine, QUrl("qrc:/data/main.qml"));
+    QScopedPointer<QObject> object(component.create());
+    QVERIFY2(object, qPrintable(component.errorString()));
+    QCOMPARE(object->property("result").toInt(), 55);
+}
+
+void tst_qmlcachegen::errors_data()
+{
+    QTest::addColumn<QString>("fileName");
+
+    QTest::newRow("js") << QString::fromLatin1("syntaxError.js");
+    QTest::newRow("qml") << QString::fromLatin1("syntaxError.qml");
+}
+
+void tst_qmlcachegen::errors()
+{
+    QFETCH(QString, fileName);
+
+    const QString output = QDir::temp().filePath(QLatin1String("tst_qmlcachegen_errors.cpp"));
+    QProcess generator;
+    generator.setWorkingDirectory(QLatin1String(SRCDIR "/data/errors"));
+    generator.start(qmlcachegenPath, QStringList() << QLatin1String("-o") << output << fileName);
+    QVERIFY(generator.waitForFinished());
+    QCOMPARE(generator.exitStatus(), QProcess::NormalExit);
+    QVERIFY(generator.exitCode() != 0);
+    QVERIFY(generator.readAllStandardError().contains(fileName.toLocal8Bit() + ":"));
+    QVERIFY(!QFile::exists(output));
+}
+
+QTEST_MAIN(tst_qmlcachegen)
+
+#include "tst_qmlcachegen.moc"
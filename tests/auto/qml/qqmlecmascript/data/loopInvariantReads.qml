@@ -0,0 +1,13 @@
+import QtQml 2.0
+import Qt.test 1.0
+
+ReadCounter {
+    value: 5
+
+    // The conditions read value, or point, on every iteration unless the read is moved out of the loop.
+    function countUp() { var n = 0; for (var i = 0; i < value; ++i) ++n; return n; }
+    function countUpWithCall() { var n = 0; for (var i = 0; i < value; ++i) { ++n; touch(); } return n; }
+    function countUpWithStore() { var n = 0; for (var i = 0; i < value; ++i) { ++n; if (i == 2) value = 4; } return n; }
+    function countUpToPoint() { var n = 0; for (var i = 0; i < point.x; ++i) ++n; return n; }
+    function sumPi() { var s = 0; for (var i = 0; i < 4; ++i) s += Math.PI; return s; }
+}
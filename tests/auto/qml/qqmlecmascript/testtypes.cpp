@@ -474,6 +474,7 @@ void registerTypes()
     qmlRegisterType<QObjectContainer>("Qt.test", 1, 0, "QObjectContainer");
     qmlRegisterType<QObjectContainerWithGCOnAppend>("Qt.test", 1, 0, "QObjectContainerWithGCOnAppend");
     qmlRegisterType<FloatingQObject>("Qt.test", 1, 0, "FloatingQObject");
+    qmlRegisterType<ReadCounter>("Qt.test", 1, 0, "ReadCounter");
 }
 
 #include "testtypes.moc"
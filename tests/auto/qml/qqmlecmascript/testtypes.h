@@ -1698,6 +1698,32 @@ public:
     virtual void componentComplete();
 };
 
+// Counts the reads of its properties, to see which reads the optimizer moved out of loops
+class ReadCounter : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int value READ value WRITE setValue NOTIFY valueChanged)
+    Q_PROPERTY(QPointF point READ point CONSTANT)
+public:
+    ReadCounter() : m_value(0), m_reads(0) {}
+
+    int value() const { ++m_reads; return m_value; }
+    void setValue(int value) { m_value = value; emit valueChanged(); }
+    QPointF point() const { ++m_reads; return QPointF(m_value, 0); }
+
+    Q_INVOKABLE void touch() {}
+
+    int reads() const { return m_reads; }
+    void resetReads() { m_reads = 0; }
+
+signals:
+    void valueChanged();
+
+private:
+    int m_value;
+    mutable int m_reads;
+};
+
 void registerTypes();
 
 #endif // TESTTYPES_H
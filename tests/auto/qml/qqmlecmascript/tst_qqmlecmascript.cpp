@@ -39,6 +39,7 @@
 #include <QtCore/qdebug.h>
 #include <QtCore/qdir.h>
 #include <QtCore/qnumeric.h>
+#include <QtCore/qmath.h>
 #include <private/qqmlengine_p.h>
 #include <private/qqmlvmemetaobject_p.h>
 #include <private/qqmlcontextwrapper_p.h>
@@ -326,6 +327,7 @@ private slots:
     void readUnregisteredQObjectProperty();
     void writeUnregisteredQObjectProperty();
     void switchExpression();
+    void loopInvariantPropertyReads();
 
 private:
 //    static void propertyVarWeakRefCallback(v8::Persistent<v8::Value> object, void* parameter);
@@ -7871,6 +7873,45 @@ void tst_qqmlecmascript::switchExpression()
     QCOMPARE(v.toBool(), true);
 }
 
+void tst_qqmlecmascript::loopInvariantPropertyReads()
+{
+    QQmlEngine engine;
+    QQmlComponent component(&engine, testFileUrl("loopInvariantReads.qml"));
+    QScopedPointer<QObject> object(component.create());
+    QVERIFY2(object, qPrintable(component.errorString()));
+    ReadCounter *counter = qobject_cast<ReadCounter *>(object.data());
+    QVERIFY(counter);
+    QVariant result;
+
+    // Reading an int property of a QObject runs no script, so in a loop without calls or stores
+    // it is done before the loop (or once more in the peeled first iteration).
+    counter->resetReads();
+    QVERIFY(QMetaObject::invokeMethod(object.data(), "countUp", Q_RETURN_ARG(QVariant, result)));
+    QCOMPARE(result.toInt(), 5);
+    QVERIFY2(counter->reads() <= 2, qPrintable(QString::number(counter->reads())));
+
+    // A call or a store in the loop can change the property.
+    counter->resetReads();
+    QVERIFY(QMetaObject::invokeMethod(object.data(), "countUpWithCall", Q_RETURN_ARG(QVariant, result)));
+    QCOMPARE(result.toInt(), 5);
+    QCOMPARE(counter->reads(), 6);
+
+    // Each read of a value type property creates a new object, so it stays in the loop.
+    counter->resetReads();
+    QVERIFY(QMetaObject::invokeMethod(object.data(), "countUpToPoint", Q_RETURN_ARG(QVariant, result)));
+    QCOMPARE(result.toInt(), 5);
+    QCOMPARE(counter->reads(), 6);
+
+    counter->resetReads();
+    QVERIFY(QMetaObject::invokeMethod(object.data(), "countUpWithStore", Q_RETURN_ARG(QVariant, result)));
+    QCOMPARE(result.toInt(), 4);
+    QCOMPARE(counter->reads(), 5);
+
+    // Math is taken from the frozen global object, so Math.PI is a constant.
+    QVERIFY(QMetaObject::invokeMethod(object.data(), "sumPi", Q_RETURN_ARG(QVariant, result)));
+    QCOMPARE(result.toDouble(), 4 * M_PI);
+}
+
 QTEST_MAIN(tst_qqmlecmascript)
 
 #include "tst_qqmlecmascript.moc"
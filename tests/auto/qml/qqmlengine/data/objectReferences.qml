@@ -0,0 +1,21 @@
+import QtQml 2.0
+
+QtObject {
+    property QtObject object
+    property var value
+    property Component factory: Component { QtObject { property int value } }
+
+    // The new objects are only referenced from the properties of this, possibly old, object.
+    function assign(i) {
+        object = factory.createObject(null, { value: i });
+        value = { value: i };
+    }
+
+    function check(i) {
+        // Reuses the memory of anything that got collected by mistake.
+        var garbage;
+        for (var j = 0; j < 1000; ++j)
+            garbage = { value: -1 };
+        return object !== null && object.value === i && value !== undefined && value.value === i;
+    }
+}
@@ -46,6 +46,8 @@
 #include <QQmlExpression>
 #include <QQmlIncubationController>
 #include <private/qqmlengine_p.h>
+#include <private/qv4mm_p.h>
+#include <private/qv8engine_p.h>
 #include <QQmlAbstractUrlInterceptor>
 
 class tst_qqmlengine : public QQmlDataTest
@@ -74,6 +76,8 @@ private slots:
     void qtqmlModule();
     void urlInterceptor_data();
     void urlInterceptor();
+    void generationalGC();
+    void incrementalGC();
 
 public slots:
     QObject *createAQObjectForOwnershipTest ()
@@ -777,6 +781,67 @@ void tst_qqmlengine::urlInterceptor()
     QCOMPARE(o->property("absoluteUrl").toString(), expectedAbsoluteUrl);
 }
 
+void tst_qqmlengine::generationalGC()
+{
+    // Minor collections must find the objects that are only referenced from the QObject and
+    // var properties of old QML objects, which don't live on the garbage collected heap.
+    qputenv("QV4_MM_GENERATIONAL", "1");
+    QQmlEngine engine;
+    qunsetenv("QV4_MM_GENERATIONAL");
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+
+    QQmlComponent component(&engine, testFileUrl("objectReferences.qml"));
+    QScopedPointer<QObject> root(component.create());
+    QVERIFY2(root, qPrintable(component.errorString()));
+    engine.collectGarbage();
+
+    for (int i = 0; i < 20; ++i) {
+        QVERIFY(QMetaObject::invokeMethod(root.data(), "assign", Q_ARG(QVariant, i)));
+        mm->runGC();
+        mm->runGC();
+        QVariant ok;
+        QVERIFY(QMetaObject::invokeMethod(root.data(), "check", Q_RETURN_ARG(QVariant, ok), Q_ARG(QVariant, i)));
+        QVERIFY(ok.toBool());
+    }
+}
+
+void tst_qqmlengine::incrementalGC()
+{
+    // The same, for objects assigned to QML properties of objects that incremental marking
+    // already scanned, and for QObjects getting parented to those.
+    qputenv("QV4_MM_INCREMENTAL", "1");
+    QQmlEngine engine;
+    qunsetenv("QV4_MM_INCREMENTAL");
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+
+    QQmlComponent component(&engine, testFileUrl("objectReferences.qml"));
+    QScopedPointer<QObject> root(component.create());
+    QVERIFY2(root, qPrintable(component.errorString()));
+    QJSValue parent = engine.newQObject(new QObject);
+    QJSValue garbage = engine.evaluate(QString::fromLatin1(
+        "(function() { var o; for (var i = 0; i < 1000; ++i) o = { value: i }; })"));
+    QVERIFY(garbage.isCallable());
+
+    QList<QPointer<QObject> > children;
+    for (int i = 0; i < 20; ++i) {
+        garbage.call();
+        mm->incrementalGCStep(50);
+        QVERIFY(QMetaObject::invokeMethod(root.data(), "assign", Q_ARG(QVariant, i)));
+        // Owned by JavaScript, and only kept alive through the wrapper of its parent.
+        QObject *child = new QObject;
+        engine.newQObject(child);
+        child->setParent(parent.toQObject());
+        children.append(child);
+        while (mm->incrementalGCStep(1000)) {}
+        QVariant ok;
+        QVERIFY(QMetaObject::invokeMethod(root.data(), "check", Q_RETURN_ARG(QVariant, ok), Q_ARG(QVariant, i)));
+        QVERIFY(ok.toBool());
+    }
+    mm->runGC();
+    for (int i = 0; i < children.count(); ++i)
+        QVERIFY(children.at(i));
+}
+
 QTEST_MAIN(tst_qqmlengine)
 
 #include "tst_qqmlengine.moc"
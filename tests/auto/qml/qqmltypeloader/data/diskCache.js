@@ -0,0 +1,6 @@
+function sum(n) {
+    var result = 0;
+    for (var i = 1; i <= n; ++i)
+        result += i;
+    return result;
+}
@@ -0,0 +1,19 @@
+import QtQml 2.0
+import "diskCache.js" as Script
+
+QtObject {
+    id: root
+
+    signal done(int value)
+
+    property int base: Script.sum(10)
+    property int result: 0
+    property QtObject helper: QtObject {
+        property int offset: root.base
+    }
+
+    function add(a, b) { return a + b; }
+
+    onDone: result = add(value, helper.offset - base)
+    Component.onCompleted: done(base)
+}
@@ -0,0 +1,10 @@
+import QtQml 2.0
+
+QtObject {
+    id: root
+
+    property int value: 1
+    property DiskCacheItem item: DiskCacheItem {}
+    property int result: item.factor * value + value
+    property string text: "value " + root.value
+}
@@ -0,0 +1,7 @@
+import QtQml 2.0
+import "first.js" as Script
+
+QtObject {
+    property QtObject leaf: Leaf { factor: 1 }
+    property int value: Script.value() + leaf.value
+}
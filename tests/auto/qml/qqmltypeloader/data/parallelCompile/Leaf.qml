@@ -0,0 +1,6 @@
+import QtQml 2.0
+
+QtObject {
+    property int factor
+    property int value: factor * 2
+}
@@ -0,0 +1,7 @@
+import QtQml 2.0
+import "second.js" as Script
+
+QtObject {
+    property QtObject leaf: Leaf { factor: 10 }
+    property int value: Script.value() + leaf.value
+}
@@ -0,0 +1,6 @@
+import QtQml 2.0
+
+QtObject {
+    property QtObject leaf: Leaf { factor: 100 }
+    property int value: leaf.value
+}
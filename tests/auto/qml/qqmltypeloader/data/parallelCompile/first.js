@@ -0,0 +1,5 @@
+.import "shared.js" as Shared
+
+function value() {
+    return Shared.base + 1;
+}
@@ -0,0 +1 @@
+var base = 1000;
@@ -33,6 +33,7 @@
 
 #include <QtTest/QtTest>
 #include <QtQml/qqmlengine.h>
+#include <QtQml/qqmlcomponent.h>
 #include <QtQuick/qquickview.h>
 #include <QtQuick/qquickitem.h>
 #include "../../shared/util.h"
@@ -42,9 +43,22 @@ class tst_QQMLTypeLoader : public QQmlDataTest
     Q_OBJECT
 
 private slots:
+    void initTestCase();
     void testLoadComplete();
+    void diskCache();
+    void diskCacheDocuments();
+    void parallelCompile();
+    void parallelCompileErrors();
+    void startupManifest();
 };
 
+void tst_QQMLTypeLoader::initTestCase()
+{
+    QQmlDataTest::initTestCase();
+    // The backend is chosen once per process; the interpreter is available on every platform.
+    qputenv("QV4_FORCE_INTERPRETER", "1");
+}
+
 void tst_QQMLTypeLoader::testLoadComplete()
 {
     QQuickView *window = new QQuickView();
@@ -62,6 +76,216 @@ void tst_QQMLTypeLoader::testLoadComplete()
     delete window;
 }
 
+static int evaluateResult(const QUrl &url)
+{
+    QQmlEngine engine;
+    QQmlComponent component(&engine, url);
+    QScopedPointer<QObject> object(component.create());
+    if (!object)
+        return -1;
+    return object->property("result").toInt();
+}
+
+static QString cacheFileName(const QString &sourceFile)
+{
+    const QByteArray url = QUrl::fromLocalFile(sourceFile).toString().toUtf8();
+    return QString::fromLatin1(QCryptographicHash::hash(url, QCryptographicHash::Sha1).toHex()) + QLatin1String(".qmlc");
+}
+
+void tst_QQMLTypeLoader::diskCache()
+{
+    QTemporaryDir cacheDir;
+    QTemporaryDir sourceDir;
+    QVERIFY(cacheDir.isValid());
+    QVERIFY(sourceDir.isValid());
+    qputenv("QML_DISK_CACHE_PATH", QFile::encodeName(cacheDir.path()));
+
+    const QString qmlFile = sourceDir.path() + QLatin1String("/diskCache.qml");
+    const QString jsFile = sourceDir.path() + QLatin1String("/diskCache.js");
+    QVERIFY(QFile::copy(testFile("diskCache.qml"), qmlFile));
+    QVERIFY(QFile::copy(testFile("diskCache.js"), jsFile));
+    QVERIFY(QFile::setPermissions(jsFile, QFile::ReadOwner | QFile::WriteOwner));
+    QVERIFY(QFile::setPermissions(qmlFile, QFile::ReadOwner | QFile::WriteOwner));
+    const QUrl url = QUrl::fromLocalFile(qmlFile);
+
+    QCOMPARE(evaluateResult(url), 55);
+    QDir cache(cacheDir.path());
+    // Documents are only cached on request.
+    QCOMPARE(cache.entryList(QStringList() << QLatin1String("*.qmlc"), QDir::Files).count(), 1);
+    QVERIFY(!cache.exists(cacheFileName(qmlFile)));
+    const QString cacheFile = cache.filePath(cacheFileName(jsFile));
+    QVERIFY(QFile::exists(cacheFile));
+
+    QCOMPARE(evaluateResult(url), 55);
+
+    // A modified script must not use the stale cache file.
+    {
+        QFile js(jsFile);
+        QVERIFY(js.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        js.write("function sum(n) { return n * 2; }\n");
+    }
+    QCOMPARE(evaluateResult(url), 20);
+    QCOMPARE(evaluateResult(url), 20);
+
+    // A damaged cache file is ignored and the script compiled again.
+    {
+        QFile file(cacheFile);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.resize(file.size() / 2));
+    }
+    QCOMPARE(evaluateResult(url), 20);
+
+    // A cache file written by another build of QtQml is replaced. The key of the build follows
+    // the magic and the Qt version.
+    QByteArray header;
+    {
+        QFile file(cacheFile);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        header = file.read(32);
+        QCOMPARE(header.size(), 32);
+        QByteArray otherBuild = header;
+        otherBuild[12] = ~otherBuild.at(12);
+        QVERIFY(file.seek(0));
+        QCOMPARE(file.write(otherBuild), qint64(otherBuild.size()));
+    }
+    QCOMPARE(evaluateResult(url), 20);
+    {
+        QFile file(cacheFile);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.read(32), header);
+    }
+
+    // The same goes for a modified document.
+    {
+        QFile qml(qmlFile);
+        QVERIFY(qml.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        qml.write("import QtQml 2.0\n"
+                  "import \"diskCache.js\" as Script\n"
+                  "QtObject { property int result: Script.sum(10) + 1 }\n");
+    }
+    QCOMPARE(evaluateResult(url), 21);
+    QCOMPARE(evaluateResult(url), 21);
+
+    qunsetenv("QML_DISK_CACHE_PATH");
+}
+
+void tst_QQMLTypeLoader::diskCacheDocuments()
+{
+    QTemporaryDir cacheDir;
+    QTemporaryDir sourceDir;
+    QVERIFY(cacheDir.isValid());
+    QVERIFY(sourceDir.isValid());
+    qputenv("QML_DISK_CACHE_PATH", QFile::encodeName(cacheDir.path()));
+    qputenv("QML_DISK_CACHE_QML_DOCUMENTS", "1");
+
+    const QStringList files = QStringList() << QLatin1String("diskCache.qml") << QLatin1String("diskCache.js")
+                                            << QLatin1String("diskCacheBindings.qml") << QLatin1String("DiskCacheItem.qml");
+    foreach (const QString &file, files) {
+        const QString copy = sourceDir.path() + QLatin1Char('/') + file;
+        QVERIFY(QFile::copy(testFile(file), copy));
+        QVERIFY(QFile::setPermissions(copy, QFile::ReadOwner | QFile::WriteOwner));
+    }
+    QDir cache(cacheDir.path());
+
+    // The engine waits for the writer thread when it goes away, so the cache is filled after the
+    // first run. The second one is served from the cache, with the signal handler, method, ids and
+    // attached objects of the document restored.
+    const QString qmlFile = sourceDir.path() + QLatin1String("/diskCache.qml");
+    QCOMPARE(evaluateResult(QUrl::fromLocalFile(qmlFile)), 55);
+    QVERIFY(cache.exists(cacheFileName(qmlFile)));
+    QCOMPARE(evaluateResult(QUrl::fromLocalFile(qmlFile)), 55);
+
+    // Bindings from the cache look up names at run-time, and still depend on what they read.
+    const QString bindingsFile = sourceDir.path() + QLatin1String("/diskCacheBindings.qml");
+    for (int run = 0; run < 2; ++run) {
+        QQmlEngine engine;
+        QQmlComponent component(&engine, QUrl::fromLocalFile(bindingsFile));
+        QScopedPointer<QObject> object(component.create());
+        QVERIFY2(object, qPrintable(component.errorString()));
+        QCOMPARE(object->property("result").toInt(), 11);
+        object->setProperty("value", 3);
+        QCOMPARE(object->property("result").toInt(), 33);
+        QCOMPARE(object->property("text").toString(), QStringLiteral("value 3"));
+    }
+    QVERIFY(cache.exists(cacheFileName(bindingsFile)));
+
+    // An imported type that changed its property layout doesn't invalidate the cache file of the
+    // document that uses it.
+    {
+        QFile item(sourceDir.path() + QLatin1String("/DiskCacheItem.qml"));
+        QVERIFY(item.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        item.write("import QtQml 2.0\n"
+                   "QtObject { property string name: \"item\"; property real scale: 0.5; property int factor: 100 }\n");
+    }
+    {
+        QQmlEngine engine;
+        QQmlComponent component(&engine, QUrl::fromLocalFile(bindingsFile));
+        QScopedPointer<QObject> object(component.create());
+        QVERIFY2(object, qPrintable(component.errorString()));
+        QCOMPARE(object->property("result").toInt(), 101);
+        object->setProperty("value", 3);
+        QCOMPARE(object->property("result").toInt(), 303);
+    }
+
+    qunsetenv("QML_DISK_CACHE_QML_DOCUMENTS");
+    qunsetenv("QML_DISK_CACHE_PATH");
+}
+
+void tst_QQMLTypeLoader::parallelCompile()
+{
+    const QUrl url = testFileUrl("parallelCompile/main.qml");
+    QCOMPARE(evaluateResult(url), 2225);
+
+    qputenv("QML_DISABLE_PARALLEL_COMPILE", "1");
+    QCOMPARE(evaluateResult(url), 2225);
+    qunsetenv("QML_DISABLE_PARALLEL_COMPILE");
+}
+
+void tst_QQMLTypeLoader::parallelCompileErrors()
+{
+    QQmlEngine engine;
+    QQmlComponent component(&engine, testFileUrl("parallelCompile/brokenChild.qml"));
+    QVERIFY(component.isError());
+
+    bool reported = false;
+    foreach (const QQmlError &error, component.errors()) {
+        if (error.url() == testFileUrl("parallelCompile/Broken.qml"))
+            reported = true;
+    }
+    QVERIFY(reported);
+}
+
+void tst_QQMLTypeLoader::startupManifest()
+{
+    QTemporaryDir manifestDir;
+    QVERIFY(manifestDir.isValid());
+    const QString manifestFile = manifestDir.path() + QLatin1String("/startup.manifest");
+    qputenv("QML_STARTUP_MANIFEST", QFile::encodeName(manifestFile));
+
+    const QUrl url = testFileUrl("parallelCompile/main.qml");
+    QCOMPARE(evaluateResult(url), 2225);
+
+    QFile manifest(manifestFile);
+    QVERIFY(manifest.open(QIODevice::ReadOnly | QIODevice::Text));
+    const QStringList entries = QString::fromUtf8(manifest.readAll()).split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    manifest.close();
+    QCOMPARE(entries.first(), QLatin1String("qml ") + url.toString());
+    QVERIFY(entries.contains(QLatin1String("qml ") + testFileUrl("parallelCompile/Leaf.qml").toString()));
+    QVERIFY(entries.contains(QLatin1String("js ") + testFileUrl("parallelCompile/shared.js").toString()));
+    QCOMPARE(entries.count(), entries.toSet().count());
+
+    // Loading with the files prefetched gives the same result.
+    QCOMPARE(evaluateResult(url), 2225);
+
+    // Files that are gone or are loaded differently are skipped.
+    QVERIFY(manifest.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text));
+    manifest.write("qml file:///nonexistent/Missing.qml\nqmldir /nonexistent/qmldir\nunknown entry\n");
+    manifest.close();
+    QCOMPARE(evaluateResult(url), 2225);
+
+    qunsetenv("QML_STARTUP_MANIFEST");
+}
+
 QTEST_MAIN(tst_QQMLTypeLoader)
 
 #include "tst_qqmltypeloader.moc"
@@ -36,6 +36,7 @@
 #include <QQmlContext>
 #include <QQmlComponent>
 #include <QFile>
+#include <QTemporaryDir>
 #include <QDebug>
 #include "testtypes.h"
 
@@ -58,6 +59,8 @@ private slots:
     void basicproperty();
     void creation_data();
     void creation();
+    void diskCache_data();
+    void diskCache();
 
 private:
     QQmlEngine engine;
@@ -176,5 +179,62 @@ void tst_binding::creation()
     }
 }
 
+void tst_binding::diskCache_data()
+{
+    QTest::addColumn<QString>("binding");
+    QTest::addColumn<bool>("cacheDocuments");
+
+    QTest::newRow("value + 10, compiled") << "value + 10" << false;
+    QTest::newRow("value + 10, from cache") << "value + 10" << true;
+    QTest::newRow("value + value + 10, compiled") << "value + value + 10" << false;
+    QTest::newRow("value + value + 10, from cache") << "value + value + 10" << true;
+}
+
+// Bindings of documents loaded from the disk cache are compiled without type information.
+void tst_binding::diskCache()
+{
+    QFETCH(QString, binding);
+    QFETCH(bool, cacheDocuments);
+
+    QTemporaryDir cacheDir;
+    QTemporaryDir sourceDir;
+    QVERIFY(cacheDir.isValid());
+    QVERIFY(sourceDir.isValid());
+    const QString fileName = sourceDir.path() + QLatin1String("/Binding.qml");
+    {
+        QFile source(SRCDIR "/data/localproperty.txt");
+        QVERIFY(source.open(QIODevice::ReadOnly));
+        QByteArray data = source.readAll();
+        data.replace("###", binding.toUtf8());
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+    qputenv("QML_DISK_CACHE_PATH", QFile::encodeName(cacheDir.path()));
+    if (cacheDocuments)
+        qputenv("QML_DISK_CACHE_QML_DOCUMENTS", "1");
+
+    // The first engine fills the cache.
+    {
+        QQmlEngine engine;
+        QQmlComponent c(&engine, QUrl::fromLocalFile(fileName));
+        QScopedPointer<QObject> object(c.create());
+        QVERIFY(object);
+    }
+
+    QQmlEngine engine;
+    QQmlComponent c(&engine, QUrl::fromLocalFile(fileName));
+    QScopedPointer<MyQmlObject> object(qobject_cast<MyQmlObject *>(c.create()));
+    QVERIFY(object);
+    object->setValue(10);
+
+    QBENCHMARK {
+        object->setValue(1);
+    }
+
+    qunsetenv("QML_DISK_CACHE_QML_DOCUMENTS");
+    qunsetenv("QML_DISK_CACHE_PATH");
+}
+
 QTEST_MAIN(tst_binding)
 #include "tst_binding.moc"
@@ -3,6 +3,9 @@ SUBDIRS = \
         qjsengine \
 #        qjsvalue \ ### FIXME: doesn't build
         qjsvalueiterator \
+        qv4mm \
+        qv4moth \
+        qv4tiered \
 
 TRUSTED_BENCHMARKS += \
     qjsvalue \
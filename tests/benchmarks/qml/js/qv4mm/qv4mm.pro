@@ -0,0 +1,8 @@
+CONFIG += testcase
+TEMPLATE = app
+TARGET = tst_bench_qv4mm
+
+SOURCES += tst_qv4mm.cpp
+
+QT += qml qml-private testlib
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,217 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <qtest.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qthread.h>
+#include <QtQml/qjsengine.h>
+#include <private/qv4engine_p.h>
+#include <private/qv4mm_p.h>
+#include <private/qv4object_p.h>
+#include <private/qv8engine_p.h>
+
+class tst_qv4mm : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void allocateObjects_data();
+    void allocateObjects();
+    void allocateFromScript_data();
+    void allocateFromScript();
+    void markHeap_data();
+    void markHeap();
+    void minorCollection_data();
+    void minorCollection();
+
+private:
+    void reportAllocationRate(int allocations, qint64 nsecs);
+};
+
+void tst_qv4mm::reportAllocationRate(int allocations, qint64 nsecs)
+{
+    if (nsecs > 0)
+        qDebug("%lld allocations per second", qint64(allocations * 1e9 / nsecs));
+}
+
+void tst_qv4mm::allocateObjects_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("100000") << 100000;
+    QTest::newRow("1000000") << 1000000;
+}
+
+void tst_qv4mm::allocateObjects()
+{
+    QFETCH(int, count);
+
+    QJSEngine engine;
+    QV4::ExecutionEngine *v4 = QV8Engine::getV4(&engine);
+    QV4::Scope scope(v4);
+    QV4::ScopedObject o(scope);
+
+    QElapsedTimer timer;
+    qint64 nsecs = 0;
+    int allocations = 0;
+    QBENCHMARK {
+        timer.start();
+        for (int i = 0; i < count; ++i)
+            o = v4->newObject();
+        nsecs += timer.nsecsElapsed();
+        allocations += count;
+    }
+    reportAllocationRate(allocations, nsecs);
+}
+
+void tst_qv4mm::allocateFromScript_data()
+{
+    QTest::addColumn<QString>("code");
+    QTest::newRow("object literal") << QString::fromLatin1("var o; for (var i = 0; i < 100000; ++i) o = { value: i };");
+    QTest::newRow("array literal") << QString::fromLatin1("var a; for (var i = 0; i < 100000; ++i) a = [i, i];");
+    QTest::newRow("string concatenation") << QString::fromLatin1("var s; for (var i = 0; i < 100000; ++i) s = 'item' + i;");
+}
+
+void tst_qv4mm::allocateFromScript()
+{
+    QFETCH(QString, code);
+
+    QJSEngine engine;
+    QJSValue function = engine.evaluate(QString::fromLatin1("(function() { %1 })").arg(code));
+    QVERIFY(function.isCallable());
+
+    QElapsedTimer timer;
+    qint64 nsecs = 0;
+    int allocations = 0;
+    QBENCHMARK {
+        timer.start();
+        function.call();
+        nsecs += timer.nsecsElapsed();
+        allocations += 100000;
+    }
+    reportAllocationRate(allocations, nsecs);
+}
+
+void tst_qv4mm::markHeap_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("1 thread") << 1;
+    for (int threads = 2; threads < QThread::idealThreadCount(); threads *= 2)
+        QTest::newRow(qPrintable(QString::fromLatin1("%1 threads").arg(threads))) << threads;
+    if (QThread::idealThreadCount() > 1)
+        QTest::newRow(qPrintable(QString::fromLatin1("%1 threads").arg(QThread::idealThreadCount())))
+                << QThread::idealThreadCount();
+}
+
+void tst_qv4mm::markHeap()
+{
+    QFETCH(int, threads);
+
+    qputenv("QV4_MM_MARK_THREADS", QByteArray::number(threads));
+    QJSEngine engine;
+    qunsetenv("QV4_MM_MARK_THREADS");
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+
+    // A wide tree of small objects, so that there is plenty of work to share.
+    QJSValue ret = engine.evaluate(QString::fromLatin1(
+        "var heap = [];"
+        "for (var i = 0; i < 1000; ++i) {"
+        "  var node = { children: [] };"
+        "  for (var j = 0; j < 500; ++j)"
+        "    node.children.push({ value: j, next: { value: i } });"
+        "  heap.push(node);"
+        "}"));
+    QVERIFY(!ret.isError());
+
+    QBENCHMARK {
+        mm->runGC();
+    }
+
+    const QVector<QV4::MemoryManager::CollectionStatistics> collections = mm->statistics().recentCollections;
+    qint64 markTime = 0;
+    for (int i = 0; i < collections.size(); ++i)
+        markTime += collections.at(i).markTime;
+    qDebug("%d marking threads: %lld usecs per mark phase", threads, markTime / collections.size() / 1000);
+}
+
+void tst_qv4mm::minorCollection_data()
+{
+    QTest::addColumn<int>("residentMegabytes");
+    QTest::newRow("no other memory") << 0;
+    QTest::newRow("64 MB other memory") << 64;
+    QTest::newRow("512 MB other memory") << 512;
+}
+
+// The soft-dirty bits that minor collections rely on are reset for the whole process,
+// so the memory used outside of the JS heap adds to their pauses.
+void tst_qv4mm::minorCollection()
+{
+    QFETCH(int, residentMegabytes);
+
+    const QByteArray other(residentMegabytes << 20, 'x');
+    qputenv("QV4_MM_GENERATIONAL", "1");
+    QJSEngine engine;
+    qunsetenv("QV4_MM_GENERATIONAL");
+    QV4::MemoryManager *mm = QV8Engine::getV4(&engine)->memoryManager;
+
+    QJSValue ret = engine.evaluate(QString::fromLatin1(
+        "var heap = [];"
+        "for (var i = 0; i < 100000; ++i)"
+        "  heap.push({ value: i });"));
+    QVERIFY(!ret.isError());
+    mm->runGC();
+
+    QBENCHMARK {
+        engine.evaluate(QString::fromLatin1("for (var i = 0; i < 1000; ++i) heap[i * 100].value = { value: i };"));
+        mm->runGC();
+    }
+
+    const QVector<QV4::MemoryManager::CollectionStatistics> collections = mm->statistics().recentCollections;
+    qint64 pause = 0;
+    qint64 resetTime = 0;
+    int minorCollections = 0;
+    for (int i = 0; i < collections.size(); ++i) {
+        if (!collections.at(i).minorCollection)
+            continue;
+        pause += collections.at(i).pause;
+        resetTime += collections.at(i).dirtyPagesResetTime;
+        ++minorCollections;
+    }
+    if (minorCollections)
+        qDebug("%lld usecs per minor collection, %lld usecs of it resetting the dirty pages (%d bytes of other memory)",
+               pause / minorCollections / 1000, resetTime / minorCollections / 1000, other.size());
+}
+
+QTEST_MAIN(tst_qv4mm)
+
+#include "tst_qv4mm.moc"
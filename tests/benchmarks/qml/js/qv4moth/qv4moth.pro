@@ -0,0 +1,8 @@
+CONFIG += testcase
+TEMPLATE = app
+TARGET = tst_bench_qv4moth
+
+SOURCES += tst_qv4moth.cpp
+
+QT += qml testlib
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
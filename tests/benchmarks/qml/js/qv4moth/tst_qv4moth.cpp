@@ -0,0 +1,96 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <qtest.h>
+#include <QtQml/qjsengine.h>
+
+// Measures the interpreter on the instruction sequences that dominate typical script code:
+// compare-and-branch loops, small function calls, property access and early returns.
+class tst_qv4moth : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void interpret_data();
+    void interpret();
+};
+
+void tst_qv4moth::initTestCase()
+{
+    // Must happen before the first engine is created, the setting is read only once.
+    qputenv("QV4_FORCE_INTERPRETER", "1");
+}
+
+void tst_qv4moth::interpret_data()
+{
+    QTest::addColumn<QString>("code");
+    QTest::newRow("counting loop") << QString::fromLatin1(
+        "var s = 0; for (var i = 0; i < 1000000; ++i) s += i; return s;");
+    QTest::newRow("nested compares") << QString::fromLatin1(
+        "var n = 0;"
+        "for (var i = 0; i < 300000; ++i) {"
+        "  if (i % 3 == 0) ++n; else if (i % 5 === 1) n += 2; else if (i >= 1000 && i <= 2000) --n;"
+        "}"
+        "return n;");
+    QTest::newRow("calls") << QString::fromLatin1(
+        "function sign(x) { if (x < 0) return -1; if (x > 0) return 1; return 0; }"
+        "var s = 0; for (var i = -100000; i < 100000; ++i) s += sign(i); return s;");
+    QTest::newRow("property access") << QString::fromLatin1(
+        "var p = { x: 0, y: 0 };"
+        "for (var i = 0; i < 300000; ++i) { p.x = p.x + 1; if (p.x > p.y) p.y = p.x; }"
+        "return p.y;");
+    QTest::newRow("array walk") << QString::fromLatin1(
+        "var a = []; for (var i = 0; i < 1000; ++i) a.push(i);"
+        "var s = 0; for (var k = 0; k < 200; ++k) for (var j = 0; j < a.length; ++j) s += a[j];"
+        "return s;");
+}
+
+void tst_qv4moth::interpret()
+{
+    QFETCH(QString, code);
+
+    QJSEngine engine;
+    QJSValue function = engine.evaluate(QString::fromLatin1("(function() { %1 })").arg(code));
+    QVERIFY(function.isCallable());
+
+    QBENCHMARK {
+        QJSValue result = function.call();
+        QVERIFY(!result.isError());
+    }
+}
+
+QTEST_MAIN(tst_qv4moth)
+
+#include "tst_qv4moth.moc"
@@ -0,0 +1,8 @@
+CONFIG += testcase
+TEMPLATE = app
+TARGET = tst_bench_qv4tiered
+
+SOURCES += tst_qv4tiered.cpp
+
+QT += qml testlib
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,119 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <qtest.h>
+#include <QtQml/qjsengine.h>
+
+// Compares the code of the tiered JIT, once a unit has tiered up, with the code of the plain JIT.
+// The tiered JIT only specializes functions on the types of their arguments, so the gains are
+// expected in the rows with int and double arguments. Mixed argument types, values read from
+// properties and functions without arguments, like QML bindings, get the same code as with the
+// plain JIT.
+class tst_qv4tiered : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void run_data();
+    void run();
+};
+
+void tst_qv4tiered::run_data()
+{
+    QTest::addColumn<QString>("code");
+    QTest::addColumn<bool>("tiered");
+
+    QStringList names;
+    QStringList programs;
+    names << QStringLiteral("int arguments");
+    programs << QStringLiteral(
+        "function sum(n, step) { var s = 0; for (var i = 0; i < n; i += step) s = (s + i * step) | 0; return s; }"
+        "return function() { return sum(10000, 3); };");
+    names << QStringLiteral("double arguments");
+    programs << QStringLiteral(
+        "function scale(x, f) { var s = 0; for (var i = 0; i < 10000; ++i) s += x * f + i; return s; }"
+        "return function() { return scale(0.5, 1.25); };");
+    names << QStringLiteral("mixed arguments");
+    programs << QStringLiteral(
+        "function sum(n, step) { var s = 0; for (var i = 0; i < n; i += step) s = (s + i * step) | 0; return s; }"
+        "var k = 0;"
+        "return function() { var d = ++k % 2 ? 0 : 0.5; return sum(10000 + d, 3 + d); };");
+    names << QStringLiteral("property loads");
+    programs << QStringLiteral(
+        "function walk(p) { var s = 0; for (var i = 0; i < 10000; ++i) s = (s + p.x * p.y) | 0; return s; }"
+        "var point = { x: 3, y: 4 };"
+        "return function() { return walk(point); };");
+    names << QStringLiteral("binding");
+    programs << QStringLiteral(
+        "var item = { width: 100, height: 50, margin: 3 };"
+        "function binding() { return item.width * 2 - item.margin + item.height; }"
+        "return function() { var s = 0; for (var i = 0; i < 10000; ++i) s += binding(); return s; };");
+
+    for (int i = 0; i < names.count(); ++i) {
+        QTest::newRow(qPrintable(names.at(i) + QLatin1String(", jit"))) << programs.at(i) << false;
+        QTest::newRow(qPrintable(names.at(i) + QLatin1String(", tiered"))) << programs.at(i) << true;
+    }
+}
+
+void tst_qv4tiered::run()
+{
+    QFETCH(QString, code);
+    QFETCH(bool, tiered);
+
+    // Read whenever an engine is created.
+    if (tiered)
+        qputenv("QV4_JIT_THRESHOLD", "10");
+    QJSEngine engine;
+    qunsetenv("QV4_JIT_THRESHOLD");
+
+    QJSValue function = engine.evaluate(QString::fromLatin1("(function() { %1 })()").arg(code));
+    QVERIFY(function.isCallable());
+
+    // Gets the unit hot and gives the background compiler time to finish, so that only the
+    // compiled code is measured.
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 20; ++j)
+            QVERIFY(!function.call().isError());
+        QTest::qSleep(20);
+    }
+
+    QBENCHMARK {
+        QJSValue result = function.call();
+        QVERIFY(!result.isError());
+    }
+}
+
+QTEST_MAIN(tst_qv4tiered)
+
+#include "tst_qv4tiered.moc"
@@ -0,0 +1,634 @@
+/****************************************************************************
+**
+** Copyright (C) 2015 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** As a special exception, The Qt Company gives you certain additional
+** rights. These rights are described in The Qt Company LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qdiriterator.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qsavefile.h>
+#include <QtCore/qurl.h>
+
+#include <private/qqmlirbuilder_p.h>
+#include <private/qqmljsengine_p.h>
+#include <private/qqmljslexer_p.h>
+#include <private/qqmljsparser_p.h>
+#include <private/qv4codegen_p.h>
+#include <private/qv4isel_moth_p.h>
+#include <private/qv4value_p.h>
+
+#include <stdio.h>
+
+// qmlcachegen runs on the build host, and the unit data depends on the byte order and the pointer
+// size of the machine that loads it. The data of each unit is written once for each of these
+// targets, and the generated source picks the words of the target it is compiled for.
+enum Target {
+    LittleEndian64,
+    BigEndian64,
+    LittleEndian32,
+    BigEndian32,
+    TargetCount
+};
+
+static bool isBigEndian(int target) { return target == BigEndian64 || target == BigEndian32; }
+static bool is64Bit(int target) { return target == LittleEndian64 || target == BigEndian64; }
+
+struct CompiledUnit {
+    QString resourcePath; // as returned by QQmlFile::urlToLocalFileOrQrc for its URL
+    bool isQml;
+    QVector<quint32> unitData[TargetCount];
+    QVector<quint32> code; // in the portable form, which is the same for all targets
+};
+
+static void printError(const QString &fileName, int line, int column, const QString &message)
+{
+    fprintf(stderr, "%s:%d:%d: %s\n", qPrintable(QDir::toNativeSeparators(fileName)), line, column,
+            qPrintable(message));
+}
+
+static bool readSource(const QString &fileName, QString *source)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "%s: %s\n", qPrintable(QDir::toNativeSeparators(fileName)), qPrintable(file.errorString()));
+        return false;
+    }
+    *source = QString::fromUtf8(file.readAll());
+    return true;
+}
+
+// Same as QQmlFile::urlToLocalFileOrQrc, which is not available to the host tools.
+static QString urlToLocalFileOrQrc(const QUrl &url)
+{
+    if (url.scheme().compare(QLatin1String("qrc"), Qt::CaseInsensitive) == 0) {
+        if (url.authority().isEmpty())
+            return QLatin1Char(':') + url.path();
+        return QString();
+    }
+    return url.toLocalFile();
+}
+
+/*
+Writes the data of a compiled unit for each target. The unit data is made of 32-bit numbers, which
+are the same for all targets, except for the fields that are rewritten here: bytes, 16-bit and
+64-bit numbers, bit fields, and the constants, which are encoded like QV4::Value on the target.
+When the data structures in qv4compileddata_p.h change, this has to follow.
+*/
+class UnitDataWriter
+{
+public:
+    UnitDataWriter(const QV4::CompiledData::Unit *unit, QVector<quint32> *words);
+
+    bool write();
+
+private:
+    quint32 hostWord(quint32 offset) const;
+    void setWord(int target, quint32 offset, quint32 word) { words[target][offset / sizeof(quint32)] = word; }
+    void setBytes(quint32 offset, int size);
+    void setHalfWords(quint32 offset, quint16 first, quint16 second);
+    void setQuint64(int target, quint32 offset, quint64 value);
+    bool setConstant(quint32 offset, QV4::ReturnedValue encoded);
+
+    void writeStrings();
+    void writeFunctions();
+    bool writeConstants();
+    void writeJSClasses();
+    void writeBindings();
+
+    const QV4::CompiledData::Unit *unit;
+    const char *data;
+    QVector<quint32> *words;
+};
+
+UnitDataWriter::UnitDataWriter(const QV4::CompiledData::Unit *unit, QVector<quint32> *words)
+    : unit(unit)
+    , data(reinterpret_cast<const char *>(unit))
+    , words(words)
+{
+}
+
+bool UnitDataWriter::write()
+{
+    if (unit->unitSize % sizeof(quint32) != 0)
+        return false;
+    const int wordCount = unit->unitSize / sizeof(quint32);
+    for (int target = 0; target < TargetCount; ++target) {
+        words[target].resize(wordCount);
+        for (int i = 0; i < wordCount; ++i)
+            words[target][i] = hostWord(i * sizeof(quint32));
+    }
+
+    setBytes(offsetof(QV4::CompiledData::Unit, magic), sizeof(unit->magic));
+    setHalfWords(offsetof(QV4::CompiledData::Unit, architecture), unit->architecture, unit->version);
+    writeStrings();
+    writeFunctions();
+    if (!writeConstants())
+        return false;
+    writeJSClasses();
+    if (unit->flags & QV4::CompiledData::Unit::IsQml)
+        writeBindings();
+    return true;
+}
+
+quint32 UnitDataWriter::hostWord(quint32 offset) const
+{
+    quint32 word;
+    memcpy(&word, data + offset, sizeof(word));
+    return word;
+}
+
+void UnitDataWriter::setBytes(quint32 offset, int size)
+{
+    for (int i = 0; i < size; i += 4) {
+        const uchar *bytes = reinterpret_cast<const uchar *>(data + offset + i);
+        const quint32 littleEndian = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | quint32(bytes[3]) << 24;
+        const quint32 bigEndian = quint32(bytes[0]) << 24 | bytes[1] << 16 | bytes[2] << 8 | bytes[3];
+        for (int target = 0; target < TargetCount; ++target)
+            setWord(target, offset + i, isBigEndian(target) ? bigEndian : littleEndian);
+    }
+}
+
+void UnitDataWriter::setHalfWords(quint32 offset, quint16 first, quint16 second)
+{
+    for (int target = 0; target < TargetCount; ++target)
+        setWord(target, offset, isBigEndian(target) ? quint32(first) << 16 | second : first | quint32(second) << 16);
+}
+
+void UnitDataWriter::setQuint64(int target, quint32 offset, quint64 value)
+{
+    const quint32 low = quint32(value);
+    const quint32 high = quint32(value >> 32);
+    setWord(target, offset, isBigEndian(target) ? high : low);
+    setWord(target, offset + sizeof(quint32), isBigEndian(target) ? low : high);
+}
+
+static quint64 tagValue(int target, quint32 tag, quint32 value)
+{
+    return isBigEndian(target) ? quint64(value) << 32 | tag : quint64(tag) << 32 | value;
+}
+
+// The encodings of QV4::Primitive in qv4value_p.h, for each target.
+bool UnitDataWriter::setConstant(quint32 offset, QV4::ReturnedValue encoded)
+{
+    QV4::Value value;
+    value.setRawValue(encoded);
+    for (int target = 0; target < TargetCount; ++target) {
+        quint64 raw;
+        if (value.isUndefined()) {
+            raw = is64Bit(target) ? quint64(0x00008000) << 32 : tagValue(target, 0x7ffe4000, 0);
+        } else if (value.isNull()) {
+            raw = is64Bit(target) ? quint64(0x00018000) << 32 : tagValue(target, 0x7fff4001, 0);
+        } else if (value.isBoolean()) {
+            raw = tagValue(target, is64Bit(target) ? 0x00010000 : 0x7ffec001, value.booleanValue());
+        } else if (value.isInteger()) {
+            raw = tagValue(target, is64Bit(target) ? 0x00030000 : 0x7fffc001, quint32(value.integerValue()));
+        } else if (value.isDouble()) {
+            const double d = value.doubleValue();
+            memcpy(&raw, &d, sizeof(raw));
+            if (is64Bit(target))
+                raw ^= Q_UINT64_C(0xffff800000000000);
+        } else {
+            return false;
+        }
+        setQuint64(target, offset, raw);
+    }
+    return true;
+}
+
+void UnitDataWriter::writeStrings()
+{
+    const quint32 *offsetTable = reinterpret_cast<const quint32 *>(data + unit->offsetToStringTable);
+    for (uint i = 0; i < unit->stringTableSize; ++i) {
+        const quint32 offset = offsetTable[i] + sizeof(QV4::CompiledData::String);
+        const QV4::CompiledData::String *string = reinterpret_cast<const QV4::CompiledData::String *>(data + offsetTable[i]);
+        // String::calculateSize pads the characters to 8 bytes, so the last pair can be read.
+        const quint16 *characters = reinterpret_cast<const quint16 *>(data + offset);
+        for (int j = 0; j < string->size; j += 2)
+            setHalfWords(offset + j * sizeof(quint16), characters[j], characters[j + 1]);
+    }
+}
+
+void UnitDataWriter::writeFunctions()
+{
+    for (uint i = 0; i < unit->functionTableSize; ++i) {
+        const quint32 offset = unit->functionOffsetTable()[i];
+        const quint64 flags = unit->functionAt(i)->flags;
+        for (int target = 0; target < TargetCount; ++target)
+            setQuint64(target, offset + offsetof(QV4::CompiledData::Function, flags), flags);
+    }
+}
+
+bool UnitDataWriter::writeConstants()
+{
+    for (uint i = 0; i < unit->constantTableSize; ++i) {
+        const quint32 offset = unit->offsetToConstantTable + i * sizeof(QV4::ReturnedValue);
+        if (!setConstant(offset, unit->constants()[i].asReturnedValue()))
+            return false;
+    }
+    return true;
+}
+
+void UnitDataWriter::writeJSClasses()
+{
+    const quint32 *offsetTable = reinterpret_cast<const quint32 *>(data + unit->offsetToJSClassTable);
+    for (uint i = 0; i < unit->jsClassTableSize; ++i) {
+        int memberCount;
+        const QV4::CompiledData::JSClassMember *members = unit->jsClassAt(i, &memberCount);
+        for (int j = 0; j < memberCount; ++j) {
+            // Bit fields start at the least significant bit on little endian targets, and at the
+            // most significant bit on big endian ones.
+            const quint32 offset = offsetTable[i] + sizeof(QV4::CompiledData::JSClass) + j * sizeof(QV4::CompiledData::JSClassMember);
+            const quint32 nameOffset = members[j].nameOffset;
+            const quint32 isAccessor = members[j].isAccessor;
+            for (int target = 0; target < TargetCount; ++target)
+                setWord(target, offset, isBigEndian(target) ? nameOffset << 1 | isAccessor : nameOffset | isAccessor << 31);
+        }
+    }
+}
+
+void UnitDataWriter::writeBindings()
+{
+    for (quint32 i = 0; i < unit->nObjects; ++i) {
+        const QV4::CompiledData::Object *object = unit->objectAt(i);
+        const quint32 objectOffset = reinterpret_cast<const char *>(object) - data;
+        for (quint32 j = 0; j < object->nBindings; ++j) {
+            const QV4::CompiledData::Binding *binding = object->bindingTable() + j;
+            const quint32 offset = objectOffset + object->offsetToBindings + j * sizeof(QV4::CompiledData::Binding);
+            // flags and type share the word after propertyNameIndex.
+            setHalfWords(offset + sizeof(quint32), binding->flags, binding->type);
+
+            const quint32 valueOffset = offset + offsetof(QV4::CompiledData::Binding, value);
+            if (binding->type == QV4::CompiledData::Binding::Type_Boolean) {
+                setBytes(valueOffset, sizeof(binding->value));
+            } else if (binding->type == QV4::CompiledData::Binding::Type_Number) {
+                quint64 bits;
+                memcpy(&bits, &binding->value.d, sizeof(bits));
+                for (int target = 0; target < TargetCount; ++target)
+                    setQuint64(target, valueOffset, bits);
+            }
+        }
+    }
+}
+
+static bool storeUnit(const QString &fileName, const QUrl &url, bool isQml,
+                      QV4::CompiledData::CompilationUnit *unit, QList<CompiledUnit> *units)
+{
+    CompiledUnit compiledUnit;
+    compiledUnit.resourcePath = urlToLocalFileOrQrc(url);
+    compiledUnit.isQml = isQml;
+    // The data is static in the generated source.
+    unit->data->flags |= QV4::CompiledData::Unit::StaticData;
+    if (!UnitDataWriter(unit->data, compiledUnit.unitData).write()
+            || !static_cast<QV4::Moth::CompilationUnit *>(unit)->savePortableCode(&compiledUnit.code)) {
+        fprintf(stderr, "%s: cannot store the compiled code\n", qPrintable(QDir::toNativeSeparators(fileName)));
+        return false;
+    }
+    units->append(compiledUnit);
+    return true;
+}
+
+// Does what QQmlTypeData::saveToDiskCache does: the functions and bindings are compiled with
+// run-time name lookups only, and the type compiler restores the document with QmlIR::IRLoader.
+// There is no engine here, so assignments to the names that QV8Engine::illegalNames() protects are
+// only reported when the document is loaded from its source.
+static bool compileQml(const QString &fileName, const QUrl &url, QList<CompiledUnit> *units)
+{
+    QString source;
+    if (!readSource(fileName, &source))
+        return false;
+
+    const QString urlString = url.toString();
+    QmlIR::Document document(/*debugMode*/false);
+    QmlIR::IRBuilder builder((QSet<QString>()));
+    if (!builder.generateFromQml(source, urlString, &document)) {
+        foreach (const QQmlJS::DiagnosticMessage &message, builder.errors)
+            printError(fileName, message.loc.startLine, message.loc.startColumn, message.message);
+        return false;
+    }
+    document.registerScriptBindingSources();
+
+    QmlIR::JSCodeGen codeGen(urlString, document.code, &document.jsModule, &document.jsParserEngine, document.program, /*imports*/0, &document.jsGenerator.stringTable);
+    if (!codeGen.generateCodeWithoutTypes(document.objects)) {
+        foreach (const QQmlJS::DiagnosticMessage &message, codeGen.errors())
+            printError(fileName, message.loc.startLine, message.loc.startColumn, message.message);
+        return false;
+    }
+
+    QV4::Moth::InstructionSelection isel(/*qmlEngine*/0, /*execAllocator*/0, &document.jsModule, &document.jsGenerator);
+    isel.setUseFastLookups(false);
+    isel.setUseTypeInference(true);
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit = isel.compile(/*generate unit data*/false);
+    document.javaScriptCompilationUnit = unit;
+
+    QmlIR::QmlUnitGenerator generator;
+    unit->data = generator.generate(document);
+    return storeUnit(fileName, url, /*isQml*/true, unit.data(), units);
+}
+
+// Does what QQmlScriptBlob does with the source of a script, like QV4::Script::precompile, which
+// needs an engine.
+static bool compileScript(const QString &fileName, const QUrl &url, QList<CompiledUnit> *units)
+{
+    QString source;
+    if (!readSource(fileName, &source))
+        return false;
+
+    QmlIR::Document document(/*debugMode*/false);
+    QmlIR::ScriptDirectivesCollector collector(&document.jsParserEngine, &document.jsGenerator);
+
+    QQmlJS::Engine engine;
+    engine.setDirectives(&collector);
+    QQmlJS::Lexer lexer(&engine);
+    lexer.setCode(source, /*line*/1, /*qml mode*/false);
+    QQmlJS::Parser parser(&engine);
+    parser.parseProgram();
+
+    bool success = true;
+    foreach (const QQmlJS::DiagnosticMessage &message, parser.diagnosticMessages()) {
+        if (message.isWarning()) {
+            printError(fileName, message.loc.startLine, message.loc.startColumn,
+                       QLatin1String("warning: ") + message.message);
+            continue;
+        }
+        printError(fileName, message.loc.startLine, message.loc.startColumn, message.message);
+        success = false;
+    }
+    if (!success)
+        return false;
+
+    QQmlJS::AST::Program *program = QQmlJS::AST::cast<QQmlJS::AST::Program *>(parser.rootNode());
+    if (!program) // Nothing to compile, the script is loaded at run time.
+        return true;
+
+    QQmlJS::Codegen codeGen(/*strict mode*/false);
+    codeGen.generateFromProgram(url.toString(), source, program, &document.jsModule, QQmlJS::Codegen::EvalCode);
+    if (!codeGen.errors().isEmpty()) {
+        foreach (const QQmlJS::DiagnosticMessage &message, codeGen.errors())
+            printError(fileName, message.loc.startLine, message.loc.startColumn, message.message);
+        return false;
+    }
+
+    QV4::Moth::InstructionSelection isel(/*qmlEngine*/0, /*execAllocator*/0, &document.jsModule, &document.jsGenerator);
+    isel.setUseFastLookups(false);
+    QQmlRefPointer<QV4::CompiledData::CompilationUnit> unit = isel.compile(/*generate unit data*/false);
+
+    document.javaScriptCompilationUnit = unit;
+    document.imports = collector.imports;
+    if (collector.hasPragmaLibrary)
+        document.unitFlags |= QV4::CompiledData::Unit::IsSharedLibrary;
+
+    QmlIR::QmlUnitGenerator generator;
+    unit->data = generator.generate(document);
+    return storeUnit(fileName, url, /*isQml*/false, unit.data(), units);
+}
+
+static QByteArray hexNumber(quint32 number)
+{
+    return "0x" + QByteArray::number(number, 16);
+}
+
+static void writeArray(QByteArray *out, const QByteArray &declaration, const QVector<QByteArray> &elements)
+{
+    out->append(declaration);
+    out->append(" = {");
+    int column = 0;
+    foreach (const QByteArray &element, elements) {
+        if (column == 0 || column + element.size() > 100) {
+            out->append("\n    ");
+            column = 4;
+        } else {
+            out->append(' ');
+            ++column;
+        }
+        out->append(element);
+        out->append(',');
+        column += element.size() + 1;
+    }
+    out->append("\n};\n\n");
+}
+
+static QVector<QByteArray> unitElements(const CompiledUnit &unit)
+{
+    QVector<QByteArray> elements;
+    elements.reserve(unit.unitData[0].size());
+    for (int i = 0; i < unit.unitData[0].size(); ++i) {
+        const quint32 littleEndian64 = unit.unitData[LittleEndian64].at(i);
+        const quint32 bigEndian64 = unit.unitData[BigEndian64].at(i);
+        const quint32 littleEndian32 = unit.unitData[LittleEndian32].at(i);
+        const quint32 bigEndian32 = unit.unitData[BigEndian32].at(i);
+        if (littleEndian64 == bigEndian64 && littleEndian64 == littleEndian32 && littleEndian64 == bigEndian32) {
+            elements.append(hexNumber(littleEndian64));
+        } else if (littleEndian64 == littleEndian32 && bigEndian64 == bigEndian32) {
+            elements.append("QMLCACHE_ENDIAN(" + hexNumber(littleEndian64) + ", " + hexNumber(bigEndian64) + ")");
+        } else {
+            elements.append("QMLCACHE_TARGET(" + hexNumber(littleEndian64) + ", " + hexNumber(bigEndian64) + ", "
+                            + hexNumber(littleEndian32) + ", " + hexNumber(bigEndian32) + ")");
+        }
+    }
+    return elements;
+}
+
+static QVector<QByteArray> codeElements(const CompiledUnit &unit)
+{
+    QVector<QByteArray> elements;
+    elements.reserve(unit.code.size());
+    foreach (quint32 word, unit.code)
+        elements.append(hexNumber(word));
+    return elements;
+}
+
+static QByteArray generateSource(const QList<CompiledUnit> &units)
+{
+    QByteArray out;
+    out.append("// This file was generated by qmlcachegen. Do not edit.\n\n");
+    if (units.isEmpty())
+        return out;
+
+    out.append("#include <QtCore/qhash.h>\n"
+               "#include <QtCore/qurl.h>\n"
+               "#include <QtQml/qqmlfile.h>\n"
+               "#include <QtQml/qqmlprivate.h>\n"
+               "#include <private/qqmlirbuilder_p.h>\n"
+               "#include <private/qv4isel_moth_p.h>\n\n"
+               "// The unit data depends on the byte order and the pointer size of the target.\n"
+               "#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN\n"
+               "#  define QMLCACHE_ENDIAN(le, be) le\n"
+               "#  if QT_POINTER_SIZE == 8\n"
+               "#    define QMLCACHE_TARGET(le64, be64, le32, be32) le64\n"
+               "#  else\n"
+               "#    define QMLCACHE_TARGET(le64, be64, le32, be32) le32\n"
+               "#  endif\n"
+               "#else\n"
+               "#  define QMLCACHE_ENDIAN(le, be) be\n"
+               "#  if QT_POINTER_SIZE == 8\n"
+               "#    define QMLCACHE_TARGET(le64, be64, le32, be32) be64\n"
+               "#  else\n"
+               "#    define QMLCACHE_TARGET(le64, be64, le32, be32) be32\n"
+               "#  endif\n"
+               "#endif\n\n"
+               "namespace {\n\n");
+
+    for (int i = 0; i < units.count(); ++i) {
+        const CompiledUnit &unit = units.at(i);
+        const QByteArray index = QByteArray::number(i);
+        out.append("// " + unit.resourcePath.toUtf8() + "\n");
+        writeArray(&out, "Q_DECL_ALIGN(8) const quint32 unit_" + index + "[]", unitElements(unit));
+        writeArray(&out, "const quint32 code_" + index + "[]", codeElements(unit));
+        out.append("QV4::CompiledData::CompilationUnit *createUnit_" + index + "()\n"
+                   "{\n"
+                   "    return QV4::Moth::CompilationUnit::createForStaticData(reinterpret_cast<const QV4::CompiledData::Unit *>(unit_" + index + "),\n"
+                   "                                                           code_" + index + ", int(sizeof(code_" + index + ") / sizeof(code_" + index + "[0])));\n"
+                   "}\n\n");
+        if (unit.isQml) {
+            out.append("void loadIR_" + index + "(QmlIR::Document *document, const QQmlPrivate::CachedQmlUnit *unit)\n"
+                       "{\n"
+                       "    QmlIR::IRLoader(unit->qmlData, document).load();\n"
+                       "    // The type compiler only resolves types then, and keeps the code.\n"
+                       "    document->javaScriptCompilationUnit.adopt(unit->createCompilationUnit());\n"
+                       "}\n\n");
+        }
+    }
+
+    out.append("const QQmlPrivate::CachedQmlUnit cachedUnits[] = {\n");
+    for (int i = 0; i < units.count(); ++i) {
+        const QByteArray index = QByteArray::number(i);
+        out.append("    { reinterpret_cast<const QV4::CompiledData::Unit *>(unit_" + index + "), &createUnit_" + index + ", "
+                   + (units.at(i).isQml ? "&loadIR_" + index : QByteArray("0")) + " },\n");
+    }
+    out.append("};\n\n");
+
+    out.append("const char * const resourcePaths[] = {\n");
+    foreach (const CompiledUnit &unit, units)
+        out.append("    \"" + unit.resourcePath.toUtf8() + "\",\n");
+    out.append("};\n\n");
+
+    out.append("typedef QHash<QString, const QQmlPrivate::CachedQmlUnit *> CachedUnitHash;\n"
+               "Q_GLOBAL_STATIC(CachedUnitHash, cachedUnitHash)\n\n"
+               "const QQmlPrivate::CachedQmlUnit *lookupCachedUnit(const QUrl &url)\n"
+               "{\n"
+               "    return cachedUnitHash()->value(QQmlFile::urlToLocalFileOrQrc(url));\n"
+               "}\n\n"
+               "int registerCachedUnits()\n"
+               "{\n"
+               "    // The code of all units was generated by the same build, one is enough to check.\n"
+               "    if (!QV4::Moth::CompilationUnit::isCompatibleCode(code_0, int(sizeof(code_0) / sizeof(code_0[0]))))\n"
+               "        return 0;\n"
+               "    for (int i = 0; i < int(sizeof(cachedUnits) / sizeof(cachedUnits[0])); ++i)\n"
+               "        cachedUnitHash()->insert(QString::fromUtf8(resourcePaths[i]), &cachedUnits[i]);\n"
+               "    QQmlPrivate::RegisterQmlUnitCacheHook hook = { 0, &lookupCachedUnit };\n"
+               "    QQmlPrivate::qmlregister(QQmlPrivate::QmlUnitCacheHookRegistration, &hook);\n"
+               "    return 0;\n"
+               "}\n"
+               "Q_CONSTRUCTOR_FUNCTION(registerCachedUnits)\n\n"
+               "} // anonymous namespace\n");
+    return out;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("qmlcachegen"));
+    QCoreApplication::setApplicationVersion(QLatin1String(QT_VERSION_STR));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Compiles the QML and JavaScript files of a QML application ahead of time into a C++ source "
+        "that registers them with the QML engine."));
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption outputOption(QStringList() << QStringLiteral("o") << QStringLiteral("output"),
+                                    QStringLiteral("Write the generated source to <file>."), QStringLiteral("file"));
+    parser.addOption(outputOption);
+    QCommandLineOption prefixOption(QStringLiteral("prefix"),
+                                    QStringLiteral("URL under which the files are loaded at run time (default: qrc:/)."),
+                                    QStringLiteral("url"), QStringLiteral("qrc:/"));
+    parser.addOption(prefixOption);
+    QCommandLineOption rootOption(QStringLiteral("root"),
+                                  QStringLiteral("Directory the URLs of the files are relative to (default: the current directory)."),
+                                  QStringLiteral("directory"), QStringLiteral("."));
+    parser.addOption(rootOption);
+    parser.addPositionalArgument(QStringLiteral("files"), QStringLiteral("QML and JavaScript files, or directories to search for them."));
+    parser.process(app);
+
+    if (parser.positionalArguments().isEmpty() || !parser.isSet(outputOption))
+        parser.showHelp(1);
+
+    QString prefix = parser.value(prefixOption);
+    if (!prefix.endsWith(QLatin1Char('/')))
+        prefix += QLatin1Char('/');
+    if (urlToLocalFileOrQrc(QUrl(prefix)).isEmpty()) {
+        fprintf(stderr, "qmlcachegen: the prefix must be a qrc: or file: URL\n");
+        return 1;
+    }
+    const QDir root(parser.value(rootOption));
+
+    QStringList fileNames;
+    const QStringList nameFilters = QStringList() << QStringLiteral("*.qml") << QStringLiteral("*.js");
+    foreach (const QString &argument, parser.positionalArguments()) {
+        if (QFileInfo(argument).isDir()) {
+            QDirIterator it(argument, nameFilters, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+                fileNames.append(it.next());
+        } else {
+            fileNames.append(argument);
+        }
+    }
+    fileNames.sort();
+
+    QList<CompiledUnit> units;
+    bool success = true;
+    foreach (const QString &fileName, fileNames) {
+        const QString relativePath = root.relativeFilePath(QFileInfo(fileName).absoluteFilePath());
+        if (relativePath.startsWith(QLatin1String("../"))) {
+            fprintf(stderr, "%s: not inside %s\n", qPrintable(QDir::toNativeSeparators(fileName)),
+                    qPrintable(QDir::toNativeSeparators(root.absolutePath())));
+            success = false;
+            continue;
+        }
+        const QUrl url(prefix + relativePath);
+        if (fileName.endsWith(QLatin1String(".js")))
+            success &= compileScript(fileName, url, &units);
+        else
+            success &= compileQml(fileName, url, &units);
+    }
+    if (!success)
+        return 1;
+
+    QSaveFile output(parser.value(outputOption));
+    if (!output.open(QIODevice::WriteOnly) || output.write(generateSource(units)) < 0 || !output.commit()) {
+        fprintf(stderr, "%s: %s\n", qPrintable(QDir::toNativeSeparators(output.fileName())), qPrintable(output.errorString()));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,8 @@
+option(host_build)
+
+QT = core qmldevtools-private
+DEFINES += QT_NO_CAST_TO_ASCII QT_NO_CAST_FROM_ASCII
+
+SOURCES += main.cpp
+
+load(qt_tool)
@@ -218,6 +218,9 @@ void QmlProfilerClient::messageReceived(const QByteArray &data)
         qint64 delta;
         stream >> type >> delta;
         emit memoryAllocation((QQmlProfilerDefinitions::MemoryType)type, time, delta);
+    } else if (messageType == QQmlProfilerDefinitions::GarbageCollection) {
+        // Not part of the trace file format (yet).
+        return;
     } else {
         int range;
         stream >> range;
@@ -1,10 +1,12 @@
 TEMPLATE = subdirs
 SUBDIRS += \
     qmlmin \
-    qmlimportscanner
+    qmlimportscanner \
+    qmlcachegen
 
 qmlmin.CONFIG = host_build
 qmlimportscanner.CONFIG = host_build
+qmlcachegen.CONFIG = host_build
 
 !android|android_app {
     SUBDIRS += \
@@ -22,7 +24,7 @@ qmlimportscanner.CONFIG = host_build
 qml.depends = qmlimportscanner
 qmleasing.depends = qmlimportscanner
 
-# qmlmin, qmlimportscanner & qmlbundle are build tools.
+# qmlmin, qmlimportscanner, qmlcachegen & qmlbundle are build tools.
 # qmlscene is needed by the autotests.
 # qmltestrunner may be useful for manual testing.
 # qmlplugindump cannot be a build tool, because it loads target plugins.